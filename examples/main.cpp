@@ -1,9 +1,17 @@
 #include "memory/mem_access.h"
 #include "memory/mem_map.h"
+#include "memory/process_snapshot.h"
+#include "memory/snapshot_diff.h"
 #include "scanner/scanner.h"
+#include "scanner/rescanner.h"
+#include "scanner/chain_watcher.h"
 #include "common/cmd_parser.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
 #include <memory>
+#include <thread>
 #include <vector>
 
 using namespace memchainer;
@@ -14,7 +22,7 @@ int main(int argc, char *argv[])
     CommandLineParser parser("MemoryChainer", "高性能内存指针链分析工具");
 
     // 添加命令行选项
-    parser.addOption({'p', "process", "目标进程名称或PID", true, true});
+    parser.addOption({'p', "process", "目标进程名称或PID", true, false});
     parser.addOption({'a', "address", "目标地址(16进制，不带0x前缀)", true, false});
     parser.addOption({'d', "depth", "最大搜索深度", true, false, "10"});
     parser.addOption({'o', "offset", "最大偏移量", true, false, "500"});
@@ -26,9 +34,28 @@ int main(int argc, char *argv[])
     parser.addOption({'c', "cache-dir", "缓存文件目录", true, false, ""});
     parser.addOption({'b', "batch-size", "扫描批次大小", true, false, "10000"});
     parser.addOption({'s', "smart-filter", "使用智能内存区域过滤", false, false});
+    parser.addOption({'\0', "no-dedup", "关闭指针链去重", false, false});
+    parser.addOption({'m', "memory-budget", "指针表内存预算(MB)，超出后写入磁盘缓存，0为不限制", true, false, "0"});
+    parser.addOption({'z', "compress", "结果文件压缩方式(none/fast/zlib)", true, false, "none"});
+    parser.addOption({'r', "rescan", "重扫描模式: 用已有结果文件(文本/二进制)过滤新进程中的指针链", true, false});
+    parser.addOption({'w', "watch", "监视模式: 持续解析结果文件中的指针链并输出变化", true, false});
+    parser.addOption({'\0', "watch-count", "监视的指针链数量(取文件前N条)", true, false, "100"});
+    parser.addOption({'\0', "watch-hz", "监视频率(次/秒)", true, false, "60"});
+    parser.addOption({'\0', "watch-time", "监视时长(秒，0表示一直运行)", true, false, "10"});
+    parser.addOption({'\0', "save-table", "收集指针后保存指针表快照", true, false});
+    parser.addOption({'\0', "load-table", "加载指针表快照代替重新收集指针", true, false});
+    parser.addOption({'\0', "snapshot", "采集进程快照到文件后退出", true, false});
+    parser.addOption({'\0', "from-snapshot", "从进程快照文件离线扫描(代替-p)", true, false});
+    parser.addOption({'\0', "self", "扫描本进程(代替-p，进程内直接读取内存，用于测试和基准)", false, false});
+    parser.addOption({'\0', "diff", "与指定的旧快照比较(新数据来自-p或--from-snapshot)并输出变化后退出", true, false});
+    parser.addOption({'\0', "diff-type", "比较的数值类型(i8/i16/i32/i64/f32/f64)", true, false, "i32"});
+    parser.addOption({'\0', "diff-out", "数值变化输出文件", true, false, "snapshot_diff.txt"});
+    parser.addOption({'\0', "resident-only", "读取 smaps，跳过没有驻留页的内存区域", false, false});
+    parser.addOption({'\0', "buildid-keys", "静态区域按 文件名@构建ID 命名，偏移相对模块加载基址", false, false});
+    parser.addOption({'\0', "allow-stale", "PID或内存映射变化时仍加载指针表快照", false, false});
 
     // 设置用法说明
-    parser.setUsage("[选项] -p <进程名/PID> [-a <地址>]");
+    parser.setUsage("[选项] -p <进程名/PID>|--from-snapshot <文件>|--self [-a <地址>]");
 
     // 解析命令行参数
     if (!parser.parse(argc, argv))
@@ -45,64 +72,262 @@ int main(int argc, char *argv[])
         return 0;
     }
 
-    // 创建内存访问对象
-    auto memAccess = std::make_shared<AndroidMemoryAccess>();
+    bool verboseMode = parser.getBoolOption("verbose");
 
-    // 获取目标进程
-    std::string targetProcess = parser.getOptionValue("process");
-    ProcessId targetPid = -1;
+    std::shared_ptr<MemoryAccess> memAccess;
+    auto memMap = std::make_shared<MemoryMap>();
 
-    // 尝试解析进程ID
-    try
+    if (parser.hasOption("from-snapshot"))
     {
-        targetPid = std::stoi(targetProcess);
-    }
-    catch (...)
-    {
-        // 不是数字，认为是进程名
-        targetPid = -1;
+        // 离线模式：内存读取和内存映射都来自快照文件
+        std::string snapshotFile = parser.getOptionValue("from-snapshot");
+        auto snapshotAccess = std::make_shared<SnapshotMemoryAccess>();
+        if (!snapshotAccess->open(snapshotFile) ||
+            !snapshotAccess->getSnapshot().restoreMemoryMap(*memMap))
+        {
+            std::cerr << "无法加载进程快照: " << snapshotFile << std::endl;
+            return 1;
+        }
+        std::cout << "使用进程快照: " << snapshotFile << "，采集时进程ID: "
+                  << snapshotAccess->getTargetProcessId() << std::endl;
+        memAccess = snapshotAccess;
     }
-
-    // 设置目标进程
-    bool success = false;
-    if (targetPid > 0)
+    else if (parser.hasOption("self"))
     {
-        success = memAccess->setTargetProcess(targetPid);
+        // 扫描自身：直接读取本进程地址空间，不需要权限和系统调用
+        memAccess = std::make_shared<LocalMemoryAccess>();
     }
     else
     {
-        success = memAccess->setTargetProcess(targetProcess);
+        if (!parser.hasOption("process"))
+        {
+            std::cerr << "错误: 需要指定目标进程(-p)、进程快照(--from-snapshot)或扫描自身(--self)" << std::endl;
+            parser.showHelp();
+            return 1;
+        }
+
+        // 创建内存访问对象
+        auto androidAccess = std::make_shared<AndroidMemoryAccess>();
+
+        // 获取目标进程
+        std::string targetProcess = parser.getOptionValue("process");
+        ProcessId targetPid = -1;
+
+        // 尝试解析进程ID
+        try
+        {
+            targetPid = std::stoi(targetProcess);
+        }
+        catch (...)
+        {
+            // 不是数字，认为是进程名
+            targetPid = -1;
+        }
+
+        // 设置目标进程
+        bool success = false;
+        if (targetPid > 0)
+        {
+            success = androidAccess->setTargetProcess(targetPid);
+        }
+        else
+        {
+            success = androidAccess->setTargetProcess(targetProcess);
+        }
+
+        if (!success)
+        {
+            std::cerr << "无法找到目标进程: " << targetProcess << std::endl;
+            return 1;
+        }
+        memAccess = androidAccess;
     }
 
-    if (!success)
+    if (!parser.hasOption("from-snapshot"))
     {
-        std::cerr << "无法找到目标进程: " << targetProcess << std::endl;
-        return 1;
+        //if (verboseMode)
+        {
+            std::cout << "目标进程ID: " << memAccess->getTargetProcessId() << std::endl;
+        }
+
+        // 创建并加载内存映射
+        memMap->setResidentFilter(parser.hasOption("resident-only"));
+        if (!memMap->loadMemoryMap(memAccess->getTargetProcessId()))
+        {
+            std::cerr << "无法加载进程内存映射" << std::endl;
+            return 1;
+        }
+
+        // 设置要扫描的内存区域类型
+        memMap->setRegionFilter(
+            Anonymous |
+            C_alloc |
+            C_bss |
+            C_data);
+        if (parser.hasOption("smart-filter"))
+        {
+            memMap->applySmartFilter();
+        }
+        
+        // 加载模块信息
+        memMap->setBuildIdKeys(parser.hasOption("buildid-keys"));
+        memMap->parseProcessModule();
+        std::cout << "已解析 ELF 模块: " << memMap->getModules().size()
+                  << "，静态区域: " << memMap->getStaticRegions().size() << std::endl;
+
+        if (memMap->isSmartFilterEnabled() || memMap->getResidentFilter())
+        {
+            memMap->getFilteredRegions();
+            memMap->printFilterStats();
+        }
+
+        // 快照采集模式：保存扫描区域和内存映射后退出
+        if (parser.hasOption("snapshot"))
+        {
+            std::string snapshotFile = parser.getOptionValue("snapshot");
+            if (!ProcessSnapshot::capture(snapshotFile, *memAccess, *memMap))
+            {
+                std::cerr << "采集进程快照失败: " << snapshotFile << std::endl;
+                return 1;
+            }
+            std::cout << "进程快照已保存到: " << snapshotFile << std::endl;
+            return 0;
+        }
     }
 
-    bool verboseMode = parser.getBoolOption("verbose");
-    //if (verboseMode)
+    // 差异模式：比较旧快照与当前数据（实时进程或另一个快照）
+    if (parser.hasOption("diff"))
     {
-        std::cout << "目标进程ID: " << memAccess->getTargetProcessId() << std::endl;
+        std::string beforeFile = parser.getOptionValue("diff");
+        ProcessSnapshot before;
+        if (!before.open(beforeFile))
+        {
+            std::cerr << "无法加载进程快照: " << beforeFile << std::endl;
+            return 1;
+        }
+
+        DiffOptions diffOptions;
+        if (!SnapshotDiff::parseType(parser.getOptionValue("diff-type", "i32"), diffOptions.valueType))
+        {
+            std::cerr << "不支持的数值类型: " << parser.getOptionValue("diff-type") << std::endl;
+            return 1;
+        }
+
+        DiffResult diffResult;
+        auto snapshotAccess = std::dynamic_pointer_cast<SnapshotMemoryAccess>(memAccess);
+        bool diffOk = snapshotAccess
+            ? SnapshotDiff::diff(before, snapshotAccess->getSnapshot(), diffOptions, diffResult)
+            : SnapshotDiff::diff(before, *memAccess, diffOptions, diffResult);
+        if (!diffOk)
+        {
+            std::cerr << "快照比较失败" << std::endl;
+            return 1;
+        }
+
+        const DiffStats& stats = diffResult.stats;
+        printf("比较完成: %zu 个区域(新增 %zu, 消失 %zu), 跳过相同页 %zu, 比较页 %zu, 变化页 %zu, 缺失页 %zu, 耗时 %lld ms\n",
+               stats.regions, stats.regionsAdded, stats.regionsRemoved, stats.pagesSkipped,
+               stats.pagesCompared, stats.pagesChanged, stats.pagesMissing, stats.elapsedMs);
+        printf("变化范围 %zu 个, 共 %llu 字节, 变化数值 %zu 个\n", diffResult.ranges.size(),
+               static_cast<unsigned long long>(stats.bytesChanged), stats.deltaCount);
+
+        std::string diffFile = parser.getOptionValue("diff-out", "snapshot_diff.txt");
+        FILE* out = fopen(diffFile.c_str(), "w");
+        if (!out)
+        {
+            std::cerr << "无法创建输出文件: " << diffFile << std::endl;
+            return 1;
+        }
+        for (const auto& delta : diffResult.deltas)
+        {
+            fprintf(out, "0x%llx %s -> %s (%+g)\n", static_cast<unsigned long long>(delta.address),
+                    SnapshotDiff::formatValue(diffOptions.valueType, delta.oldBits).c_str(),
+                    SnapshotDiff::formatValue(diffOptions.valueType, delta.newBits).c_str(),
+                    SnapshotDiff::deltaValue(diffOptions.valueType, delta));
+        }
+        fclose(out);
+        std::cout << "数值变化已保存到: " << diffFile << std::endl;
+        return 0;
     }
 
-    // 创建并加载内存映射
-    auto memMap = std::make_shared<MemoryMap>();
-    if (!memMap->loadMemoryMap(memAccess->getTargetProcessId()))
+    // 监视模式：持续解析已有指针链，不需要目标地址
+    if (parser.hasOption("watch"))
     {
-        std::cerr << "无法加载进程内存映射" << std::endl;
-        return 1;
-    }
+        std::string inputFile = parser.getOptionValue("watch");
+        ChainSet chains;
+        if (!chains.loadFromFile(inputFile) || chains.empty())
+        {
+            std::cerr << "无法加载指针链文件: " << inputFile << std::endl;
+            return 1;
+        }
 
-    // 设置要扫描的内存区域类型
-    memMap->setRegionFilter(
-        Anonymous |
-        C_alloc |
-        C_bss |
-        C_data);
-    
-    // 加载模块信息
-    memMap->parseProcessModule();
+        size_t count = std::min<size_t>(chains.size(), std::max(0, parser.getIntOption("watch-count", 100)));
+        int hz = parser.getIntOption("watch-hz", 60);
+        int seconds = parser.getIntOption("watch-time", 10);
+
+        std::vector<uint32_t> indices(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            indices[i] = static_cast<uint32_t>(i);
+        }
+
+        ChainWatcher watcher;
+        watcher.initialize(memAccess, memMap);
+        if (!watcher.watch(chains, indices))
+        {
+            std::cerr << "初始化监视器失败" << std::endl;
+            return 1;
+        }
+
+        watcher.setCallback([&chains](const std::vector<ChainChangeEvent>& events) {
+            for (const auto& event : events)
+            {
+                printf("[%llu] %s: 0x%llx(0x%llx) -> 0x%llx(0x%llx)%s\n",
+                       (unsigned long long)event.tick, chains.formatChain(event.chainIndex).c_str(),
+                       (unsigned long long)event.oldAddress, (unsigned long long)event.oldValue,
+                       (unsigned long long)event.newAddress, (unsigned long long)event.newValue,
+                       event.isValid ? "" : " [失效]");
+            }
+        });
+
+        std::cout << "开始监视 " << count << " 条指针链，频率 " << hz << " Hz" << std::endl;
+        if (!watcher.start(hz))
+        {
+            std::cerr << "无效的监视频率: " << hz << std::endl;
+            return 1;
+        }
+
+        if (seconds > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::seconds(seconds));
+        }
+        else
+        {
+            while (true)
+            {
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+            }
+        }
+        watcher.stop();
+
+        WatchStats stats = watcher.getStats();
+        std::vector<ChainStability> stability = watcher.getStability();
+        size_t stableChains = 0;
+        for (const auto& s : stability)
+        {
+            if (s.changeCount == 0 && s.invalidTicks == 0)
+            {
+                stableChains++;
+            }
+        }
+
+        std::cout << "\n========== 监视结束 ==========" << std::endl;
+        std::cout << "轮次: " << stats.ticks << " (全量刷新 " << stats.fullRefreshes << ")" << std::endl;
+        std::cout << "平均每轮读取: " << (stats.ticks ? stats.totalReads / stats.ticks : 0) << std::endl;
+        std::cout << "变化事件: " << stats.totalEvents << std::endl;
+        std::cout << "始终稳定的指针链: " << stableChains << "/" << count << std::endl;
+        return 0;
+    }
 
     // 创建扫描器
     auto scanner = std::make_shared<PointerScanner>();
@@ -118,6 +343,17 @@ int main(int argc, char *argv[])
     options.maxOffset = parser.getIntOption("offset", 500);
     options.threadCount = parser.getIntOption("threads", 4);
 
+    options.dedupChains = !parser.hasOption("no-dedup");
+    options.memoryBudget = static_cast<size_t>(std::max(0, parser.getIntOption("memory-budget", 0))) * 1024 * 1024;
+    options.cacheDir = parser.getOptionValue("cache-dir", "");
+
+    if (!BlockCompressor::parseType(parser.getOptionValue("compress", "none"), options.outputCompression) ||
+        !BlockCompressor::isAvailable(options.outputCompression))
+    {
+        std::cerr << "不支持的压缩方式: " << parser.getOptionValue("compress") << std::endl;
+        return 1;
+    }
+
     int limit = parser.getIntOption("limit", 0);
     if (limit > 0)
     {
@@ -130,6 +366,10 @@ int main(int argc, char *argv[])
     std::cout << "搜索深度: " << options.maxDepth << std::endl;
     std::cout << "最大偏移量: " << options.maxOffset << std::endl;
     std::cout << "线程数量: " << options.threadCount << std::endl;
+    if (options.memoryBudget > 0)
+    {
+        std::cout << "内存预算: " << (options.memoryBudget / 1024 / 1024) << " MB" << std::endl;
+    }
     if (options.limitResults)
     {
         std::cout << "结果限制数量: " << options.resultLimit << std::endl;
@@ -178,11 +418,66 @@ int main(int argc, char *argv[])
         }
     }
 
-    std::cout << "开始扫描潜在指针..." << std::endl;
-    scanner->findPointers();
-    
     // 获取输出文件名
     std::string outputFile = parser.getOptionValue("file", "pointer_chains.txt");
+
+    // 重扫描模式：只验证已有指针链，不重新扫描
+    if (parser.hasOption("rescan"))
+    {
+        std::string inputFile = parser.getOptionValue("rescan");
+        ChainSet previous;
+        if (!previous.loadFromFile(inputFile))
+        {
+            std::cerr << "无法加载指针链文件: " << inputFile << std::endl;
+            return 1;
+        }
+        std::cout << "已加载 " << previous.size() << " 条指针链: " << inputFile << std::endl;
+
+        PointerRescanner rescanner;
+        rescanner.initialize(memAccess, memMap);
+
+        ChainSet surviving;
+        size_t kept = rescanner.rescan(previous, targetAddresses[0], surviving);
+
+        bool saved = false;
+        if (outputFile.size() > 4 && outputFile.compare(outputFile.size() - 4, 4, ".bin") == 0)
+        {
+            saved = surviving.saveBinary(outputFile);
+        }
+        else
+        {
+            saved = surviving.saveText(outputFile, options.outputCompression);
+        }
+        if (!saved)
+        {
+            std::cerr << "保存结果失败: " << outputFile << std::endl;
+            return 1;
+        }
+
+        std::cout << "\n重扫描完成！保留 " << kept << " 条指针链" << std::endl;
+        std::cout << "结果已保存到: " << outputFile << std::endl;
+        return kept > 0 ? 0 : 1;
+    }
+
+    if (parser.hasOption("load-table"))
+    {
+        std::string tableFile = parser.getOptionValue("load-table");
+        if (!scanner->loadPointerTable(tableFile, parser.hasOption("allow-stale")))
+        {
+            std::cerr << "无法加载指针表快照: " << tableFile << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << "开始扫描潜在指针..." << std::endl;
+        scanner->findPointers(options);
+
+        if (parser.hasOption("save-table"))
+        {
+            scanner->savePointerTable(parser.getOptionValue("save-table"));
+        }
+    }
     
     // 执行扫描（边扫边输出模式）
     std::cout << "\n开始深度搜索指针链..." << std::endl;
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace memchainer {
+
+// 压缩算法类型
+enum class CompressionType : uint8_t {
+    None = 0,   // 不压缩
+    Fast = 1,   // 内置LZ4风格快速压缩
+    Zlib = 2    // zlib（编译时检测到 MEMCHAINER_HAVE_ZLIB 才可用）
+};
+
+/**
+ * @brief 数据块压缩工具
+ *
+ * 每个数据块独立压缩/解压，不依赖前后块的内容，
+ * 便于读取端按帧随机访问和并行解码。
+ */
+class BlockCompressor {
+public:
+    // 检查压缩算法是否可用
+    static bool isAvailable(CompressionType type);
+
+    // 从字符串解析压缩算法（"none" / "fast" / "lz4" / "zlib"）
+    static bool parseType(const std::string& name, CompressionType& type);
+
+    // 获取压缩算法名称
+    static const char* typeName(CompressionType type);
+
+    // 压缩后可能的最大长度
+    static size_t maxCompressedSize(CompressionType type, size_t rawSize);
+
+    // 压缩数据块，结果写入 out（覆盖原内容）
+    static bool compress(CompressionType type, const uint8_t* src, size_t srcSize,
+                         std::vector<uint8_t>& out);
+
+    // 解压数据块，rawSize 必须是压缩前的原始长度
+    static bool decompress(CompressionType type, const uint8_t* src, size_t srcSize,
+                           uint8_t* dst, size_t rawSize);
+
+private:
+    // 内置快速压缩实现（LZ4块格式）
+    static size_t fastCompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity);
+    static bool fastDecompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t rawSize);
+};
+
+} // namespace memchainer
@@ -7,6 +7,7 @@
 #include <list>
 #include <algorithm>
 #include <cstring>
+#include <sys/mman.h>
 
 namespace memchainer {
 
@@ -16,6 +17,11 @@ using Offset = int32_t;
 using MemorySize = uint64_t;
 using ProcessId = int32_t;
 
+// 区域编号：MemoryMap 区域表中的下标（按起始地址排序），每次加载内存映射后重新分配
+using RegionId = uint16_t;
+constexpr RegionId INVALID_REGION_ID = 0xFFFF;
+constexpr size_t MAX_REGION_COUNT = INVALID_REGION_ID; // Android 默认 max_map_count 为 65530
+
 // 内存区域类型枚举 - 修改为 enum 而不是 enum class，与原项目保持一致
 enum MemoryRegionType : int {
     All = -1,
@@ -46,9 +52,15 @@ struct MemoryRegion {
     int count;          // 用于区分同名区域
     char name[128];      // 固定大小的名称
     bool isFilterable;  // 是否可过滤
-
-    MemoryRegion(Address start, Address end, int t = 0, const char* n = "", int c = 0, bool filter = false)
-        : startAddress(start), endAddress(end), type(t), count(c), isFilterable(filter) {
+    int protection;     // PROT_* 标志（来自 maps 权限；快照恢复的区域视为可读写）
+    RegionId id = INVALID_REGION_ID; // 在 MemoryMap 区域表中的编号
+    uint64_t pathHash = 0;           // maps 中原始路径的哈希（不受 parseProcessModule 改名影响），用于比较两次加载
+    uint64_t fileOffset = 0;         // maps 中的文件偏移
+    Address staticBase = 0;          // 静态偏移的基址，0 表示区域起始（按构建 ID 命名时为模块加载基址）
+
+    MemoryRegion(Address start, Address end, int t = 0, const char* n = "", int c = 0, bool filter = false,
+                 int prot = PROT_READ | PROT_WRITE)
+        : startAddress(start), endAddress(end), type(t), count(c), isFilterable(filter), protection(prot) {
         if (n) {
             strncpy(name, n, sizeof(name) - 1);
             name[sizeof(name) - 1] = '\0';
@@ -56,11 +68,9 @@ struct MemoryRegion {
             name[0] = '\0';
         }
     }
-};
 
-// 全局内存区域列表
-extern std::vector<MemoryRegion*> memoryRegionList;
-extern std::vector<MemoryRegion*> staticRegionList;
+    Address baseAddress() const { return staticBase ? staticBase : startAddress; }
+};
 
 // 指针数据结构
 struct PointerData {
@@ -75,8 +85,8 @@ struct PointerData {
 struct StaticOffset
 {
     uint64_t staticOffset; // 静态偏移量
-    MemoryRegion* region; // 内存区域
-    StaticOffset(uint64_t staticOff, MemoryRegion* reg)
+    const MemoryRegion* region; // 内存区域
+    StaticOffset(uint64_t staticOff, const MemoryRegion* reg)
         : staticOffset(staticOff), region(reg) {}
     StaticOffset()
         : staticOffset(0), region(nullptr) {}
@@ -88,9 +98,9 @@ struct StaticOffset
 struct PointerAllData {
     Address address;      // 指针地址
     Address value;        // 指针指向的值   
-    StaticOffset* staticOffset_; // 静态偏移量
+    StaticOffset staticOffset_; // 静态偏移量（不在静态区域时 region 为空）
 
-    PointerAllData(Address addr, Address val, StaticOffset* staticOff = nullptr)
+    PointerAllData(Address addr, Address val, const StaticOffset& staticOff = StaticOffset())
         : address(addr), value(val),  staticOffset_(staticOff) {}
 };
 
@@ -129,12 +139,12 @@ struct PointerChainNode {
     Address address;      // 指针地址
     Address value;        // 指针值
     Offset offset;        // 偏移量
-    StaticOffset* staticOffset; // 静态偏移量
+    StaticOffset staticOffset; // 静态偏移量
     // bool isStatic;        // 是否是静态指针
     // bool isValid;         // 是否是有效指针
 
     PointerChainNode(Address addr = 0, Address val = 0, Offset off = 0, 
-                    StaticOffset* staticOff = nullptr)
+                    const StaticOffset& staticOff = StaticOffset())
         : address(addr), value(val), offset(off), 
           staticOffset(staticOff) {}
 };
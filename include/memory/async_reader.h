@@ -0,0 +1,67 @@
+#pragma once
+
+#include "memory/mem_access.h"
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace memchainer {
+
+// 同步后端：提交时立即通过 MemoryAccess::read 读取，用于没有 io_uring 或离线数据源
+class SyncReader : public AsyncReader {
+public:
+    SyncReader(const MemoryAccess& memAccess, size_t depth);
+
+    bool submit(Address address, void* buffer, MemorySize size, uint64_t tag) override;
+    size_t reap(ReadCompletion* completions, size_t maxCount) override;
+    size_t inFlight() const override { return completed_.size(); }
+    const char* name() const override { return "sync"; }
+
+private:
+    const MemoryAccess& memAccess_;
+    size_t depth_;
+    std::deque<ReadCompletion> completed_;
+};
+
+/**
+ * @brief 基于 io_uring 的 /proc/pid/mem 读取
+ *
+ * 每个读取是一个 IORING_OP_READV 请求（兼容 5.1 内核），提交在 reap 时一次性下发，
+ * 完成项按内核完成顺序返回。读取失败或读取不完整时通过 MemoryAccess::read
+ * 重试（process_vm_readv 等原有方式），结果与同步读取一致。
+ * 队列出错后不再接受提交：尚未被内核取走的请求撤回并同步完成。已被内核取走的请求
+ * 只有取到完成项后才交还缓冲区，io_uring_enter 等待也失败时定时直接检查完成队列。
+ */
+class IoUringReader : public AsyncReader {
+public:
+    ~IoUringReader() override;
+
+    // 打开目标进程的 /proc/pid/mem 并建立队列，内核不支持或被禁止时返回空
+    static std::unique_ptr<IoUringReader> create(const MemoryAccess& memAccess, ProcessId pid, size_t depth);
+
+    bool submit(Address address, void* buffer, MemorySize size, uint64_t tag) override;
+    size_t reap(ReadCompletion* completions, size_t maxCount) override;
+    size_t inFlight() const override { return inFlight_; }
+    const char* name() const override { return "io_uring"; }
+
+private:
+    struct Slot;
+    struct Ring;
+
+    IoUringReader(const MemoryAccess& memAccess, int memFd, std::unique_ptr<Ring> ring, size_t depth);
+
+    // 撤回提交队列中尚未被内核取走的请求，放入 syncSlots_
+    void withdrawUnsubmitted();
+
+    const MemoryAccess& memAccess_;
+    int memFd_;
+    std::unique_ptr<Ring> ring_;
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> freeSlots_;
+    std::vector<uint32_t> syncSlots_; // 队列出错后撤回、改为同步读取的请求
+    size_t inFlight_ = 0;
+    unsigned toSubmit_ = 0; // 已放入提交队列、尚未下发的请求数
+    bool failed_ = false;   // io_uring_enter 出错后不再提交新请求
+};
+
+} // namespace memchainer
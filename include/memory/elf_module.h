@@ -0,0 +1,52 @@
+#pragma once
+
+#include "common/types.h"
+#include <string>
+#include <vector>
+
+namespace memchainer {
+
+// 模块中的静态数据范围（链接地址，加上 ElfModule::loadBias 即进程地址）
+struct ElfStaticRange {
+    Address start;
+    Address end;
+    int type; // C_data 或 C_bss
+};
+
+// PT_LOAD 段
+struct ElfSegment {
+    uint64_t vaddr;
+    uint64_t offset;
+    uint64_t fileSize;
+    uint64_t memSize;
+    int prot; // PROT_* 标志
+};
+
+/**
+ * @brief 从磁盘解析的 ELF 模块布局
+ *
+ * 只读取文件头、程序头、节区头、节区名表和构建 ID 注释，不读取整个文件。
+ * 静态数据取 .data/.data.rel.ro/.bss 节区；节区头被裁掉时按可写 PT_LOAD 段推算
+ * （文件内部分为 .data，超出文件大小的部分为 .bss）。支持 32 位和 64 位 ELF。
+ */
+struct ElfModule {
+    std::string path;                         // maps 中的路径
+    std::string name;                         // 文件名
+    std::string buildId;                      // NT_GNU_BUILD_ID 的十六进制，没有时为空
+    uint64_t fileOffset = 0;                  // ELF 在文件中的偏移（APK 内未解压的库不为 0）
+    Address loadBias = 0;                     // 链接地址 0 对应的进程地址
+    Address imageEnd = 0;                     // PT_LOAD 段的最大结束链接地址
+    std::vector<ElfSegment> loads;
+    std::vector<ElfStaticRange> staticRanges;
+
+    // 解析 fd 中 fileOffset 处开始的 ELF，成功时填写 loads、staticRanges 和 buildId
+    bool parse(int fd, uint64_t fileOffset);
+
+    // 按包含 ELF 偏移 mappingOffset 处、起始于 mappingStart 的映射计算加载基址
+    bool computeLoadBias(Address mappingStart, uint64_t mappingOffset, uint64_t mappingSize);
+
+    // 链接键：文件名@构建ID（没有构建 ID 时为空）
+    std::string key() const { return buildId.empty() ? std::string() : name + "@" + buildId; }
+};
+
+} // namespace memchainer
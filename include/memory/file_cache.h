@@ -1,6 +1,8 @@
 #pragma once
 
 #include "common/types.h"
+#include <atomic>
+#include <numeric>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -11,12 +13,13 @@
 
 namespace memchainer {
 
-// 范围索引条目
+// 范围索引条目（每个范围对应数据文件中的一个压缩块）
 struct RangeEntry {
-    Address startValue;        // 范围起始值
-    Address endValue;          // 范围结束值
-    int64_t fileOffset;        // 文件中的偏移
+    Address startValue;        // 范围起始值（块内最小值）
+    Address endValue;          // 范围结束值（块内最大值）
+    int64_t fileOffset;        // 压缩块在文件中的偏移
     int64_t entryCount;        // 条目数量
+    int64_t byteSize;          // 压缩块字节数
 };
 
 // 指针缓存条目
@@ -26,6 +29,93 @@ struct PointerCacheEntry {
     Offset offset;             // 偏移量
 };
 
+/**
+ * @brief 构建完成后只读的单个等级数据
+ *
+ * 有序数据文件由压缩块组成：块内条目按值排序，值存与前一条目的差值（varint），
+ * 地址存 zigzag 差值，偏移存 zigzag 值。范围索引记录每个块的最小/最大值，
+ * 查询只解码与值范围相交的块。
+ *
+ * 持有数据文件的只读映射（映射失败时用文件描述符 + pread）和范围索引，
+ * 构建后不再修改，任意数量的线程可以不加锁地并发查询。
+ */
+class FileCacheLevel {
+public:
+    FileCacheLevel(int level, std::vector<RangeEntry> rangeIndex);
+    ~FileCacheLevel();
+
+    FileCacheLevel(const FileCacheLevel&) = delete;
+    FileCacheLevel& operator=(const FileCacheLevel&) = delete;
+
+    // 打开有序数据文件
+    bool open(const std::string& filePath);
+
+    // 查找值范围内的指针，结果追加到调用方提供的缓冲区，返回追加的数量
+    size_t find(Address minValue, Address maxValue, std::vector<PointerCacheEntry>& results) const;
+
+    // 按排序后的条目下标读取单个条目
+    bool readAt(size_t index, PointerCacheEntry& entry) const;
+
+    // 按顺序解码整个块，用于遍历全部条目
+    size_t blockCount() const { return rangeIndex_.size(); }
+    bool readBlock(size_t index, std::vector<PointerCacheEntry>& results) const;
+
+    int getLevel() const { return level_; }
+    size_t size() const { return count_; }
+    size_t fileSize() const { return fileSize_; }
+    bool isMapped() const { return data_ != nullptr; }
+
+private:
+    // 通过范围索引定位与值范围相交的块区间 [first, last)
+    bool locate(Address minValue, Address maxValue, size_t& first, size_t& last) const;
+
+    // 取得块的压缩数据（映射时直接指向映射区域，否则 pread 到线程局部缓冲区）
+    const uint8_t* blockData(const RangeEntry& range) const;
+
+    int level_;
+    std::vector<RangeEntry> rangeIndex_;
+    std::vector<size_t> blockFirst_;          // 每个块首条目的下标
+    int fd_ = -1;
+    const uint8_t* data_ = nullptr;           // 只读映射
+    size_t fileSize_ = 0;
+    size_t count_ = 0;
+};
+
+class FileCache;
+
+/**
+ * @brief 指针缓存的写入端
+ *
+ * 每个线程持有自己的 CacheProducer，条目先追加到线程私有缓冲区，
+ * 满一个块（4KB 和条目大小的公倍数，约1MB）后通过原子预留的文件区间一次 pwrite 写出，
+ * 多个线程可以同时向同一等级写入而不加锁。析构时写出剩余条目。
+ */
+class CacheProducer {
+public:
+    static constexpr size_t BLOCK_ALIGN = std::lcm(sizeof(PointerCacheEntry), size_t(4096));
+    static constexpr size_t BLOCK_BYTES = BLOCK_ALIGN * ((1024 * 1024 + BLOCK_ALIGN - 1) / BLOCK_ALIGN);
+    static constexpr size_t BLOCK_ENTRIES = BLOCK_BYTES / sizeof(PointerCacheEntry);
+
+    explicit CacheProducer(FileCache* cache);
+    ~CacheProducer();
+
+    CacheProducer(const CacheProducer&) = delete;
+    CacheProducer& operator=(const CacheProducer&) = delete;
+
+    // 添加一个条目，缓冲区满时写出
+    bool add(Address address, Address value, Offset offset = 0) {
+        buffer_.push_back(PointerCacheEntry{address, value, offset});
+        return buffer_.size() < BLOCK_ENTRIES || flush();
+    }
+
+    // 写出缓冲区中的条目
+    bool flush();
+
+private:
+    FileCache* cache_;
+    std::vector<PointerCacheEntry> buffer_;
+};
+
 // 基于文件的缓存系统
 class FileCache {
 public:
@@ -34,6 +124,9 @@ public:
     
     static constexpr size_t FILE_BUFFER_SIZE = 4 * 1024 * 1024; // 4MB
     static constexpr size_t RANGE_BUCKET_SIZE = 1024 * 1024;    // 1MB
+    static constexpr size_t RANGE_MAX_ENTRIES = 256;            // 单个范围（压缩块）的最大条目数
+    static constexpr size_t MERGE_BUFFER_SIZE = 16 * 1024 * 1024; // 归并时所有有序段的读取缓冲总大小
+    static constexpr size_t MIN_RUN_ENTRIES = 64 * 1024;        // 有序段的最小条目数
     
     FileCache();
     ~FileCache();
@@ -44,14 +137,19 @@ public:
     // 开始写入新的缓存数据
     bool beginWriteCache(int level);
 
-    // 添加指针数据到缓存
+    // 添加指针数据到缓存（单线程写入；多线程写入时每个线程使用自己的 CacheProducer）
     bool addPointerToCache(Address address, Address value, Offset offset = 0);
 
     // 完成缓存写入，构建索引
     bool endWriteCache();
 
-    // 查找特定值范围内的指针（用于扫描时）
-    std::vector<PointerCacheEntry> findPointersInRange(Address minValue, Address maxValue);
+    // 获取当前已构建完成的等级（未构建时为空）
+    // 扫描线程应持有返回的等级直接查询，查询过程不加锁
+    std::shared_ptr<const FileCacheLevel> getLevel() const;
+
+    // 查找特定值范围内的指针，结果追加到调用方提供的缓冲区（线程安全）
+    size_t findPointersInRange(Address minValue, Address maxValue, std::vector<PointerCacheEntry>& results) const;
+    std::vector<PointerCacheEntry> findPointersInRange(Address minValue, Address maxValue) const;
 
     // 清理所有缓存文件
     void cleanup();
@@ -64,43 +162,52 @@ public:
         progressCallback_ = callback;
     }
 
-    // 通过偏移量读取指针
-    PointerCacheEntry* readPointerByOffset(int64_t offset);
+    // 通过偏移量读取指针（偏移按未压缩的条目数组计算）
+    bool readPointerByOffset(int64_t offset, PointerCacheEntry& entry) const;
+
+    // 设置外部排序的内存上限（所有并行排序段之和）
+    void setSortMemoryLimit(size_t bytes) { sortMemoryLimit_ = bytes; }
 
 private:
-    // 构建范围索引
+    friend class CacheProducer;
+
+    // 把一个块追加到当前等级的数据文件（线程安全）
+    bool appendBlock(const PointerCacheEntry* entries, size_t count);
+
+    // 构建范围索引：外部排序（并行生成有序段 + 多路归并），归并时生成范围索引
     bool buildRangeIndex();
     
-    // 分块构建范围索引
-    bool buildRangeIndexInChunks(std::ifstream& dataFile, size_t fileSize, size_t entryCount);
+    // 分段读取数据文件，并行排序后写入有序段文件
+    bool generateSortedRuns(const std::string& filePath, size_t entryCount, std::vector<std::string>& runs);
     
-    // 使用更小的分块构建范围索引（当内存受限时）
-    bool buildRangeIndexWithSmallChunks(std::ifstream& dataFile, size_t fileSize, size_t entryCount);
-    
-    // 私有方法：重载的findPointersInRange，实际执行搜索，结果存储在currentSearchResults_
-    bool findPointersInRange_(Address minValue, Address maxValue);
+    // 多路归并有序段，输出压缩块组成的全局有序文件并生成范围索引
+    bool mergeSortedRuns(const std::vector<std::string>& runs, const std::string& outputPath, size_t entryCount);
     
     // 获取临时文件路径
     std::string getTempFilePath(int level) const;
     
+    // 获取有序段文件路径
+    std::string getRunFilePath(int level, size_t runIndex) const;
+    
     // 获取索引文件路径
     std::string getIndexFilePath(int level) const;
-    
-    // 从文件加载索引
-    bool loadIndex(int level);
 
     std::string cacheDir_;                         // 缓存目录
     int currentLevel_;                             // 当前处理等级
-    size_t currentLevelPointerCount_;              // 当前等级指针数量
-    std::ofstream dataFile_;                       // 数据文件流
-    std::vector<RangeEntry> rangeIndex_;           // 范围索引
+    std::atomic<size_t> currentLevelPointerCount_; // 当前等级指针数量
+    int dataFd_ = -1;                              // 数据文件描述符
+    std::atomic<uint64_t> writeOffset_{0};         // 下一个块的写入位置
+    std::atomic<bool> writeFailed_{false};         // 是否有块写入失败
+    std::unique_ptr<CacheProducer> defaultProducer_; // addPointerToCache 使用的写入端
+    std::vector<RangeEntry> rangeIndex_;           // 构建中的范围索引
     std::unordered_map<int, std::string> dataFiles_; // 数据文件路径映射
-    mutable std::mutex mutex_;                     // 同步锁
+    mutable std::mutex mutex_;                     // 写入同步锁（查询不使用）
     ProgressCallback progressCallback_;            // 进度回调
+    size_t sortMemoryLimit_ = 256 * 1024 * 1024;   // 外部排序内存上限
+    std::shared_ptr<const FileCacheLevel> level_;  // 已构建的等级，通过原子操作发布
     
     // 缓存常量
     static constexpr size_t MAX_MEMORY_BUFFER = 50 * 1024 * 1024; // 50MB内存缓冲区上限
-    std::vector<PointerCacheEntry> currentSearchResults_; // 当前搜索结果缓存
 };
 
 } // namespace memchainer 
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "common/types.h"
 #include <system_error>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -16,6 +18,61 @@ enum class MemError {
     PageMapError
 };
 
+// 批量读取请求
+struct ReadRequest {
+    Address address;   // 目标地址
+    void* buffer;      // 输出缓冲区
+    MemorySize size;   // 读取长度
+    bool success;      // 读取结果
+};
+
+// 读取失败的地址范围集合（按页对齐，相邻范围合并）。
+// 按区域保存，同一次扫描中再次读取时直接跳过这些页，不再发起系统调用。非线程安全
+class FailedRangeSet {
+public:
+    void add(Address start, Address end);
+
+    bool contains(Address address) const;
+
+    // [start, end) 内（或与之相交的）第一个失败范围，没有时返回 false
+    bool findFirst(Address start, Address end, Address& failStart, Address& failEnd) const;
+
+    uint64_t totalBytes() const;
+    bool empty() const { return ranges_.empty(); }
+    void clear() { ranges_.clear(); }
+
+private:
+    std::map<Address, Address> ranges_; // 起始地址 -> 结束地址
+};
+
+// 异步读取完成项
+struct ReadCompletion {
+    uint64_t tag;      // 提交时的标记
+    Address address;
+    void* buffer;
+    MemorySize size;
+    bool success;
+};
+
+// 异步读取队列：连续提交多个读取，按完成顺序取回结果。
+// 非线程安全，每个线程各自创建；目标进程不能在使用期间切换。
+class AsyncReader {
+public:
+    virtual ~AsyncReader() = default;
+
+    // 提交读取，队列已满时返回 false（先调用 reap 取回结果）
+    virtual bool submit(Address address, void* buffer, MemorySize size, uint64_t tag) = 0;
+
+    // 取回已完成的读取，有未完成的读取时至少等待一个，返回取回数量
+    virtual size_t reap(ReadCompletion* completions, size_t maxCount) = 0;
+
+    // 已提交未取回的读取数量
+    virtual size_t inFlight() const = 0;
+
+    // 后端名称
+    virtual const char* name() const = 0;
+};
+
 // 统一的内存访问接口
 class MemoryAccess {
 public:
@@ -39,6 +96,14 @@ public:
     T read(Address address, std::error_code& ec) const;
     
     bool read(Address address, void* buffer, MemorySize size, std::error_code& ec) const;
+
+    // 自适应大块读取：先整段读取（完全可读时只需一次系统调用），失败时按页二分，
+    // 读出所有可读的部分；不可读的页填0并记入 failed，failed 中已有的范围直接跳过。
+    // 返回读取成功的字节数
+    MemorySize readAdaptive(Address address, void* buffer, MemorySize size, FailedRangeSet& failed) const;
+    
+    // 批量读取多个地址，返回成功数量（各请求的结果写入 success）
+    size_t readBatch(ReadRequest* requests, size_t count) const;
     
     // 检查地址是否有效
     bool isValidAddress(Address address) const;
@@ -50,10 +115,26 @@ public:
     // 处理页面错误
     bool checkAndHandlePageFault(Address address) const;
 
+    // 地址所在页是否已知全为0（快照等离线数据源可以提供，扫描时直接跳过）
+    virtual bool isKnownZeroPage(Address /*address*/) const { return false; }
+
+    // 创建异步读取队列，depth 为最多同时进行的读取数。
+    // 默认实现在提交时同步读取；访问实时进程的实现优先使用 io_uring
+    virtual std::unique_ptr<AsyncReader> createAsyncReader(size_t depth) const;
+
 protected:
     // 平台相关的内存读取实现
     virtual bool readMemory(Address address, void* buffer, MemorySize size, std::error_code& ec) const = 0;
     virtual bool isPageMapped(Address address) const = 0;
+    
+    // 平台相关的批量读取实现，默认逐个调用 readMemory
+    virtual size_t readMemoryBatch(ReadRequest* requests, size_t count) const;
+    
+    // 使用 process_vm_readv 一次提交多个远程地址
+    size_t readBatchVectored(ReadRequest* requests, size_t count) const;
+
+    // readAdaptive 的二分部分：读取失败时在页边界处对半拆分，直到单页
+    MemorySize readBisect(Address address, uint8_t* buffer, MemorySize size, FailedRangeSet& failed) const;
 
     ProcessId targetPid_;
     int pageFd_;  // 页面映射文件描述符
@@ -73,9 +154,13 @@ public:
     // 设置Su路径
     void setSuPath(const std::string& suPath) { suPath_ = suPath; }
 
+    // 优先使用 io_uring 读取 /proc/pid/mem，不可用时退化为同步读取
+    std::unique_ptr<AsyncReader> createAsyncReader(size_t depth) const override;
+
 protected:
     bool readMemory(Address address, void* buffer, MemorySize size, std::error_code& ec) const override;
     bool isPageMapped(Address address) const override;
+    size_t readMemoryBatch(ReadRequest* requests, size_t count) const override;
 
 private:
     int memFd_;           // 进程内存文件描述符
@@ -94,9 +179,13 @@ public:
     LinuxMemoryAccess();
     ~LinuxMemoryAccess() override;
 
+    // 优先使用 io_uring 读取 /proc/pid/mem，不可用时退化为同步读取
+    std::unique_ptr<AsyncReader> createAsyncReader(size_t depth) const override;
+
 protected:
     bool readMemory(Address address, void* buffer, MemorySize size, std::error_code& ec) const override;
     bool isPageMapped(Address address) const override;
+    size_t readMemoryBatch(ReadRequest* requests, size_t count) const override;
 
 private:
     int memFd_;  // 进程内存文件描述符
@@ -104,6 +193,22 @@ private:
     void closeMemoryFile();
 };
 
+// 进程内实现：扫描器运行在目标进程内（注入的 .so 或扫描自身）时直接访问地址空间。
+// 复制时捕获 SIGSEGV/SIGBUS，访问不可读的页返回失败而不是崩溃，读取不需要系统调用
+class LocalMemoryAccess : public MemoryAccess {
+public:
+    LocalMemoryAccess();
+    ~LocalMemoryAccess() override;
+
+    // 容错复制：src 范围内有不可读的页时返回 false（dst 内容不确定）
+    static bool safeCopy(void* dst, const void* src, size_t size);
+
+protected:
+    bool readMemory(Address address, void* buffer, MemorySize size, std::error_code& ec) const override;
+    bool isPageMapped(Address address) const override;
+    size_t readMemoryBatch(ReadRequest* requests, size_t count) const override;
+};
+
 // 模板方法实现
 template<typename T>
 T MemoryAccess::read(Address address, std::error_code& ec) const {
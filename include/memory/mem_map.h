@@ -1,92 +1,211 @@
 #pragma once
 
 #include "common/types.h"
+#include "memory/elf_module.h"
+#include <string>
 #include <vector>
 #include <memory>
-#include <map>
-#include <list>
+#include <unordered_map>
+#include <string_view>
+#include <unordered_set>
+#include <sys/types.h>
 
 namespace memchainer {
 
+// 智能过滤的阈值，大小规则只作用于非静态区域（Code_app/C_data/C_bss 不受影响）
+struct SmartFilterOptions {
+    uint64_t minRegionSize = 2 * 4096;       // 小于该大小的区域不扫描
+    uint64_t maxRegionSize = 1024ULL << 20;  // 大于该大小的区域不扫描
+};
+
+// 上次 getFilteredRegions 各规则排除的区域，每个区域只计入第一条命中的规则
+struct RegionFilterStats {
+    struct Rule {
+        size_t regions = 0;
+        uint64_t bytes = 0;
+        void add(const MemoryRegion* region) {
+            regions++;
+            bytes += region->endAddress - region->startAddress;
+        }
+    };
+    Rule typeMask;     // 类型不在 setRegionFilter 的掩码中
+    Rule guard;        // 无任何权限的保护页
+    Rule unreadable;   // 不可读
+    Rule nonResident;  // 没有驻留页（setResidentFilter）
+    Rule tiny;         // 小于 minRegionSize
+    Rule oversize;     // 大于 maxRegionSize
+    Rule selected;     // 最终选中
+};
+
+// 区域相对上次加载的变化
+enum class RegionChange : uint8_t {
+    Unchanged, // 起止地址、路径和权限都相同
+    Added,     // 新出现的区域（包括权限变化的区域）
+    Resized    // 同一路径的区域起始或结束地址不变、另一端移动（堆、栈增长等）
+};
+
+// 同一进程两次加载内存映射之间的差异
+struct MapsDiff {
+    bool incremental = false;         // 与同一进程的上次加载比较；为假时所有区域都算新增
+    uint64_t previousFingerprint = 0; // 上次加载（含 parseProcessModule 改名）的指纹
+    std::vector<RegionChange> changes; // 按新区域编号
+    std::vector<RegionId> previousIds; // 新区域在上次区域表中的编号，新增区域为 INVALID_REGION_ID
+    std::vector<MemoryRegion> removed; // 上次存在、本次没有对应区域的区域
+    size_t unchanged = 0;
+    size_t added = 0;
+    size_t resized = 0;
+    uint64_t unchangedBytes = 0;
+    uint64_t changedBytes = 0;        // 新增和大小变化区域的字节数
+};
+
 // 内存映射管理
 class MemoryMap {
 public:
     MemoryMap();
     ~MemoryMap();
 
-    // 获取进程内存映射
+    // 获取进程内存映射；同一进程重新加载时与上次的区域表比较，结果见 getLastDiff
     bool loadMemoryMap(ProcessId pid);
+
+    // 上次 loadMemoryMap 相对之前区域表的差异
+    const MapsDiff& getLastDiff() const { return lastDiff_; }
+    void printMapsDiff() const;
     
     // 设置内存区域过滤器
     void setRegionFilter(int regionTypes);
+
+    // 加载时同时读取 /proc/pid/smaps，getFilteredRegions 跳过没有驻留页的区域
+    // （Rss 和 Swap 均为 0，读取只会得到零页或未修改的文件内容）
+    void setResidentFilter(bool enabled) { residentFilter_ = enabled; }
+    bool getResidentFilter() const { return residentFilter_; }
+
+    // 上次加载时没有驻留页的区域数和总大小
+    size_t getNonResidentCount() const { return nonResident_.size(); }
+    uint64_t getNonResidentBytes() const { return nonResidentBytes_; }
     
-    // 获取所有匹配过滤器的内存区域
+    // 获取所有匹配过滤器的内存区域（类型掩码、驻留页过滤和智能过滤），同时更新过滤统计
     std::vector<MemoryRegion*> getFilteredRegions() ;
+
+    const RegionFilterStats& getFilterStats() const { return filterStats_; }
+    void printFilterStats() const;
     
-    // 手动添加内存区域
+    // 手动添加内存区域（区域表重新排序，之前取得的区域指针失效）
     MemoryRegion* addCustomRegion(Address start, Address end, const char* name, bool filterable = false);
+
+    // 按原样添加区域（从快照恢复时使用），isStatic 为真时加入静态区域列表（同样会使区域指针失效）
+    MemoryRegion* addRegion(const MemoryRegion& region, bool isStatic);
+
+    // 所有内存区域，按起始地址排序，下标即区域编号；加载后不再变化
+    const std::vector<MemoryRegion>& getRegions() const { return regions_; }
+
+    // 按编号取区域，编号无效时返回空
+    const MemoryRegion* getRegion(RegionId id) const { return id < regions_.size() ? &regions_[id] : nullptr; }
+
+    // 查找包含地址的区域编号，找不到返回 INVALID_REGION_ID
+    RegionId findRegionId(Address address) const;
+    const MemoryRegion* findRegion(Address address) const { return getRegion(findRegionId(address)); }
+
+    // 区域是否在静态区域列表中（parseProcessModule 之后有效）
+    bool isStaticRegion(RegionId id) const { return id < staticFlags_.size() && staticFlags_[id]; }
+    const std::vector<MemoryRegion*>& getStaticRegions() const { return staticRegions_; }
     
     // 清除所有内存区域
     void clear();
 
     // 获取区域数量
     size_t getRegionCount() const;
+
+    // 所有区域（地址、类型、名称）的指纹，用于判断内存映射是否变化
+    uint64_t getFingerprint() const;
     
     // 获取当前过滤器
     int getRegionFilter() const;
     
-    // 添加parseProcessModule方法
+    // 添加parseProcessModule方法：从磁盘解析应用模块的 ELF，按 .data/.data.rel.ro/.bss 的
+    // 实际范围标记静态区域（包括没有标注的匿名 bss），解析失败的模块按路径和权限推断
     bool parseProcessModule();
+
+    // 静态区域按 "文件名@构建ID" 命名，静态偏移相对模块加载基址（应在 parseProcessModule 之前设置）。
+    // 这样得到的链在重新编译前不受模块路径、段布局和加载顺序变化影响
+    void setBuildIdKeys(bool enabled) { buildIdKeys_ = enabled; }
+    bool getBuildIdKeys() const { return buildIdKeys_; }
+
+    // 上次 parseProcessModule 解析到的 ELF 模块（loadBias 为本进程中的加载基址）
+    const std::vector<ElfModule>& getModules() const { return modules_; }
+    
+    // 按名称查找内存区域（parseProcessModule 之后名称为 "模块名[序号]"）
+    MemoryRegion* findRegionByName(const std::string& name);
+
+    // 链中模块名对应的静态偏移基址：按名称查找区域，"文件名@构建ID" 找不到时按构建 ID 匹配模块；
+    // 找不到返回 0
+    Address resolveModuleBase(const std::string& name);
     
     // 打印内存区域信息
     void printRegionInfo(std::vector<MemoryRegion*> memoryRegions_);
 
-    // 应用智能内存区域过滤
+    // 应用智能内存区域过滤：之后 getFilteredRegions 额外排除保护页、不可读区域、
+    // 没有驻留页以及过小或过大的区域
     void applySmartFilter();
+    void setSmartFilterOptions(const SmartFilterOptions& options) { smartFilterOptions_ = options; }
+    bool isSmartFilterEnabled() const { return smartFilter_; }
 
 private:
     // 解析/proc/pid/maps文件
     bool parseProcessMaps(ProcessId pid);
+
+    // 解析/proc/pid/smaps，记录没有驻留页的区域
+    bool parseProcessSmaps(ProcessId pid);
+
+    // 一次读入整个 /proc 文件到 readBuffer_，返回读取的字节数，失败返回 -1
+    ssize_t readProcFile(const char* path);
     
     // 确定内存区域类型
-    int determineRegionType(const std::string& name, const std::string& permissions);
+    int determineRegionType(std::string_view name, std::string_view permissions);
 
     // 获取权限保护标志
-    int getPermissionProtFlags(const std::string& permissions);
+    int getPermissionProtFlags(std::string_view permissions);
+
+    // 区域与已解析 ELF 模块的对应
+    struct ElfRegionInfo {
+        int type = 0;        // 0 不属于已解析模块，-1 属于模块但不含静态数据，否则为 C_data/C_bss
+        uint32_t module = 0; // modules_ 下标
+    };
+
+    // 从磁盘解析区域表中的应用模块（在改名之前调用，需要 maps 中的原始路径），填写 modules_
+    void resolveElfModules(std::vector<ElfRegionInfo>& info);
+
+    // 智能过滤规则，返回命中的规则（未命中返回空）
+    RegionFilterStats::Rule* matchSmartRule(const MemoryRegion* region);
+
+    // 区域表：按起始地址排序的连续数组，起止地址另存一份用于查找
+    std::vector<MemoryRegion> regions_;
+    std::vector<Address> regionStarts_;
+    std::vector<Address> regionEnds_;
+    std::vector<uint8_t> staticFlags_;                        // 按编号标记静态区域
+    std::vector<MemoryRegion*> staticRegions_;                // 静态区域，按地址排序
+    std::unordered_map<std::string_view, RegionId> nameIndex_; // 名称 -> 编号（指向 regions_ 中的名称）
+
+    // 排序并分配编号，重建查找表、名称索引和静态区域列表
+    void finalizeRegions();
+
+    // 比较新加载的区域表和上次的区域表，填写 lastDiff_
+    void diffRegions(const std::vector<MemoryRegion>& previous, bool incremental, uint64_t previousFingerprint);
 
-    std::list<MemoryRegion*> memoryRegions_;
     int regionFilter_;
     ProcessId currentPid_;
+    bool residentFilter_ = false;
+    std::unordered_set<Address> nonResident_; // 没有驻留页的区域起始地址
+    uint64_t nonResidentBytes_ = 0;
+    std::vector<char> readBuffer_;            // 复用的 /proc 文件读取缓冲区
+    bool smartFilter_ = false;
+    SmartFilterOptions smartFilterOptions_;
+    RegionFilterStats filterStats_;
+    MapsDiff lastDiff_;
+    bool buildIdKeys_ = false;
+    std::vector<ElfModule> modules_;
+    std::unordered_map<std::string, size_t> buildIdIndex_;    // 构建 ID -> modules_ 下标
+    std::unordered_map<std::string, ElfModule> elfCache_;     // "路径:偏移:大小:修改时间" -> 解析结果（重新加载时复用）
 
-    // 区域索引加速查询
-    struct RegionIndex {
-        std::map<Address, MemoryRegion*> addressToRegion;
-        
-        void rebuild(const std::list<MemoryRegion*>& regions) {
-            addressToRegion.clear();
-            for (auto* region : regions) {
-                addressToRegion[region->startAddress] = region;
-            }
-        }
-        
-        MemoryRegion* findRegion(Address addr) const {
-            if (addressToRegion.empty()) return nullptr;
-            
-            auto it = addressToRegion.upper_bound(addr);
-            if (it == addressToRegion.begin()) return nullptr;
-            
-            --it;
-            MemoryRegion* region = it->second;
-            
-            if (addr >= region->startAddress && addr < region->endAddress) {
-                return region;
-            }
-            
-            return nullptr;
-        }
-    };
-    
-    RegionIndex regionIndex_;
 };
 
 } // namespace memchainer
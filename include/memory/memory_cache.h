@@ -5,57 +5,163 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <atomic>
 #include <mutex>
+#include <condition_variable>
 
 namespace memchainer {
 
+/**
+ * @brief 按块缓存目标进程内存
+ *
+ * 块按地址分到多个分片，每个分片一把锁、一个哈希索引和一条侵入式 LRU 链表，
+ * 命中时 O(1) 移到表头，不取时间戳；块数据来自预先分配的连续内存（slab），
+ * 插入时直接读入槽位，不额外复制。加载中的块不在 LRU 链表上，不会被淘汰。
+ * 块内有不可读的页时按页记录可读位图，只有请求范围内的页都可读才从缓存返回。
+ *
+ * 每个线程记录自己的块访问序列，连续两次以相同步长（顺序或固定跨度）切换块时，
+ * 在全局线程池中通过 AsyncReader 批量预取后续 prefetchDepth 个块。
+ */
 class MemoryCache {
 public:
-    struct CacheBlock {
-        Address startAddress;
-        Address endAddress;
-        std::vector<uint8_t> data;
-        bool isValid;
-        uint64_t lastAccess; // 最后访问时间戳
-    };
+    static constexpr size_t MAX_SHARDS = 16;
+    static constexpr size_t DEFAULT_PREFETCH_DEPTH = 4;
+    static constexpr size_t MAX_PREFETCH_STRIDE = 16;   // 超过该块数的跨度不预取
+    static constexpr size_t MAX_PENDING_PREFETCHES = 4; // 同时排队或执行的预取任务数
 
+    // blockSize 向上取整到2的幂（至少一页）
     MemoryCache(size_t blockSize = 1024 * 1024);
     ~MemoryCache();
 
-    // 从缓存读取内存数据
-    bool readMemory(const std::shared_ptr<MemoryAccess>& memAccess, 
+    MemoryCache(const MemoryCache&) = delete;
+    MemoryCache& operator=(const MemoryCache&) = delete;
+
+    // 从缓存读取内存数据（可跨块）
+    bool readMemory(const std::shared_ptr<MemoryAccess>& memAccess,
                   Address address, void* buffer, size_t size);
-    
+
     // 预加载内存区域到缓存
     bool preloadRegion(const std::shared_ptr<MemoryAccess>& memAccess,
                      Address startAddress, Address endAddress);
-    
+
     // 清除缓存
     void clear();
-    
+
     // 获取性能统计
-    size_t getCacheHits() const { return cacheHits_; }
-    size_t getCacheMisses() const { return cacheMisses_; }
+    size_t getCacheHits() const;
+    size_t getCacheMisses() const;
     double getHitRatio() const;
-    
-    // 设置最大缓存大小
-    void setMaxCacheSize(size_t maxBlocks) { maxCacheBlocks_ = maxBlocks; }
+
+    // 预取统计：发起预取的块数、预取后被命中的块数、未被使用就被淘汰的块数
+    size_t getPrefetchIssued() const;
+    size_t getPrefetchUseful() const;
+    size_t getPrefetchWasted() const;
+    double getPrefetchAccuracy() const;
+
+    // 预取深度（块数），0 关闭预取；不超过缓存块数的一半
+    void setPrefetchDepth(size_t depth);
+    size_t getPrefetchDepth() const { return prefetchDepth_; }
+
+    // 设置最大缓存块数，会重新分配缓存并清空已缓存的数据（应在使用前调用）
+    void setMaxCacheSize(size_t maxBlocks);
 
 private:
+    static constexpr uint32_t NIL = 0xFFFFFFFF;
+
+    enum class SlotState : uint8_t {
+        Free,
+        Loading, // 正在读取，只有发起读取的线程访问数据，其他线程等待 loaded
+        Valid,   // 整块可读
+        Partial  // 部分页可读，见 validPages_
+    };
+
+    struct Slot {
+        Address blockStart = 0;
+        uint32_t prev = NIL; // LRU 链表（表头为最近使用）
+        uint32_t next = NIL;
+        SlotState state = SlotState::Free;
+        bool prefetched = false; // 预取读入，尚未被命中
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::condition_variable loaded; // 槽位加载完成
+        std::unordered_map<Address, uint32_t> index; // 块起始地址 -> 槽位
+        std::vector<uint32_t> freeSlots;
+        uint32_t head = NIL;
+        uint32_t tail = NIL;
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t prefetchIssued = 0;
+        size_t prefetchUseful = 0;
+        size_t prefetchWasted = 0;
+    };
+
+    // 预取任务的排队/执行计数，任务持有它的副本，缓存销毁后排队的任务直接退出
+    struct PrefetchControl {
+        std::mutex mutex;
+        std::condition_variable idle;
+        size_t pending = 0;
+        size_t running = 0;
+        bool stopped = false;
+    };
+
     size_t blockSize_;
-    std::unordered_map<Address, CacheBlock> cacheBlocks_; // 使用map提高查找效率
+    size_t pagesPerBlock_;
+    size_t maskWords_;                    // 每个槽位的可读页位图字数
     size_t maxCacheBlocks_;
-    
-    // 性能统计
-    size_t cacheHits_;
-    size_t cacheMisses_;
-    
-    // 同步
-    mutable std::mutex cacheMutex_;
-    
-    // 内部方法
-    void evictOldestBlock();
+    size_t shardCount_ = 0;
+    std::unique_ptr<Shard[]> shards_;
+    std::vector<Slot> slots_;
+    std::vector<uint64_t> validPages_;    // 各槽位的可读页位图
+    std::unique_ptr<uint8_t[]> slab_;     // 各槽位的块数据
+
+    uint64_t cacheId_;                    // 区分线程记录的访问模式属于哪个缓存
+    std::atomic<size_t> prefetchDepth_{DEFAULT_PREFETCH_DEPTH};
+    std::shared_ptr<PrefetchControl> prefetchControl_;
+
+    // 按 maxCacheBlocks_ 重新分配分片、槽位和 slab
+    void rebuild();
+
+    // 停止排队的预取任务并等待执行中的任务结束
+    void stopPrefetches();
+
+    // 记录本线程一次读取覆盖的首末块，识别出固定步长时发起预取
+    void observeAccess(const std::shared_ptr<MemoryAccess>& memAccess, Address firstBlock, Address lastBlock);
+
+    // 预取任务：占用槽位后通过 AsyncReader 批量读取
+    void prefetchBlocks(const std::shared_ptr<MemoryAccess>& memAccess, const std::vector<Address>& blocks);
+
+    Shard& shardFor(Address blockStart) const;
+    uint8_t* slotData(uint32_t slot) const { return slab_.get() + static_cast<size_t>(slot) * blockSize_; }
+
+    // 读取块内的一段，miss 时把整块读入槽位
+    bool readBlock(const MemoryAccess& memAccess, Address blockStart, size_t offset,
+                   uint8_t* out, size_t length);
+
+    // 确保块已缓存（预加载用），返回块是否整块可读
+    bool loadBlock(const MemoryAccess& memAccess, Address blockStart);
+
+    // 把块读入槽位并记录可读页，返回整块是否可读（不修改槽位状态，由调用者持锁发布）
+    bool fillSlot(const MemoryAccess& memAccess, uint32_t slot, Address blockStart);
+
+    // 整块读取失败后逐页确认可读范围并记录位图
+    void fillPartial(const MemoryAccess& memAccess, uint32_t slot, Address blockStart);
+
+    // 发布加载完成的槽位
+    void publishSlot(uint32_t slot, bool whole);
+
+    // 槽位中 [offset, offset+length) 覆盖的页是否都可读（按可读页位图）
+    bool rangeValid(uint32_t slot, size_t offset, size_t length) const;
+
+    // 以下在持有分片锁时调用
+    uint32_t allocateSlot(Shard& shard);
+    void unlink(Shard& shard, uint32_t slot);
+    void pushFront(Shard& shard, uint32_t slot);
+
     Address getBlockStartAddress(Address address) const;
+
+    size_t sumShards(size_t Shard::*counter) const;
 };
 
 } // namespace memchainer
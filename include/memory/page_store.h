@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace memchainer {
+
+/**
+ * @brief 按内容寻址的页存储
+ *
+ * 目录下两个文件：pages.bin 顺序存放唯一页，pages.idx 存放各页的哈希。
+ * 页编号从1开始（编号为页在 pages.bin 中的下标+1），0 表示全零页，不实际存储。
+ * 同一目录下的多个快照共享存储，相同内容的页只保存一次。
+ * 写入端非线程安全，同一时间只允许一个进程写入同一目录。
+ */
+class PageStore {
+public:
+    static constexpr size_t STORE_PAGE_SIZE = 4096;
+    static constexpr uint32_t ZERO_PAGE = 0;             // 全零页
+    static constexpr uint32_t MISSING_PAGE = 0xFFFFFFFF; // 读取失败的页
+    static constexpr size_t WRITE_BUFFER_PAGES = 1024;   // 新页攒够后顺序写出（4MB）
+
+    PageStore();
+    ~PageStore();
+
+    PageStore(const PageStore&) = delete;
+    PageStore& operator=(const PageStore&) = delete;
+
+    // 打开存储目录；writable 为真时目录不存在则创建，并加载哈希索引用于去重
+    bool open(const std::string& dir, bool writable);
+    void close();
+
+    // 存入一页，返回页编号（内容已存在时返回已有编号，全零页返回 ZERO_PAGE）
+    uint32_t put(const uint8_t* page);
+
+    // 写出缓冲的新页和索引
+    bool flush();
+
+    // 取得页内容（只读打开时有效）
+    const uint8_t* get(uint32_t id) const;
+
+    // 页内容哈希（id 无效时返回 0）
+    uint64_t getHash(uint32_t id) const {
+        return id != ZERO_PAGE && id <= hashes_.size() ? hashes_[id - 1] : 0;
+    }
+
+    // 存储目录
+    const std::string& getDir() const { return dir_; }
+
+    // 页数量（不含全零页）
+    size_t getPageCount() const { return hashes_.size(); }
+
+    // 本次打开后新增的页数量
+    size_t getAddedPages() const { return hashes_.size() - persistedPages_; }
+
+    // 整页是否全为0
+    static bool isZeroPage(const uint8_t* page);
+
+    // 页内容哈希
+    static uint64_t hashPage(const uint8_t* page);
+
+private:
+    // 比较 id 对应页与给定内容是否相同（可能在写入缓冲中）
+    bool samePage(uint32_t id, const uint8_t* page) const;
+
+    std::string dir_;
+    bool writable_ = false;
+    int pagesFd_ = -1;
+    std::vector<uint64_t> hashes_;                      // 下标为页编号-1
+    std::unordered_multimap<uint64_t, uint32_t> index_; // 哈希 -> 页编号
+    std::vector<uint8_t> pending_;                      // 尚未写出的新页
+    size_t flushedPages_ = 0;                           // 已写入 pages.bin 的页数
+    size_t persistedPages_ = 0;                         // 打开时已有的页数
+    const uint8_t* data_ = nullptr;                     // 只读映射
+    size_t mappedSize_ = 0;
+};
+
+} // namespace memchainer
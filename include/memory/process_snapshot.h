@@ -0,0 +1,149 @@
+#pragma once
+
+#include "memory/mem_access.h"
+#include "memory/mem_map.h"
+#include "memory/page_store.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace memchainer {
+
+// 进程快照文件格式:
+//   [文件头][区域表][各已采集区域的页编号表（每页一个 uint32）]
+// 区域表保存完整的内存映射（含模块名和静态区域标记），只有被扫描的区域带页编号表。
+// 页内容保存在按内容寻址的 PageStore 中（默认为快照所在目录下的 snapshot_pages），
+// 同一目录下的快照共享存储：全零页和相同内容的页不重复保存。
+// 页编号 ZERO_PAGE 表示全零页，MISSING_PAGE 表示采集时读取失败，快照读取时按失败处理。
+
+#pragma pack(push, 1)
+struct SnapshotHeader {
+    char magic[4];            // "MCSS"
+    uint16_t version;         // 格式版本
+    uint16_t reserved;
+    int32_t pid;              // 采集时的进程ID
+    uint32_t regionCount;     // 区域表条目数
+    uint64_t timestamp;       // 采集时间（Unix 秒）
+    uint64_t mapsFingerprint; // MemoryMap::getFingerprint()
+    uint64_t regionOffset;    // 区域表偏移
+    uint64_t totalPages;      // 采集的页数
+    uint64_t zeroPages;       // 其中全零页数
+    uint64_t newPages;        // 其中新写入页存储的页数
+    char storeDir[128];       // 页存储目录（相对路径相对于快照文件所在目录）
+};
+
+struct SnapshotRegion {
+    uint64_t startAddress;
+    uint64_t endAddress;
+    int32_t type;
+    int32_t count;
+    uint8_t flags;            // REGION_CAPTURED / REGION_STATIC
+    uint8_t reserved[3];
+    uint32_t baseOffset;      // 区域起始相对静态偏移基址的距离（MemoryRegion::staticBase，0 表示区域起始）
+    uint64_t pageMapOffset;   // 页编号表在文件中的偏移（未采集为0）
+    char name[128];
+};
+#pragma pack(pop)
+
+// 采集统计
+struct SnapshotStats {
+    size_t regions = 0;       // 采集的区域数
+    uint64_t bytes = 0;       // 采集的字节数
+    size_t failedPages = 0;   // 读取失败的页数
+    size_t zeroPages = 0;     // 全零页数
+    size_t duplicatePages = 0; // 与已有页内容相同的页数
+    size_t newPages = 0;      // 新写入页存储的页数
+    long long elapsedMs = 0;
+};
+
+/**
+ * @brief 进程内存快照
+ *
+ * capture 按大块读取 MemoryMap::getFilteredRegions 选中的区域，逐页去重后存入页存储，
+ * 快照文件只保存完整的内存映射和页编号表；open 映射快照文件和页存储，
+ * 可恢复 MemoryMap 并按地址取数据。
+ */
+class ProcessSnapshot {
+public:
+    static constexpr uint8_t REGION_CAPTURED = 1; // 区域带数据
+    static constexpr uint8_t REGION_STATIC = 2;   // 静态区域
+    static constexpr size_t CAPTURE_CHUNK_SIZE = 4 * 1024 * 1024; // 采集时单次读取的大小
+    static constexpr const char* DEFAULT_STORE_DIR = "snapshot_pages";
+
+    ProcessSnapshot();
+    ~ProcessSnapshot();
+
+    ProcessSnapshot(const ProcessSnapshot&) = delete;
+    ProcessSnapshot& operator=(const ProcessSnapshot&) = delete;
+
+    // 采集进程快照（memMap 应已调用 parseProcessModule），storeDir 为空时使用快照目录下的 DEFAULT_STORE_DIR
+    static bool capture(const std::string& filename, const MemoryAccess& memAccess,
+                        MemoryMap& memMap, SnapshotStats* stats = nullptr,
+                        const std::string& storeDir = "");
+
+    // 打开并映射快照文件
+    bool open(const std::string& filename);
+
+    // 用快照中的内存映射替换 memMap 的内容，并重建静态区域列表
+    bool restoreMemoryMap(MemoryMap& memMap) const;
+
+    const SnapshotHeader& getHeader() const { return header_; }
+    const std::vector<SnapshotRegion>& getRegions() const { return regions_; }
+
+    // 读取快照中的数据，范围必须落在同一个已采集区域内且所有页都读取成功
+    bool read(Address address, void* buffer, size_t size) const;
+
+    // 地址所在页是否有数据
+    bool isPageCaptured(Address address) const;
+
+    // 地址所在页是否为全零页
+    bool isZeroPage(Address address) const;
+
+    // 地址所在页的页编号，不在已采集区域内时返回 MISSING_PAGE
+    uint32_t getPageId(Address address) const;
+
+    // 已采集区域的页编号表（页数为区域大小按页向上取整）
+    const uint32_t* getPageMap(const SnapshotRegion& region) const;
+
+    // 按页编号取页内容（全零页和读取失败的页返回空）
+    const uint8_t* getPage(uint32_t id) const { return store_.get(id); }
+
+    // 快照使用的页存储
+    const PageStore& getPageStore() const { return store_; }
+
+private:
+    // 查找包含地址的已采集区域，返回区域表下标，找不到返回 -1
+    long findRegion(Address address) const;
+
+    void close();
+
+    SnapshotHeader header_{};
+    std::vector<SnapshotRegion> regions_;
+    std::vector<uint32_t> captured_; // 已采集区域的下标，按起始地址排序
+    const uint8_t* data_ = nullptr;
+    size_t mappedSize_ = 0;
+    PageStore store_;
+};
+
+// 基于进程快照的内存访问，读取直接来自快照文件的映射，可在离线环境中反复扫描
+class SnapshotMemoryAccess : public MemoryAccess {
+public:
+    SnapshotMemoryAccess();
+    ~SnapshotMemoryAccess() override;
+
+    // 打开快照文件，目标进程ID设为采集时的PID
+    bool open(const std::string& filename);
+
+    const ProcessSnapshot& getSnapshot() const { return snapshot_; }
+
+    bool isKnownZeroPage(Address address) const override;
+
+protected:
+    bool readMemory(Address address, void* buffer, MemorySize size, std::error_code& ec) const override;
+    bool isPageMapped(Address address) const override;
+
+private:
+    ProcessSnapshot snapshot_;
+};
+
+} // namespace memchainer
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "memory/mem_access.h"
+#include "memory/process_snapshot.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace memchainer {
+
+// 比较时的数值类型，决定数值宽度和对齐
+enum class DiffValueType : uint8_t {
+    Int8,
+    Int16,
+    Int32,
+    Int64,
+    Float,
+    Double
+};
+
+// 连续变化的地址范围 [start, end)，按数值宽度对齐
+struct ChangedRange {
+    Address start;
+    Address end;
+};
+
+// 单个数值的变化，保存原始位模式（小端，按 DiffValueType 解释）
+struct ValueDelta {
+    Address address;
+    uint64_t oldBits;
+    uint64_t newBits;
+};
+
+struct DiffOptions {
+    DiffValueType valueType = DiffValueType::Int32;
+    size_t maxDeltas = 1000000; // 最多记录的数值变化（按地址取前N个），0 为只输出变化范围
+};
+
+struct DiffStats {
+    size_t regions = 0;        // 参与比较的区域数
+    size_t regionsAdded = 0;   // 只在新数据中出现的区域（与实时进程比较时不统计）
+    size_t regionsRemoved = 0; // 只在旧快照中出现的区域
+    size_t pagesSkipped = 0;   // 按页编号或哈希判定相同而跳过的页
+    size_t pagesCompared = 0;  // 逐块比较的页
+    size_t pagesChanged = 0;   // 有变化的页
+    size_t pagesMissing = 0;   // 任一侧没有数据的页
+    uint64_t bytesChanged = 0; // 变化范围的总字节数
+    size_t deltaCount = 0;     // 变化的数值总数（可能多于记录的数量）
+    long long elapsedMs = 0;
+};
+
+struct DiffResult {
+    std::vector<ChangedRange> ranges; // 按地址排序，相邻范围已合并
+    std::vector<ValueDelta> deltas;   // 按地址排序
+    DiffStats stats;
+};
+
+/**
+ * @brief 快照差异比较
+ *
+ * 以页为单位比较旧快照与新快照（或实时进程）中地址重叠的已采集区域：
+ * 共享页存储的快照页编号相同即跳过，不同存储先比较页哈希；
+ * 需要比较的页按64字节块做异或归约定位变化块，再按数值宽度输出变化。
+ * 区域按 DIFF_TASK_SIZE 切分后提交到全局线程池并行比较。
+ */
+class SnapshotDiff {
+public:
+    static constexpr size_t DIFF_TASK_SIZE = 16 * 1024 * 1024; // 单个任务比较的最大字节数
+    static constexpr size_t LIVE_READ_PAGES = 64;              // 与实时进程比较时单次读取的页数
+
+    // 比较两个快照
+    static bool diff(const ProcessSnapshot& before, const ProcessSnapshot& after,
+                     const DiffOptions& options, DiffResult& result);
+
+    // 比较快照与实时进程（只比较快照中已采集的区域）
+    static bool diff(const ProcessSnapshot& before, const MemoryAccess& live,
+                     const DiffOptions& options, DiffResult& result);
+
+    // 数值宽度（字节）
+    static size_t valueSize(DiffValueType type);
+
+    // 解析类型名称（i8/i16/i32/i64/f32/f64）
+    static bool parseType(const std::string& name, DiffValueType& type);
+
+    // 按类型格式化数值
+    static std::string formatValue(DiffValueType type, uint64_t bits);
+
+    // 变化量（新值-旧值），整数按有符号数计算
+    static double deltaValue(DiffValueType type, const ValueDelta& delta);
+};
+
+} // namespace memchainer
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "common/types.h"
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace memchainer {
+
+// 指针链签名（128位哈希）
+struct ChainSignature {
+    uint64_t low;
+    uint64_t high;
+
+    bool operator==(const ChainSignature& other) const {
+        return low == other.low && high == other.high;
+    }
+
+    bool operator<(const ChainSignature& other) const {
+        return high < other.high || (high == other.high && low < other.low);
+    }
+};
+
+struct ChainSignatureHash {
+    size_t operator()(const ChainSignature& sig) const noexcept {
+        return static_cast<size_t>(sig.low ^ (sig.high >> 7));
+    }
+};
+
+/**
+ * @brief 指针链去重器
+ *
+ * 以 (区域名, 静态偏移, 偏移序列) 的128位哈希作为签名，
+ * 签名保存在分片的并发集合中。超过内存上限的分片会被排序后溢出到磁盘，
+ * 之后的查询先查内存集合，再通过页级栅栏索引在溢出文件中二分查找。
+ */
+class ChainDeduplicator {
+public:
+    static constexpr size_t SHARD_COUNT = 64;
+    static constexpr size_t DEFAULT_MEMORY_LIMIT = 256 * 1024 * 1024; // 256MB
+
+    explicit ChainDeduplicator(size_t memoryLimit = DEFAULT_MEMORY_LIMIT,
+                               const std::string& spillDir = "");
+    ~ChainDeduplicator();
+
+    ChainDeduplicator(const ChainDeduplicator&) = delete;
+    ChainDeduplicator& operator=(const ChainDeduplicator&) = delete;
+
+    // 计算签名
+    static ChainSignature computeSignature(const char* regionName, uint64_t staticOffset,
+                                           const Offset* offsets, size_t offsetCount);
+    static ChainSignature computeSignature(const std::list<PointerChainNode>& chain);
+
+    // 插入签名，首次出现返回true，重复返回false（线程安全）
+    bool insert(const ChainSignature& sig);
+
+    // 清空所有签名和溢出文件
+    void clear();
+
+    // 统计信息
+    size_t getUniqueCount() const { return uniqueCount_.load(std::memory_order_relaxed); }
+    size_t getDuplicateCount() const { return duplicateCount_.load(std::memory_order_relaxed); }
+    size_t getSpilledCount() const { return spilledCount_.load(std::memory_order_relaxed); }
+
+private:
+    // 溢出文件每页签名数（4KB）
+    static constexpr size_t SIGS_PER_PAGE = 4096 / sizeof(ChainSignature);
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_set<ChainSignature, ChainSignatureHash> signatures;
+        int spillFd = -1;                        // 溢出文件（已排序）
+        size_t spillCount = 0;                   // 溢出文件中的签名数量
+        std::vector<ChainSignature> pageFences;  // 每页第一个签名
+    };
+
+    // 将分片内存中的签名与已有溢出文件合并写出（调用方持有分片锁）
+    bool spillShard(Shard& shard, size_t shardIndex);
+
+    // 在溢出文件中查找签名（调用方持有分片锁）
+    bool findInSpill(const Shard& shard, const ChainSignature& sig) const;
+
+    std::string getSpillFilePath(size_t shardIndex, int generation) const;
+
+    Shard shards_[SHARD_COUNT];
+    size_t maxEntriesPerShard_;
+    std::string spillDir_;
+    std::atomic<int> spillGeneration_{0};
+
+    std::atomic<size_t> uniqueCount_{0};
+    std::atomic<size_t> duplicateCount_{0};
+    std::atomic<size_t> spilledCount_{0};
+};
+
+} // namespace memchainer
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "common/block_compressor.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace memchainer {
+
+// 压缩结果文件格式:
+//   [文件头][帧头+帧数据]...[帧索引][文件尾]
+// 每一帧只包含完整的文本行并独立压缩，可以单独定位和解码。
+// 如果写入中断没有文件尾，读取端会顺序扫描帧头重建索引。
+
+#pragma pack(push, 1)
+struct ChainFileHeader {
+    char magic[4];         // "MCZ1"
+    uint16_t version;      // 格式版本
+    uint8_t codec;         // 默认压缩算法 (CompressionType)
+    uint8_t reserved;
+    uint32_t frameSize;    // 单帧原始数据上限
+};
+
+struct ChainFrameHeader {
+    uint32_t magic;          // FRAME_MAGIC
+    uint32_t rawSize;        // 原始长度
+    uint32_t compressedSize; // 压缩后长度
+    uint8_t codec;           // 本帧压缩算法（压缩无收益时为None）
+    uint8_t reserved[3];
+};
+
+struct ChainFrameIndexEntry {
+    uint64_t fileOffset;     // 帧头在文件中的偏移
+    uint32_t rawSize;
+    uint32_t compressedSize;
+};
+
+struct ChainFileFooter {
+    uint64_t indexOffset;    // 帧索引起始偏移
+    uint32_t frameCount;     // 帧数量
+    uint32_t magic;          // INDEX_MAGIC
+};
+#pragma pack(pop)
+
+// 分帧压缩的结果文件写入器（非线程安全，由调用方串行化）
+class ChainFileWriter {
+public:
+    static constexpr uint32_t FRAME_MAGIC = 0x5246434d; // "MCFR"
+    static constexpr uint32_t INDEX_MAGIC = 0x5849434d; // "MCIX"
+    static constexpr size_t DEFAULT_FRAME_SIZE = 1024 * 1024; // 1MB
+
+    explicit ChainFileWriter(CompressionType type, size_t frameSize = DEFAULT_FRAME_SIZE);
+    ~ChainFileWriter();
+
+    ChainFileWriter(const ChainFileWriter&) = delete;
+    ChainFileWriter& operator=(const ChainFileWriter&) = delete;
+
+    // 创建文件并写入文件头
+    bool open(const std::string& filename);
+
+    // 追加文本（调用方保证以完整行为单位）
+    bool append(const std::string& text);
+
+    // 写出剩余数据、帧索引和文件尾
+    bool close();
+
+    bool isOpen() const { return file_.is_open(); }
+
+    // 统计信息
+    uint64_t getRawBytes() const { return rawBytes_; }
+    uint64_t getWrittenBytes() const { return writtenBytes_; }
+
+private:
+    bool flushFrame();
+
+    CompressionType type_;
+    size_t frameSize_;
+    std::ofstream file_;
+    std::string pending_;
+    std::vector<uint8_t> compressed_;
+    std::vector<ChainFrameIndexEntry> frames_;
+    uint64_t rawBytes_ = 0;
+    uint64_t writtenBytes_ = 0;
+};
+
+// 分帧压缩结果文件读取器，readFrame 可被多个线程并发调用
+class ChainFileReader {
+public:
+    ChainFileReader();
+    ~ChainFileReader();
+
+    ChainFileReader(const ChainFileReader&) = delete;
+    ChainFileReader& operator=(const ChainFileReader&) = delete;
+
+    // 检查文件是否为分帧压缩格式
+    static bool isChainFile(const std::string& filename);
+
+    // 打开文件并加载帧索引
+    bool open(const std::string& filename);
+    void close();
+
+    size_t getFrameCount() const { return frames_.size(); }
+    const ChainFrameIndexEntry& getFrame(size_t index) const { return frames_[index]; }
+
+    // 解码单帧
+    bool readFrame(size_t index, std::string& out) const;
+
+    // 顺序解码全部帧
+    bool readAll(std::string& out) const;
+
+private:
+    bool loadIndexFromFooter(uint64_t fileSize);
+    bool rebuildIndexByScan(uint64_t fileSize);
+
+    int fd_;
+    std::vector<ChainFrameIndexEntry> frames_;
+};
+
+} // namespace memchainer
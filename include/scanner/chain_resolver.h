@@ -0,0 +1,111 @@
+#pragma once
+
+#include "memory/mem_access.h"
+#include "memory/mem_map.h"
+#include "memory/memory_cache.h"
+#include "scanner/chain_set.h"
+#include <memory>
+#include <vector>
+
+namespace memchainer {
+
+// 单条链的解析结果
+struct ResolvedChain {
+    Address address; // 最终地址
+    bool valid;      // 整条链是否解析成功
+};
+
+/**
+ * @brief 共享前缀的批量指针链解析器
+ *
+ * 把指针链集合编译成按 (模块, 静态偏移, 偏移1, 偏移2...) 组织的前缀树，
+ * 然后逐层解析：每一层所有需要读取的唯一地址合并为一次批量读取。
+ * 解析 N 条链的读取次数约等于唯一前缀的数量，而不是 N × 深度。
+ */
+class ChainResolver {
+public:
+    // 前缀树节点
+    struct Node {
+        Address address;       // 节点地址
+        Address value;         // 读取到的指针值（已去除高位标记）
+        uint64_t staticOffset; // 静态偏移（仅第0层）
+        uint32_t parent;       // 上一层节点下标（第0层为模块编号）
+        Offset offset;         // 相对父节点指针值的偏移（第0层不用）
+        bool needsRead;        // 有子节点，需要读取指针值
+        bool valid;            // 地址有效
+        bool readOk;           // 指针值读取成功
+    };
+
+    ChainResolver();
+    ~ChainResolver();
+
+    // 初始化解析器（memMap 可为空，此时必须通过 setModuleBases 指定模块基址）
+    bool initialize(const std::shared_ptr<MemoryAccess>& memAccess,
+                    const std::shared_ptr<MemoryMap>& memMap = nullptr);
+
+    // 设置内存缓存，设置后通过缓存读取（适合反复解析的场景）
+    void setMemoryCache(const std::shared_ptr<MemoryCache>& cache) { memoryCache_ = cache; }
+
+    // 编译全部链或指定下标的链
+    bool compile(const ChainSet& chains);
+    bool compile(const ChainSet& chains, const std::vector<uint32_t>& indices);
+
+    // 通过内存映射重新解析模块基址
+    void refreshModuleBases();
+
+    // 直接指定模块基址（下标为 ChainSet 的模块编号）
+    void setModuleBases(const std::vector<Address>& bases) { moduleBases_ = bases; }
+
+    // 解析所有已编译的链，results 与编译时的链一一对应
+    bool resolve(std::vector<ResolvedChain>& results);
+
+    // 去除指针高位标记（Android MTE/TBI 标记）
+    static Address stripPointerTag(Address value) {
+        if ((value & 0xffff000000000000) == 0xb400000000000000) {
+            value &= 0xffffffffffff;
+        }
+        return value;
+    }
+
+    // 统计信息
+    size_t getChainCount() const { return chainLeaves_.size(); }
+    size_t getNodeCount() const;
+    size_t getLastReadCount() const { return lastReadCount_; }
+    size_t getLevelCount() const { return levels_.size(); }
+
+protected:
+    // 计算第0层节点地址
+    void evaluateHeads();
+
+    // 读取第 level 层所有需要读取的节点，mask 不为空时只读取 mask 中置1的节点
+    size_t readLevel(size_t level, const std::vector<uint8_t>* mask = nullptr);
+
+    // 由第 level 层节点的值计算第 level+1 层节点地址
+    void propagateLevel(size_t level);
+
+    // 收集各链最终地址
+    void collectResults(std::vector<ResolvedChain>& results) const;
+
+    // 叶子位置：链在第 depth 层的节点
+    struct Leaf {
+        uint32_t level;
+        uint32_t index;
+    };
+
+    std::shared_ptr<MemoryAccess> memoryAccess_;
+    std::shared_ptr<MemoryMap> memoryMap_;
+    std::shared_ptr<MemoryCache> memoryCache_;
+
+    const ChainSet* chains_ = nullptr;
+    std::vector<std::vector<Node>> levels_;
+    std::vector<Leaf> chainLeaves_;
+    std::vector<Address> moduleBases_;
+    size_t lastReadCount_ = 0;
+
+    // 批量读取的临时缓冲区
+    std::vector<std::pair<Address, uint32_t>> pending_;
+    std::vector<ReadRequest> requests_;
+    std::vector<Address> values_;
+};
+
+} // namespace memchainer
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "common/types.h"
+#include "common/block_compressor.h"
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace memchainer {
+
+// 单条指针链的只读视图
+struct ChainView {
+    uint32_t moduleId;      // 模块名编号
+    uint64_t staticOffset;  // 相对模块起始地址的静态偏移
+    const Offset* offsets;  // 偏移序列（第一个为静态指针自身的偏移）
+    uint32_t depth;         // 偏移数量
+};
+
+/**
+ * @brief 紧凑的指针链集合
+ *
+ * 与扫描时的 PointerChainNode 链表不同，这里只保存能在新进程中重新解析链所需的信息：
+ * 模块名、静态偏移和偏移序列。所有偏移存放在一个连续数组中，模块名做驻留，
+ * 百万级的链也只占用很少的内存。
+ *
+ * 文本格式与 PointerFormatter::formatChainToSimple 一致：
+ *   模块名:+0x静态偏移->0x偏移1->0x偏移2...
+ */
+class ChainSet {
+public:
+    static constexpr uint32_t BINARY_MAGIC = 0x5343434d; // "MCCS"
+    static constexpr uint32_t BINARY_VERSION = 1;
+
+    ChainSet() = default;
+
+    // 链数量
+    size_t size() const { return chains_.size(); }
+    bool empty() const { return chains_.empty(); }
+    void clear();
+
+    // 模块名驻留
+    uint32_t internModule(const std::string& name);
+    const std::string& getModuleName(uint32_t moduleId) const { return modules_[moduleId]; }
+    size_t getModuleCount() const { return modules_.size(); }
+
+    // 添加指针链
+    void addChain(uint32_t moduleId, uint64_t staticOffset, const Offset* offsets, uint32_t depth);
+    void addChain(const std::list<PointerChainNode>& chain);
+    void addChain(const ChainSet& other, size_t index);
+
+    // 获取指针链
+    ChainView get(size_t index) const;
+
+    // 最大深度
+    uint32_t getMaxDepth() const { return maxDepth_; }
+
+    // 按 (模块, 静态偏移, 偏移序列) 字典序比较两条链
+    bool chainLess(size_t a, size_t b) const;
+
+    // 按 (模块, 静态偏移, 偏移序列) 字典序排列的链下标，共享前缀的链相邻
+    std::vector<uint32_t> sortedOrder() const;
+
+    // 解析单行文本，成功返回true（注释和分隔行返回false）
+    bool parseLine(const char* begin, const char* end);
+
+    // 格式化单条链
+    std::string formatChain(size_t index) const;
+
+    // 从文件加载，自动识别二进制、分帧压缩和纯文本格式
+    bool loadFromFile(const std::string& filename);
+
+    // 保存为二进制格式
+    bool saveBinary(const std::string& filename) const;
+
+    // 保存为文本格式（可选分帧压缩）
+    bool saveText(const std::string& filename, CompressionType compression = CompressionType::None) const;
+
+private:
+    struct ChainEntry {
+        uint64_t staticOffset;
+        uint32_t moduleId;
+        uint32_t offsetBegin; // offsets_ 中的起始下标
+        uint32_t depth;
+    };
+
+    bool loadText(const std::string& text);
+    bool loadBinary(const std::string& filename);
+
+    std::vector<std::string> modules_;
+    std::unordered_map<std::string, uint32_t> moduleIndex_;
+    std::vector<ChainEntry> chains_;
+    std::vector<Offset> offsets_;
+    uint32_t maxDepth_ = 0;
+};
+
+} // namespace memchainer
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "scanner/chain_resolver.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace memchainer {
+
+// 单条链的变化事件
+struct ChainChangeEvent {
+    uint32_t chainIndex;  // ChainSet 中的链下标
+    uint64_t tick;        // 发生变化的轮次
+    Address oldAddress;   // 变化前的最终地址
+    Address newAddress;   // 变化后的最终地址
+    Address oldValue;     // 变化前最终地址处的值
+    Address newValue;     // 变化后最终地址处的值
+    bool wasValid;        // 变化前是否解析成功
+    bool isValid;         // 变化后是否解析成功
+};
+
+// 单条链的稳定性统计
+struct ChainStability {
+    uint64_t changeCount = 0;   // 地址/值/有效性变化次数
+    uint64_t invalidTicks = 0;  // 解析失败的轮次
+    uint64_t stableTicks = 0;   // 当前连续未变化的轮次
+    uint64_t lastChangeTick = 0;
+};
+
+// 监视器整体统计
+struct WatchStats {
+    uint64_t ticks = 0;          // 已执行轮次
+    uint64_t fullRefreshes = 0;  // 全量刷新轮次
+    uint64_t totalReads = 0;     // 累计读取的唯一地址数
+    uint64_t totalEvents = 0;    // 累计变化事件数
+    uint64_t lastTickMicros = 0; // 最近一轮耗时
+};
+
+struct WatchOptions {
+    uint32_t fullRefreshInterval = 60; // 每隔多少轮全量刷新一次（0表示只在首轮全量读取）
+    bool watchValues = true;           // 同时监视最终地址处的值（按8字节读取）
+};
+
+/**
+ * @brief 高频指针链监视器
+ *
+ * 基于 ChainResolver 的前缀树逐层解析。每一轮只重新读取链头、叶子（监视值时）
+ * 和地址发生变化的节点：父节点的值没变时子节点地址不变，沿用上一轮的读取结果。
+ * 由于中间节点的值可能在父节点不变的情况下被修改，每隔 fullRefreshInterval 轮
+ * 做一次全量读取。
+ *
+ * 可以手动调用 tick()，也可以用 start() 在独立线程中按固定频率运行。
+ * 变化事件在每轮结束后通过回调批量投递，回调在监视线程中执行。
+ */
+class ChainWatcher : protected ChainResolver {
+public:
+    using ChangeCallback = std::function<void(const std::vector<ChainChangeEvent>& events)>;
+
+    ChainWatcher();
+    ~ChainWatcher();
+
+    using ChainResolver::initialize;
+    using ChainResolver::setMemoryCache;
+    using ChainResolver::setModuleBases;
+    using ChainResolver::getNodeCount;
+    using ChainResolver::getLevelCount;
+
+    // 设置监视的链（ChainSet 在监视期间必须保持有效）
+    bool watch(const ChainSet& chains, const std::vector<uint32_t>& indices,
+               const WatchOptions& options = WatchOptions());
+
+    // 设置变化回调
+    void setCallback(ChangeCallback callback);
+
+    // 执行一轮解析，返回本轮变化事件数
+    size_t tick();
+
+    // 在独立线程中按 hz 频率运行 / 停止
+    bool start(double hz);
+    void stop();
+    bool isRunning() const { return running_; }
+
+    // 统计信息
+    WatchStats getStats() const;
+    std::vector<ChainStability> getStability() const;
+    size_t getChainCount() const { return watched_.size(); }
+
+    // 当前解析结果（与 watch 时的 indices 一一对应）
+    std::vector<ResolvedChain> getResults() const;
+
+private:
+    // 单条链上一轮的状态
+    struct ChainState {
+        Address address;
+        Address value;
+        bool valid;
+    };
+
+    // 逐层解析，返回本轮读取的唯一地址数
+    size_t evaluateIncremental(bool fullRefresh);
+
+    // 对比上一轮状态，生成变化事件
+    void detectChanges(std::vector<ChainChangeEvent>& events);
+
+    void run(double hz);
+
+    mutable std::mutex mutex_;
+    WatchOptions options_;
+    ChangeCallback callback_;
+
+    std::vector<uint32_t> watched_;
+    std::vector<ChainState> states_;
+    std::vector<ChainStability> stability_;
+    WatchStats stats_;
+
+    // 每层节点上一轮的地址，以及本轮需要重新读取的掩码
+    std::vector<std::vector<Address>> lastAddress_;
+    std::vector<std::vector<uint8_t>> lastValid_;
+    std::vector<std::vector<uint8_t>> readMask_;
+    std::vector<std::vector<uint8_t>> leafMask_;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::mutex stopMutex_;
+    std::condition_variable stopCond_;
+};
+
+} // namespace memchainer
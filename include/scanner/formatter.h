@@ -1,6 +1,7 @@
 #pragma once
 
 #include "scanner/pointer_chain.h"
+#include "scanner/chain_file.h"
 #include <string>
 #include <memory>
 
@@ -26,6 +27,12 @@ public:
     // 初始化输出文件（写入文件头）
     bool initOutputFile(const std::string& filename);
 
+    // 关闭输出文件（压缩模式下写出剩余帧和帧索引）
+    bool closeOutputFile();
+
+    // 设置输出压缩方式，需在 initOutputFile 之前调用
+    void setCompression(CompressionType type) { compression_ = type; }
+
     // 设置输出格式
     void setFormat(const std::string& format) { format_ = format; }
 
@@ -64,6 +71,12 @@ private:
 
     // 是否显示静态偏移
     bool showStaticOffset_ = true;
+
+    // 输出压缩方式
+    CompressionType compression_ = CompressionType::None;
+
+    // 压缩模式下的流式写入器
+    std::unique_ptr<ChainFileWriter> writer_;
 };
 
 } // namespace memchainer
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "common/types.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace memchainer {
+
+// 指针表快照文件格式:
+//   [文件头][区域表][填充到页边界][按值排序的指针表]
+// 指针表页对齐，读取端直接映射后二分查找，无需重新收集和排序。
+// 文件头记录 PID、内存映射指纹和保存时间，用于判断快照是否过期。
+
+#pragma pack(push, 1)
+struct PointerTableHeader {
+    char magic[4];            // "MCPT"
+    uint16_t version;         // 格式版本
+    uint16_t reserved;
+    int32_t pid;              // 保存时的进程ID
+    uint32_t regionCount;     // 区域表条目数
+    uint64_t timestamp;       // 保存时间（Unix 秒）
+    uint64_t mapsFingerprint; // MemoryMap::getFingerprint()
+    uint64_t pointerCount;    // 指针数量
+    uint64_t regionOffset;    // 区域表偏移
+    uint64_t pointerOffset;   // 指针表偏移（页对齐）
+};
+
+struct PointerTableRegion {
+    uint64_t startAddress;
+    uint64_t endAddress;
+    int32_t type;
+    int32_t count;
+    uint8_t flags;            // REGION_SCANNED / REGION_STATIC
+    uint8_t reserved[7];
+    char name[128];
+};
+
+struct PointerTableEntry {
+    Address address;          // 指针地址
+    Address value;            // 指针值
+    uint32_t staticRegion;    // 所在静态区域在区域表中的下标+1，非静态指针为0
+    uint32_t reserved;
+};
+#pragma pack(pop)
+
+// 指针表快照写入器：先写区域表，再按值的顺序追加指针（调用方保证有序）
+class PointerTableWriter {
+public:
+    static constexpr uint8_t REGION_SCANNED = 1; // 收集指针时扫描的区域
+    static constexpr uint8_t REGION_STATIC = 2;  // 静态区域
+
+    PointerTableWriter();
+    ~PointerTableWriter();
+
+    PointerTableWriter(const PointerTableWriter&) = delete;
+    PointerTableWriter& operator=(const PointerTableWriter&) = delete;
+
+    // 创建文件，写入文件头占位和区域表
+    bool open(const std::string& filename, ProcessId pid, uint64_t fingerprint,
+              const std::vector<MemoryRegion*>& scanRegions,
+              const std::vector<MemoryRegion*>& staticRegions);
+
+    // 追加一个指针，staticRegion 为所在静态区域（非静态为空）
+    bool add(Address address, Address value, const MemoryRegion* staticRegion);
+
+    // 写出剩余指针并回填文件头
+    bool close();
+
+    uint64_t getPointerCount() const { return header_.pointerCount; }
+
+private:
+    bool flush();
+
+    std::ofstream file_;
+    PointerTableHeader header_{};
+    std::unordered_map<const MemoryRegion*, uint32_t> regionIndex_; // 区域 -> 区域表下标+1
+    std::vector<PointerTableEntry> buffer_;
+    Address lastValue_ = 0;
+};
+
+// 指针表快照读取器：映射整个文件，构建后只读，可被多个线程并发查询
+class PointerTableFile {
+public:
+    PointerTableFile();
+    ~PointerTableFile();
+
+    PointerTableFile(const PointerTableFile&) = delete;
+    PointerTableFile& operator=(const PointerTableFile&) = delete;
+
+    // 打开并映射文件，校验文件头
+    bool open(const std::string& filename);
+
+    const PointerTableHeader& getHeader() const { return header_; }
+    const std::vector<PointerTableRegion>& getRegions() const { return regions_; }
+
+    // 指针表
+    const PointerTableEntry* begin() const { return entries_; }
+    const PointerTableEntry* end() const { return entries_ + header_.pointerCount; }
+    size_t size() const { return static_cast<size_t>(header_.pointerCount); }
+
+    // 二分查找值在 [minValue, maxValue] 内的指针，返回 [first, last)
+    std::pair<const PointerTableEntry*, const PointerTableEntry*> findRange(Address minValue, Address maxValue) const;
+
+private:
+    void close();
+
+    PointerTableHeader header_{};
+    std::vector<PointerTableRegion> regions_;
+    const uint8_t* data_ = nullptr;
+    size_t mappedSize_ = 0;
+    const PointerTableEntry* entries_ = nullptr;
+};
+
+} // namespace memchainer
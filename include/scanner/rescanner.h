@@ -0,0 +1,66 @@
+#pragma once
+
+#include "memory/mem_access.h"
+#include "memory/mem_map.h"
+#include "scanner/chain_set.h"
+#include "scanner/chain_resolver.h"
+#include <memory>
+#include <vector>
+
+namespace memchainer {
+
+// 重扫描选项
+struct RescanOptions {
+    size_t chunkSize = 64 * 1024; // 每个任务处理的链数量
+};
+
+/**
+ * @brief 指针链重扫描器
+ *
+ * 重启目标进程后，用已有的指针链集合在新进程中逐条解析，
+ * 只保留仍然指向新目标地址的链。
+ *
+ * 链按字典序排列后切分成多个任务并行处理，每个任务用 ChainResolver
+ * 编译前缀树，共享前缀只读一次，每层合并为一次批量读取。
+ */
+class PointerRescanner {
+public:
+    struct RescanStats {
+        size_t inputChains = 0;       // 输入链数量
+        size_t survivingChains = 0;   // 保留的链数量
+        size_t unresolvedModules = 0; // 新进程中找不到的模块数量
+        size_t readsIssued = 0;       // 实际发出的读取次数
+        size_t readsShared = 0;       // 因共享前缀省掉的读取次数
+        int64_t elapsedMs = 0;        // 耗时
+    };
+
+    PointerRescanner();
+    ~PointerRescanner();
+
+    // 初始化重扫描器（memMap 需已调用 parseProcessModule）
+    bool initialize(const std::shared_ptr<MemoryAccess>& memAccess,
+                    const std::shared_ptr<MemoryMap>& memMap);
+
+    // 过滤指针链，返回保留的链数量
+    size_t rescan(const ChainSet& input, Address targetAddress, ChainSet& output,
+                  const RescanOptions& options = RescanOptions());
+
+    // 获取上一次重扫描的统计信息
+    const RescanStats& getStats() const { return stats_; }
+
+    // 在新进程中解析模块基址，找不到的模块为0
+    std::vector<Address> resolveModuleBases(const ChainSet& chains);
+
+private:
+    // 解析 order[begin, end) 范围内的链，保留的链在 survive 中置1
+    void evaluateRange(const ChainSet& chains, const std::vector<uint32_t>& order,
+                       size_t begin, size_t end, const std::vector<Address>& moduleBases,
+                       Address targetAddress, std::vector<uint8_t>& survive,
+                       size_t& readsIssued, size_t& readsShared) const;
+
+    std::shared_ptr<MemoryAccess> memoryAccess_;
+    std::shared_ptr<MemoryMap> memoryMap_;
+    RescanStats stats_;
+};
+
+} // namespace memchainer
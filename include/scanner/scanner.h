@@ -2,9 +2,14 @@
 
 #include "memory/mem_access.h"
 #include "memory/mem_map.h"
+#include "memory/file_cache.h"
+#include "scanner/pointer_table_file.h"
+#include "common/block_compressor.h"
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace memchainer {
@@ -19,6 +24,11 @@ public:
         uint32_t resultLimit = 1000; // 结果数量限制
         uint32_t batchSize = 10000;  // 处理批次大小
         uint32_t threadCount = 4;    // 线程数量
+        bool dedupChains = true;     // 是否对输出的指针链去重
+        size_t dedupMemoryLimit = 256 * 1024 * 1024; // 去重集合内存上限，超出后溢出到磁盘
+        CompressionType outputCompression = CompressionType::None; // 结果文件压缩方式
+        size_t memoryBudget = 0;     // 指针表内存预算（字节），0为不限制，超出后写入磁盘缓存
+        std::string cacheDir;        // 磁盘缓存目录，为空时使用系统临时目录
     };
 
     // 进度回调函数类型
@@ -33,6 +43,16 @@ public:
 
     // 查找指针
     uint32_t findPointers();
+    uint32_t findPointers(const ScanOptions& options);
+
+    // 指针表是否已写入磁盘缓存
+    bool isUsingFileCache() const { return useFileCache_; }
+
+    // 把已收集的指针表保存为快照（findPointers 之后调用）
+    bool savePointerTable(const std::string& path);
+
+    // 加载指针表快照代替 findPointers；PID 或内存映射变化时拒绝加载，除非 allowStale
+    bool loadPointerTable(const std::string& path, bool allowStale = false);
     
     // 扫描特定区域内的指针
     void scanRegionForPointers(Address startAddress, Address endAddress);
@@ -48,8 +68,11 @@ public:
         const std::string& outputFile = "");
 
 
-    // 判断地址是否在静态区域内
-    StaticOffset* calculateStaticOffset(Address addr);
+    // 判断地址是否在静态区域内，不在时 region 为空
+    StaticOffset calculateStaticOffset(Address addr) const;
+
+    // 地址所在的静态区域，不在静态区域时返回空（不加锁，只需要区域时使用）
+    const MemoryRegion* staticRegionAt(Address addr) const;
 
     // 检查地址是否有效
     bool isValidAddress(Address& addr);
@@ -57,12 +80,33 @@ public:
     // 获取指针链
     const std::vector<std::list<PointerChainNode>>& getChains() const { return chains_; }
     
-    // 使用哈希索引查找指向指定地址范围的所有指针
-    std::vector<PointerAllData*> findPointersInRange(Address startAddr, Address endAddr) const;
+    // 查找指向指定地址范围的所有指针（内存表二分查找，或查询磁盘缓存的范围索引）
+    std::vector<PointerAllData> findPointersInRange(Address startAddr, Address endAddr);
 
 private:
-    // 文件缓存系统
-    //std::shared_ptr<FileCache> fileCache_;
+    // 释放当前指针表（内存表、磁盘缓存和快照）
+    void resetPointerTable();
+
+    // 超出内存预算时把已收集的指针写入磁盘缓存
+    void spillToFileCache();
+
+    // 从快照加载的只读指针表
+    std::shared_ptr<const PointerTableFile> pointerTable_;
+
+    // 文件缓存系统（超出内存预算后启用）
+    std::shared_ptr<FileCache> fileCache_;
+    std::shared_ptr<const FileCacheLevel> cacheLevel_; // 构建完成的只读等级，搜索线程直接查询
+    std::atomic<bool> useFileCache_{false};
+    size_t memoryBudget_ = 0;
+    std::string cacheDir_;
+
+    // 按区域缓存的读取失败范围（键为区域起始地址），内存映射变化时清空
+    std::unordered_map<Address, FailedRangeSet> failedRanges_;
+    uint64_t failedRangesFingerprint_ = 0;
+    std::mutex failedRangesMutex_;
+
+    // 第0层指针（第0层节点引用其中的数据）
+    std::vector<PointerAllData> level0Pointers_;
     std::shared_ptr<MemoryAccess> memoryAccess_;
     std::shared_ptr<MemoryMap> memoryMap_;
     
@@ -0,0 +1,308 @@
+#include "common/block_compressor.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef MEMCHAINER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace memchainer {
+
+namespace {
+
+// LZ4块格式常量
+constexpr size_t kMinMatch = 4;
+constexpr size_t kLastLiterals = 5;   // 块末尾必须为字面量的字节数
+constexpr size_t kMatchFindLimit = 12; // 距离块末尾小于该值时不再查找匹配
+constexpr size_t kMaxDistance = 65535;
+constexpr int kHashLog = 14;
+
+inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t hashSequence(uint32_t seq) {
+    return (seq * 2654435761U) >> (32 - kHashLog);
+}
+
+// 写入LZ4变长长度（token 中的4位已经写满15之后的部分）
+inline uint8_t* writeLength(uint8_t* op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = static_cast<uint8_t>(len);
+    return op;
+}
+
+} // namespace
+
+bool BlockCompressor::isAvailable(CompressionType type) {
+    switch (type) {
+        case CompressionType::None:
+        case CompressionType::Fast:
+            return true;
+        case CompressionType::Zlib:
+#ifdef MEMCHAINER_HAVE_ZLIB
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+bool BlockCompressor::parseType(const std::string& name, CompressionType& type) {
+    if (name.empty() || name == "none") {
+        type = CompressionType::None;
+    } else if (name == "fast" || name == "lz4") {
+        type = CompressionType::Fast;
+    } else if (name == "zlib") {
+        type = CompressionType::Zlib;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* BlockCompressor::typeName(CompressionType type) {
+    switch (type) {
+        case CompressionType::None: return "none";
+        case CompressionType::Fast: return "fast";
+        case CompressionType::Zlib: return "zlib";
+    }
+    return "unknown";
+}
+
+size_t BlockCompressor::maxCompressedSize(CompressionType type, size_t rawSize) {
+    switch (type) {
+        case CompressionType::Fast:
+            return rawSize + rawSize / 255 + 16;
+        case CompressionType::Zlib:
+#ifdef MEMCHAINER_HAVE_ZLIB
+            return compressBound(static_cast<uLong>(rawSize));
+#else
+            return 0;
+#endif
+        case CompressionType::None:
+        default:
+            return rawSize;
+    }
+}
+
+bool BlockCompressor::compress(CompressionType type, const uint8_t* src, size_t srcSize,
+                               std::vector<uint8_t>& out) {
+    switch (type) {
+        case CompressionType::None:
+            out.assign(src, src + srcSize);
+            return true;
+
+        case CompressionType::Fast: {
+            out.resize(maxCompressedSize(type, srcSize));
+            size_t n = fastCompress(src, srcSize, out.data(), out.size());
+            if (n == 0 && srcSize != 0) {
+                return false;
+            }
+            out.resize(n);
+            return true;
+        }
+
+        case CompressionType::Zlib: {
+#ifdef MEMCHAINER_HAVE_ZLIB
+            uLongf destLen = compressBound(static_cast<uLong>(srcSize));
+            out.resize(destLen);
+            // 级别1：优先速度，写线程上的CPU开销可以忽略
+            if (compress2(out.data(), &destLen, src, static_cast<uLong>(srcSize), 1) != Z_OK) {
+                return false;
+            }
+            out.resize(destLen);
+            return true;
+#else
+            return false;
+#endif
+        }
+    }
+    return false;
+}
+
+bool BlockCompressor::decompress(CompressionType type, const uint8_t* src, size_t srcSize,
+                                 uint8_t* dst, size_t rawSize) {
+    switch (type) {
+        case CompressionType::None:
+            if (srcSize != rawSize) {
+                return false;
+            }
+            memcpy(dst, src, rawSize);
+            return true;
+
+        case CompressionType::Fast:
+            return fastDecompress(src, srcSize, dst, rawSize);
+
+        case CompressionType::Zlib: {
+#ifdef MEMCHAINER_HAVE_ZLIB
+            uLongf destLen = static_cast<uLongf>(rawSize);
+            if (uncompress(dst, &destLen, src, static_cast<uLong>(srcSize)) != Z_OK) {
+                return false;
+            }
+            return destLen == rawSize;
+#else
+            return false;
+#endif
+        }
+    }
+    return false;
+}
+
+size_t BlockCompressor::fastCompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity) {
+    if (dstCapacity < maxCompressedSize(CompressionType::Fast, srcSize)) {
+        return 0;
+    }
+
+    uint8_t* op = dst;
+    size_t anchor = 0;
+    size_t ip = 0;
+
+    // 哈希表保存位置+1，0表示空
+    std::vector<uint32_t> table(1u << kHashLog, 0);
+
+    auto emitSequence = [&](size_t literalEnd, size_t matchLen, size_t distance) {
+        size_t literalLen = literalEnd - anchor;
+        uint8_t* token = op++;
+        uint8_t tokenValue = 0;
+
+        if (literalLen >= 15) {
+            tokenValue = 15 << 4;
+            op = writeLength(op, literalLen - 15);
+        } else {
+            tokenValue = static_cast<uint8_t>(literalLen << 4);
+        }
+        memcpy(op, src + anchor, literalLen);
+        op += literalLen;
+
+        if (matchLen == 0) {
+            *token = tokenValue;
+            return;
+        }
+
+        *op++ = static_cast<uint8_t>(distance & 0xff);
+        *op++ = static_cast<uint8_t>(distance >> 8);
+
+        size_t extra = matchLen - kMinMatch;
+        if (extra >= 15) {
+            tokenValue |= 15;
+            op = writeLength(op, extra - 15);
+        } else {
+            tokenValue |= static_cast<uint8_t>(extra);
+        }
+        *token = tokenValue;
+    };
+
+    if (srcSize > kMatchFindLimit) {
+        const size_t matchLimit = srcSize - kMatchFindLimit;
+        const size_t matchEndLimit = srcSize - kLastLiterals;
+
+        while (ip < matchLimit) {
+            uint32_t seq = read32(src + ip);
+            uint32_t h = hashSequence(seq);
+            size_t ref = table[h];
+            table[h] = static_cast<uint32_t>(ip + 1);
+
+            if (ref == 0 || ip - (ref - 1) > kMaxDistance || read32(src + ref - 1) != seq) {
+                // 未命中：距离上次匹配越远步长越大，快速跳过不可压缩数据
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+            ref -= 1;
+
+            // 向后扩展匹配
+            size_t matchLen = kMinMatch;
+            while (ip + matchLen < matchEndLimit && src[ref + matchLen] == src[ip + matchLen]) {
+                matchLen++;
+            }
+
+            emitSequence(ip, matchLen, ip - ref);
+            ip += matchLen;
+            anchor = ip;
+        }
+    }
+
+    // 剩余部分全部作为字面量
+    emitSequence(srcSize, 0, 0);
+    return static_cast<size_t>(op - dst);
+}
+
+bool BlockCompressor::fastDecompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t rawSize) {
+    const uint8_t* ip = src;
+    const uint8_t* const iend = src + srcSize;
+    uint8_t* op = dst;
+    uint8_t* const oend = dst + rawSize;
+
+    auto readLength = [&](size_t& len) -> bool {
+        uint8_t b;
+        do {
+            if (ip >= iend) {
+                return false;
+            }
+            b = *ip++;
+            len += b;
+        } while (b == 255);
+        return true;
+    };
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+
+        // 字面量
+        size_t literalLen = token >> 4;
+        if (literalLen == 15 && !readLength(literalLen)) {
+            return false;
+        }
+        if (literalLen > static_cast<size_t>(iend - ip) || literalLen > static_cast<size_t>(oend - op)) {
+            return false;
+        }
+        memcpy(op, ip, literalLen);
+        ip += literalLen;
+        op += literalLen;
+
+        // 最后一个序列只有字面量
+        if (ip >= iend) {
+            break;
+        }
+
+        // 匹配
+        if (iend - ip < 2) {
+            return false;
+        }
+        size_t distance = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (distance == 0 || distance > static_cast<size_t>(op - dst)) {
+            return false;
+        }
+
+        size_t matchLen = token & 0x0f;
+        if (matchLen == 15 && !readLength(matchLen)) {
+            return false;
+        }
+        matchLen += kMinMatch;
+        if (matchLen > static_cast<size_t>(oend - op)) {
+            return false;
+        }
+
+        // 匹配可能与输出重叠，逐字节复制
+        const uint8_t* match = op - distance;
+        if (distance >= matchLen) {
+            memcpy(op, match, matchLen);
+            op += matchLen;
+        } else {
+            for (size_t i = 0; i < matchLen; ++i) {
+                *op++ = *match++;
+            }
+        }
+    }
+
+    return op == oend;
+}
+
+} // namespace memchainer
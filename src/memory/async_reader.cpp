@@ -0,0 +1,352 @@
+#include "memory/async_reader.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define MEMCHAINER_HAS_IO_URING 1
+#else
+#define MEMCHAINER_HAS_IO_URING 0
+#endif
+
+namespace memchainer {
+
+// ============================================================================
+// SyncReader
+// ============================================================================
+
+SyncReader::SyncReader(const MemoryAccess& memAccess, size_t depth)
+    : memAccess_(memAccess), depth_(depth > 0 ? depth : 1) {
+}
+
+bool SyncReader::submit(Address address, void* buffer, MemorySize size, uint64_t tag) {
+    if (completed_.size() >= depth_) {
+        return false;
+    }
+    std::error_code ec;
+    bool success = memAccess_.read(address, buffer, size, ec);
+    completed_.push_back(ReadCompletion{tag, address, buffer, size, success});
+    return true;
+}
+
+size_t SyncReader::reap(ReadCompletion* completions, size_t maxCount) {
+    size_t count = 0;
+    while (count < maxCount && !completed_.empty()) {
+        completions[count++] = completed_.front();
+        completed_.pop_front();
+    }
+    return count;
+}
+
+// ============================================================================
+// IoUringReader
+// ============================================================================
+
+struct IoUringReader::Slot {
+    struct iovec iov;
+    Address address;
+    MemorySize size;
+    uint64_t tag;
+};
+
+#if MEMCHAINER_HAS_IO_URING
+
+namespace {
+
+// 内核不支持或被 seccomp 禁止后不再尝试建立队列
+std::atomic<bool> ioUringUnavailable{false};
+
+// io_uring_enter 无法等待时检查完成队列的间隔（微秒）
+constexpr useconds_t WAIT_RETRY_US = 1000;
+
+int ioUringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+} // namespace
+
+struct IoUringReader::Ring {
+    int fd = -1;
+    void* sqRing = MAP_FAILED;
+    size_t sqRingSize = 0;
+    void* cqRing = MAP_FAILED;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned sqEntries = 0;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqesSize);
+        }
+        if (cqRing != MAP_FAILED && cqRing != sqRing) {
+            munmap(cqRing, cqRingSize);
+        }
+        if (sqRing != MAP_FAILED) {
+            munmap(sqRing, sqRingSize);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    bool setup(unsigned entries) {
+        io_uring_params params{};
+        fd = ioUringSetup(entries, &params);
+        if (fd < 0) {
+            return false;
+        }
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            return false;
+        }
+        cqRing = singleMap ? sqRing
+                           : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            return false;
+        }
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqeMap = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (sqeMap == MAP_FAILED) {
+            return false;
+        }
+        sqes = static_cast<io_uring_sqe*>(sqeMap);
+
+        auto* sq = static_cast<uint8_t*>(sqRing);
+        auto* cq = static_cast<uint8_t*>(cqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqEntries = params.sq_entries;
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+};
+
+#else
+
+struct IoUringReader::Ring {};
+
+#endif
+
+IoUringReader::IoUringReader(const MemoryAccess& memAccess, int memFd, std::unique_ptr<Ring> ring, size_t depth)
+    : memAccess_(memAccess), memFd_(memFd), ring_(std::move(ring)), slots_(depth) {
+    freeSlots_.reserve(depth);
+    for (size_t i = depth; i > 0; --i) {
+        freeSlots_.push_back(static_cast<uint32_t>(i - 1));
+    }
+}
+
+IoUringReader::~IoUringReader() {
+#if MEMCHAINER_HAS_IO_URING
+    // 等待内核完成已提交的读取，避免写入已释放的缓冲区（inFlight_ 不为 0 时 reap 总会返回完成项）
+    std::vector<ReadCompletion> drained(slots_.size());
+    while (inFlight_ > 0 && reap(drained.data(), drained.size()) > 0) {
+    }
+#endif
+    ring_.reset();
+    if (memFd_ >= 0) {
+        close(memFd_);
+    }
+}
+
+std::unique_ptr<IoUringReader> IoUringReader::create(const MemoryAccess& memAccess, ProcessId pid, size_t depth) {
+#if MEMCHAINER_HAS_IO_URING
+    if (pid <= 0 || depth == 0 || ioUringUnavailable.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+
+    char memPath[64];
+    snprintf(memPath, sizeof(memPath), "/proc/%d/mem", pid);
+    int memFd = open(memPath, O_RDONLY | O_CLOEXEC);
+    if (memFd < 0) {
+        return nullptr;
+    }
+
+    auto ring = std::make_unique<Ring>();
+    if (!ring->setup(static_cast<unsigned>(depth))) {
+        if (errno == ENOSYS || errno == EPERM || errno == EACCES) {
+            if (!ioUringUnavailable.exchange(true)) {
+                std::cerr << "io_uring 不可用（" << strerror(errno) << "），使用同步读取\n";
+            }
+        }
+        close(memFd);
+        return nullptr;
+    }
+
+    // 队列深度不超过内核实际分配的提交队列大小
+    depth = std::min<size_t>(depth, ring->sqEntries);
+    return std::unique_ptr<IoUringReader>(new IoUringReader(memAccess, memFd, std::move(ring), depth));
+#else
+    (void)memAccess;
+    (void)pid;
+    (void)depth;
+    return nullptr;
+#endif
+}
+
+bool IoUringReader::submit(Address address, void* buffer, MemorySize size, uint64_t tag) {
+#if MEMCHAINER_HAS_IO_URING
+    if (failed_ || freeSlots_.empty()) {
+        return false;
+    }
+    uint32_t index = freeSlots_.back();
+    freeSlots_.pop_back();
+
+    Slot& slot = slots_[index];
+    slot.iov.iov_base = buffer;
+    slot.iov.iov_len = size;
+    slot.address = address;
+    slot.size = size;
+    slot.tag = tag;
+
+    // 只有本线程写提交队列尾，内核推进队列头
+    unsigned tail = *ring_->sqTail;
+    unsigned sqIndex = tail & ring_->sqMask;
+    io_uring_sqe* sqe = &ring_->sqes[sqIndex];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = memFd_;
+    sqe->off = address;
+    sqe->addr = reinterpret_cast<uint64_t>(&slot.iov);
+    sqe->len = 1;
+    sqe->user_data = index;
+    ring_->sqArray[sqIndex] = sqIndex;
+    __atomic_store_n(ring_->sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    toSubmit_++;
+    inFlight_++;
+    return true;
+#else
+    (void)address;
+    (void)buffer;
+    (void)size;
+    (void)tag;
+    return false;
+#endif
+}
+
+#if MEMCHAINER_HAS_IO_URING
+
+void IoUringReader::withdrawUnsubmitted() {
+    // 没有 SQPOLL 时内核只在 io_uring_enter 中取走请求，队列头之后的都未下发，可以直接回退队列尾
+    unsigned head = __atomic_load_n(ring_->sqHead, __ATOMIC_ACQUIRE);
+    unsigned tail = *ring_->sqTail;
+    for (unsigned i = head; i != tail; ++i) {
+        const io_uring_sqe& sqe = ring_->sqes[ring_->sqArray[i & ring_->sqMask]];
+        syncSlots_.push_back(static_cast<uint32_t>(sqe.user_data));
+    }
+    __atomic_store_n(ring_->sqTail, head, __ATOMIC_RELEASE);
+    toSubmit_ = 0;
+}
+
+#endif
+
+size_t IoUringReader::reap(ReadCompletion* completions, size_t maxCount) {
+#if MEMCHAINER_HAS_IO_URING
+    size_t count = 0;
+    while (inFlight_ > 0 && count == 0 && maxCount > 0) {
+        // 队列出错后撤回的请求同步完成
+        while (!syncSlots_.empty() && count < maxCount) {
+            uint32_t index = syncSlots_.back();
+            syncSlots_.pop_back();
+            const Slot& slot = slots_[index];
+            std::error_code ec;
+            bool success = memAccess_.read(slot.address, slot.iov.iov_base, slot.size, ec);
+            completions[count++] = ReadCompletion{slot.tag, slot.address, slot.iov.iov_base, slot.size, success};
+            freeSlots_.push_back(index);
+            inFlight_--;
+        }
+        if (count > 0 || inFlight_ == 0) {
+            break;
+        }
+
+        // 下发积累的请求，没有已完成项时等待至少一个
+        unsigned head = *ring_->cqHead;
+        bool ready = head != __atomic_load_n(ring_->cqTail, __ATOMIC_ACQUIRE);
+        if (toSubmit_ > 0 || !ready) {
+            int ret = ioUringEnter(ring_->fd, toSubmit_, ready ? 0 : 1, IORING_ENTER_GETEVENTS);
+            if (ret < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                    continue;
+                }
+                if (!failed_) {
+                    // 不再提交：未下发的请求同步完成，已下发的继续等待内核完成
+                    std::cerr << "io_uring 提交失败: " << strerror(errno) << "，改用同步读取\n";
+                    failed_ = true;
+                    withdrawUnsubmitted();
+                } else {
+                    // 等待也失败：已下发的读取仍可能写入缓冲区，不能交还；稍后直接检查完成队列
+                    // （休眠的系统调用返回时内核会投递完成项）
+                    usleep(WAIT_RETRY_US);
+                }
+                continue;
+            }
+            toSubmit_ -= std::min<unsigned>(toSubmit_, static_cast<unsigned>(ret));
+        }
+
+        // 按完成顺序取回
+        head = *ring_->cqHead;
+        unsigned tail = __atomic_load_n(ring_->cqTail, __ATOMIC_ACQUIRE);
+        while (head != tail && count < maxCount) {
+            const io_uring_cqe& cqe = ring_->cqes[head & ring_->cqMask];
+            uint32_t index = static_cast<uint32_t>(cqe.user_data);
+            const Slot& slot = slots_[index];
+
+            // 读取失败或不完整时用原有方式重试（process_vm_readv 可读取部分 /proc/pid/mem 读不到的页）
+            bool success = cqe.res == static_cast<int>(slot.size);
+            if (!success) {
+                std::error_code ec;
+                success = memAccess_.read(slot.address, slot.iov.iov_base, slot.size, ec);
+            }
+            completions[count++] = ReadCompletion{slot.tag, slot.address, slot.iov.iov_base, slot.size, success};
+
+            freeSlots_.push_back(index);
+            inFlight_--;
+            head++;
+        }
+        __atomic_store_n(ring_->cqHead, head, __ATOMIC_RELEASE);
+    }
+    return count;
+#else
+    (void)completions;
+    (void)maxCount;
+    return 0;
+#endif
+}
+
+} // namespace memchainer
@@ -0,0 +1,186 @@
+#include "memory/elf_module.h"
+#include <elf.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+
+namespace memchainer {
+
+namespace {
+
+constexpr size_t MAX_PROGRAM_HEADERS = 256;
+constexpr size_t MAX_SECTION_HEADERS = 8192;
+constexpr size_t MAX_NOTE_SIZE = 4096;
+constexpr size_t MAX_SHSTRTAB_SIZE = 1024 * 1024;
+
+bool readAt(int fd, uint64_t offset, void* buffer, size_t size) {
+    uint8_t* out = static_cast<uint8_t*>(buffer);
+    while (size > 0) {
+        ssize_t n = pread(fd, out, size, static_cast<off_t>(offset));
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        out += n;
+        offset += n;
+        size -= n;
+    }
+    return true;
+}
+
+int segmentProt(uint32_t flags) {
+    return ((flags & PF_R) ? PROT_READ : 0) | ((flags & PF_W) ? PROT_WRITE : 0) | ((flags & PF_X) ? PROT_EXEC : 0);
+}
+
+// 在注释段中查找 GNU 构建 ID
+template <typename Nhdr>
+std::string findBuildId(const uint8_t* data, size_t size) {
+    size_t pos = 0;
+    while (pos + sizeof(Nhdr) <= size) {
+        Nhdr note;
+        memcpy(&note, data + pos, sizeof(note));
+        pos += sizeof(note);
+        size_t nameSize = (note.n_namesz + 3) & ~size_t(3);
+        size_t descSize = (note.n_descsz + 3) & ~size_t(3);
+        if (nameSize > size - pos || descSize > size - pos - nameSize) {
+            break;
+        }
+        if (note.n_type == NT_GNU_BUILD_ID && note.n_namesz == 4 && memcmp(data + pos, "GNU", 4) == 0) {
+            static const char digits[] = "0123456789abcdef";
+            std::string id;
+            const uint8_t* desc = data + pos + nameSize;
+            for (size_t i = 0; i < note.n_descsz; ++i) {
+                id += digits[desc[i] >> 4];
+                id += digits[desc[i] & 0xF];
+            }
+            return id;
+        }
+        pos += nameSize + descSize;
+    }
+    return std::string();
+}
+
+template <typename Ehdr, typename Phdr, typename Shdr, typename Nhdr>
+bool parseElf(int fd, uint64_t base, ElfModule& module) {
+    Ehdr header;
+    if (!readAt(fd, base, &header, sizeof(header)) || header.e_phentsize != sizeof(Phdr) ||
+        header.e_phnum == 0 || header.e_phnum > MAX_PROGRAM_HEADERS) {
+        return false;
+    }
+
+    std::vector<Phdr> programs(header.e_phnum);
+    if (!readAt(fd, base + header.e_phoff, programs.data(), programs.size() * sizeof(Phdr))) {
+        return false;
+    }
+
+    std::vector<uint8_t> note;
+    for (const Phdr& program : programs) {
+        if (program.p_type == PT_LOAD) {
+            module.loads.push_back({program.p_vaddr, program.p_offset, program.p_filesz, program.p_memsz,
+                                    segmentProt(program.p_flags)});
+            module.imageEnd = std::max<Address>(module.imageEnd, program.p_vaddr + program.p_memsz);
+        } else if (program.p_type == PT_NOTE && module.buildId.empty() &&
+                   program.p_filesz > 0 && program.p_filesz <= MAX_NOTE_SIZE) {
+            note.resize(program.p_filesz);
+            if (readAt(fd, base + program.p_offset, note.data(), note.size())) {
+                module.buildId = findBuildId<Nhdr>(note.data(), note.size());
+            }
+        }
+    }
+    if (module.loads.empty()) {
+        return false;
+    }
+
+    // 节区头：取 .data / .data.rel.ro / .bss
+    if (header.e_shoff != 0 && header.e_shentsize == sizeof(Shdr) && header.e_shnum > 0 &&
+        header.e_shnum <= MAX_SECTION_HEADERS && header.e_shstrndx < header.e_shnum) {
+        std::vector<Shdr> sections(header.e_shnum);
+        std::vector<char> names;
+        if (readAt(fd, base + header.e_shoff, sections.data(), sections.size() * sizeof(Shdr))) {
+            const Shdr& strtab = sections[header.e_shstrndx];
+            if (strtab.sh_size > 0 && strtab.sh_size <= MAX_SHSTRTAB_SIZE) {
+                names.resize(strtab.sh_size + 1, '\0');
+                if (!readAt(fd, base + strtab.sh_offset, names.data(), strtab.sh_size)) {
+                    names.clear();
+                }
+            }
+        }
+        for (const Shdr& section : sections) {
+            if (names.empty() || section.sh_name >= names.size() - 1 || !(section.sh_flags & SHF_ALLOC) ||
+                section.sh_size == 0) {
+                continue;
+            }
+            const char* name = names.data() + section.sh_name;
+            int type = 0;
+            if (strcmp(name, ".bss") == 0) {
+                type = MemoryRegionType::C_bss;
+            } else if (strcmp(name, ".data") == 0 || strcmp(name, ".data.rel.ro") == 0) {
+                type = MemoryRegionType::C_data;
+            }
+            if (type) {
+                module.staticRanges.push_back({section.sh_addr, section.sh_addr + section.sh_size, type});
+            }
+        }
+    }
+
+    // 节区头被裁掉：可写段文件内部分视为 .data，其余为 .bss
+    if (module.staticRanges.empty()) {
+        for (const ElfSegment& segment : module.loads) {
+            if (!(segment.prot & PROT_WRITE)) {
+                continue;
+            }
+            if (segment.fileSize > 0) {
+                module.staticRanges.push_back({segment.vaddr, segment.vaddr + segment.fileSize, MemoryRegionType::C_data});
+            }
+            if (segment.memSize > segment.fileSize) {
+                module.staticRanges.push_back({segment.vaddr + segment.fileSize, segment.vaddr + segment.memSize,
+                                               MemoryRegionType::C_bss});
+            }
+        }
+    }
+
+    std::sort(module.staticRanges.begin(), module.staticRanges.end(),
+              [](const ElfStaticRange& a, const ElfStaticRange& b) { return a.start < b.start; });
+    return true;
+}
+
+} // namespace
+
+bool ElfModule::parse(int fd, uint64_t offset) {
+    unsigned char ident[EI_NIDENT];
+    if (!readAt(fd, offset, ident, sizeof(ident)) || memcmp(ident, ELFMAG, SELFMAG) != 0 ||
+        ident[EI_DATA] != ELFDATA2LSB) {
+        return false;
+    }
+
+    fileOffset = offset;
+    buildId.clear();
+    loads.clear();
+    staticRanges.clear();
+    imageEnd = 0;
+    if (ident[EI_CLASS] == ELFCLASS64) {
+        return parseElf<Elf64_Ehdr, Elf64_Phdr, Elf64_Shdr, Elf64_Nhdr>(fd, offset, *this);
+    }
+    if (ident[EI_CLASS] == ELFCLASS32) {
+        return parseElf<Elf32_Ehdr, Elf32_Phdr, Elf32_Shdr, Elf32_Nhdr>(fd, offset, *this);
+    }
+    return false;
+}
+
+bool ElfModule::computeLoadBias(Address mappingStart, uint64_t mappingOffset, uint64_t mappingSize) {
+    // 映射中 ELF 偏移 X 处的字节位于 mappingStart + (X - mappingOffset)，
+    // 所在段的链接地址为 p_vaddr + (X - p_offset)，两者之差即加载基址
+    for (const ElfSegment& segment : loads) {
+        if (segment.offset >= mappingOffset && segment.offset < mappingOffset + mappingSize) {
+            loadBias = mappingStart + (segment.offset - mappingOffset) - segment.vaddr;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace memchainer
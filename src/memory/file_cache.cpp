@@ -1,23 +1,118 @@
 #include "memory/file_cache.h"
+#include "common/thread_pool.h"
 #include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
+#include <cerrno>
+#include <cstdint>
 #include <cstring>
 #include <chrono>
+#include <future>
+#include <queue>
+#include <tuple>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 namespace memchainer {
 
+namespace {
+
+// 查询涉及的压缩数据超过此大小时提示内核预读
+constexpr size_t WILLNEED_THRESHOLD = 256 * 1024;
+
+// 单个条目编码后的最大字节数（两个64位 varint + 一个32位 varint）
+constexpr size_t MAX_ENCODED_ENTRY = 10 + 10 + 5;
+
+inline uint64_t zigzagEncode(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+inline void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+inline bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 把按 (值, 地址) 排序的条目编码为一个压缩块，块内首个值相对 startValue 编码
+void encodeBlock(const std::vector<PointerCacheEntry>& entries, Address startValue, std::vector<uint8_t>& out) {
+    Address prevValue = startValue;
+    Address prevAddress = 0;
+    for (const auto& entry : entries) {
+        putVarint(out, entry.value - prevValue);
+        putVarint(out, zigzagEncode(static_cast<int64_t>(entry.address - prevAddress)));
+        putVarint(out, zigzagEncode(entry.offset));
+        prevValue = entry.value;
+        prevAddress = entry.address;
+    }
+}
+
+// 解码压缩块，只输出值在 [minValue, maxValue] 内的条目；值超过 maxValue 后停止
+// limit 不为 SIZE_MAX 时只解码到第 limit 个条目并通过 single 返回
+bool decodeBlock(const uint8_t* data, const RangeEntry& range, Address minValue, Address maxValue,
+                 std::vector<PointerCacheEntry>* results, size_t limit = SIZE_MAX,
+                 PointerCacheEntry* single = nullptr) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + range.byteSize;
+    Address value = range.startValue;
+    Address address = 0;
+    for (int64_t i = 0; i < range.entryCount; ++i) {
+        uint64_t valueDelta = 0;
+        uint64_t addressDelta = 0;
+        uint64_t offset = 0;
+        if (!getVarint(p, end, valueDelta) || !getVarint(p, end, addressDelta) || !getVarint(p, end, offset)) {
+            return false;
+        }
+        value += valueDelta;
+        address += static_cast<Address>(zigzagDecode(addressDelta));
+        
+        if (static_cast<size_t>(i) == limit) {
+            *single = PointerCacheEntry{address, value, static_cast<Offset>(zigzagDecode(offset))};
+            return true;
+        }
+        if (value > maxValue) {
+            break;
+        }
+        if (results && value >= minValue) {
+            results->push_back(PointerCacheEntry{address, value, static_cast<Offset>(zigzagDecode(offset))});
+        }
+    }
+    return limit == SIZE_MAX;
+}
+
+} // namespace
+
 FileCache::FileCache() 
     : currentLevel_(-1), currentLevelPointerCount_(0) {
 }
 
 FileCache::~FileCache() {
-    if (dataFile_.is_open()) {
-        dataFile_.close();
+    defaultProducer_.reset();
+    if (dataFd_ >= 0) {
+        close(dataFd_);
     }
 }
 
@@ -62,26 +157,29 @@ bool FileCache::beginWriteCache(int level) {
     std::lock_guard<std::mutex> lock(mutex_);
     
     // 关闭之前的文件（如果有）
-    if (dataFile_.is_open()) {
-        dataFile_.close();
+    defaultProducer_.reset();
+    if (dataFd_ >= 0) {
+        close(dataFd_);
+        dataFd_ = -1;
     }
+    std::atomic_store(&level_, std::shared_ptr<const FileCacheLevel>());
     
     currentLevel_ = level;
     currentLevelPointerCount_ = 0;
+    writeOffset_ = 0;
+    writeFailed_ = false;
     
     // 创建新的数据文件
     std::string filePath = getTempFilePath(level);
-    dataFile_.open(filePath, std::ios::binary | std::ios::out);
-    if (!dataFile_) {
+    dataFd_ = open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (dataFd_ < 0) {
         std::cerr << "无法创建缓存文件: " << filePath << std::endl;
         return false;
     }
     
-    // 设置文件缓冲区
-    dataFile_.rdbuf()->pubsetbuf(new char[FILE_BUFFER_SIZE], FILE_BUFFER_SIZE);
-    
     // 记录文件路径
     dataFiles_[level] = filePath;
+    defaultProducer_ = std::make_unique<CacheProducer>(this);
     
     std::cout << "开始缓存层级 " << level << " 的指针数据" << std::endl;
     
@@ -89,28 +187,48 @@ bool FileCache::beginWriteCache(int level) {
 }
 
 bool FileCache::addPointerToCache(Address address, Address value, Offset offset) {
-    if (!dataFile_.is_open()) {
+    if (!defaultProducer_) {
+        return false;
+    }
+    return defaultProducer_->add(address, value, offset);
+}
+
+bool FileCache::appendBlock(const PointerCacheEntry* entries, size_t count) {
+    if (dataFd_ < 0) {
         return false;
     }
     
-    // 写入指针数据
-    PointerCacheEntry entry{address, value, offset};
-    dataFile_.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    // 原子预留文件区间，各生产者的写入互不重叠，无需加锁
+    size_t bytes = count * sizeof(PointerCacheEntry);
+    uint64_t offset = writeOffset_.fetch_add(bytes, std::memory_order_relaxed);
     
-    if (!dataFile_) {
-        std::cerr << "写入缓存数据失败" << std::endl;
-        return false;
+    const char* data = reinterpret_cast<const char*>(entries);
+    size_t written = 0;
+    while (written < bytes) {
+        ssize_t n = pwrite(dataFd_, data + written, bytes - written, static_cast<off_t>(offset + written));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            // 预留的区间已无法填满，整个等级作废
+            if (!writeFailed_.exchange(true)) {
+                std::cerr << "写入缓存数据失败: " << strerror(errno) << std::endl;
+            }
+            return false;
+        }
+        written += static_cast<size_t>(n);
     }
     
-    currentLevelPointerCount_++;
+    size_t before = currentLevelPointerCount_.fetch_add(count, std::memory_order_relaxed);
+    size_t after = before + count;
     
     // 每百万个指针显示一次进度
-    if (currentLevelPointerCount_ % 1000000 == 0) {
-        std::cout << "已缓存 " << (currentLevelPointerCount_ / 1000000) << "M 个指针" << std::endl;
+    if (before / 1000000 != after / 1000000) {
+        std::cout << "已缓存 " << (after / 1000000) << "M 个指针" << std::endl;
         
         // 调用进度回调（如果有）
         if (progressCallback_) {
-            progressCallback_(static_cast<float>(currentLevelPointerCount_) / 
+            progressCallback_(static_cast<float>(after) / 
                              static_cast<float>(std::numeric_limits<size_t>::max()));
         }
     }
@@ -121,15 +239,24 @@ bool FileCache::addPointerToCache(Address address, Address value, Offset offset)
 bool FileCache::endWriteCache() {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    if (!dataFile_.is_open()) {
+    if (dataFd_ < 0) {
         return false;
     }
     
-    // 确保所有数据都写入文件
-    dataFile_.flush();
+    // 写出默认生产者中剩余的数据（其他生产者应已在此之前析构或 flush）
+    if (defaultProducer_) {
+        defaultProducer_->flush();
+        defaultProducer_.reset();
+    }
     
     // 关闭文件
-    dataFile_.close();
+    close(dataFd_);
+    dataFd_ = -1;
+    
+    if (writeFailed_) {
+        std::cerr << "缓存数据写入不完整，放弃构建索引" << std::endl;
+        return false;
+    }
     
     // 构建索引
     if (!buildRangeIndex()) {
@@ -137,535 +264,253 @@ bool FileCache::endWriteCache() {
         return false;
     }
     
+    // 发布只读等级，之后的查询不再经过 mutex_
+    auto level = std::make_shared<FileCacheLevel>(currentLevel_, std::move(rangeIndex_));
+    rangeIndex_.clear();
+    if (!level->open(dataFiles_[currentLevel_])) {
+        return false;
+    }
+    std::atomic_store(&level_, std::shared_ptr<const FileCacheLevel>(level));
+    
     std::cout << "层级 " << currentLevel_ << " 的指针数据缓存完成，共 " 
               << currentLevelPointerCount_ << " 个指针" << std::endl;
     
     return true;
 }
 
-bool FileCache::findPointersInRange_(Address minValue, Address maxValue) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    // 检查文件路径是否有效
-    std::string filePath = dataFiles_[currentLevel_];
-    if (filePath.empty()) {
-        std::cerr << "无效的缓存文件路径" << std::endl;
-        return false;
+CacheProducer::CacheProducer(FileCache* cache)
+    : cache_(cache) {
+    buffer_.reserve(BLOCK_ENTRIES);
+}
+
+CacheProducer::~CacheProducer() {
+    flush();
+}
+
+bool CacheProducer::flush() {
+    if (buffer_.empty()) {
+        return true;
     }
-    
-    // 检查索引是否已加载
-    if (rangeIndex_.empty()) {
-        if (!loadIndex(currentLevel_)) {
-            std::cerr << "加载范围索引失败" << std::endl;
-            return false;
-        }
+    bool success = cache_ && cache_->appendBlock(buffer_.data(), buffer_.size());
+    buffer_.clear();
+    return success;
+}
+
+FileCacheLevel::FileCacheLevel(int level, std::vector<RangeEntry> rangeIndex)
+    : level_(level), rangeIndex_(std::move(rangeIndex)) {
+    blockFirst_.reserve(rangeIndex_.size());
+    for (const auto& range : rangeIndex_) {
+        blockFirst_.push_back(count_);
+        count_ += static_cast<size_t>(range.entryCount);
     }
-    
-    // 查找匹配的范围
-    std::vector<RangeEntry> matchedRanges;
-    
-    // 使用二分查找找到第一个可能包含minValue的范围
-    auto startIt = std::lower_bound(rangeIndex_.begin(), rangeIndex_.end(), minValue,
-                                  [](const RangeEntry& entry, Address value) {
-                                      return entry.endValue < value;
-                                  });
-    
-    // 使用二分查找找到最后一个可能包含maxValue的范围
-    auto endIt = std::upper_bound(rangeIndex_.begin(), rangeIndex_.end(), maxValue,
-                                [](Address value, const RangeEntry& entry) {
-                                    return value < entry.startValue;
-                                });
-    
-    // 收集所有匹配的范围
-    for (auto it = startIt; it != endIt; ++it) {
-        matchedRanges.push_back(*it);
+}
+
+FileCacheLevel::~FileCacheLevel() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), fileSize_);
     }
-    
-    // 没有找到匹配的范围，但这不是错误
-    if (matchedRanges.empty()) {
-        std::cout << "未找到值范围 [" << std::hex << minValue << " - " 
-                 << maxValue << std::dec << "] 的指针" << std::endl;
-        return true;
+    if (fd_ >= 0) {
+        close(fd_);
     }
-    
-    // 打开数据文件
-    std::ifstream dataFile(filePath, std::ios::binary | std::ios::in);
-    if (!dataFile) {
+}
+
+bool FileCacheLevel::open(const std::string& filePath) {
+    fd_ = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
         std::cerr << "无法打开缓存文件: " << filePath << std::endl;
         return false;
     }
     
-    // 获取文件大小
-    dataFile.seekg(0, std::ios::end);
-    size_t fileSize = dataFile.tellg();
-    dataFile.seekg(0, std::ios::beg);
-    
-    // 文件太小，无法包含任何条目
-    if (fileSize < sizeof(PointerCacheEntry)) {
-        std::cerr << "缓存文件大小异常: " << fileSize << " 字节" << std::endl;
+    struct stat st{};
+    if (fstat(fd_, &st) != 0) {
         return false;
     }
     
-    // 设置文件缓冲区
-    char* buffer = new char[FILE_BUFFER_SIZE];
-    dataFile.rdbuf()->pubsetbuf(buffer, FILE_BUFFER_SIZE);
-    
-    bool success = true;
-    
-    // 从每个匹配的范围中读取数据
-    for (const auto& range : matchedRanges) {
-        if (range.entryCount <= 0) {
-            continue; // 跳过空范围
-        }
-        
-        // 检查文件偏移是否有效
-        if (range.fileOffset < 0) {
-            std::cerr << "无效的文件偏移: " << range.fileOffset << std::endl;
-            continue;
-        }
-        
-        // 安全检查：确保要读取的数据不会超出文件范围
-        size_t rangeEndOffset = range.fileOffset + range.entryCount * sizeof(PointerCacheEntry);
-        if (rangeEndOffset > fileSize) {
-            std::cerr << "范围超出文件大小: 范围结束于 " << rangeEndOffset 
-                     << "，文件大小为 " << fileSize << std::endl;
-            success = false;
-            continue;
-        }
-        
-        // 跳转到范围的起始位置
-        dataFile.seekg(range.fileOffset);
-        if (dataFile.fail()) {
-            std::cerr << "跳转到文件位置失败: " << range.fileOffset << std::endl;
-            dataFile.clear(); // 清除错误状态
-            success = false;
-            continue;
-        }
-        
-        // 分配足够大的缓冲区
-        std::vector<PointerCacheEntry> rangeEntries;
-        try {
-            rangeEntries.resize(range.entryCount);
-        } catch (const std::exception& e) {
-            std::cerr << "无法分配内存用于读取范围条目: " << e.what() 
-                     << "，条目数: " << range.entryCount << std::endl;
-            success = false;
-            continue;
-        }
-        
-        // 读取范围内的所有条目
-        dataFile.read(reinterpret_cast<char*>(rangeEntries.data()), 
-                     range.entryCount * sizeof(PointerCacheEntry));
-        
-        if (dataFile.fail()) {
-            std::cerr << "读取范围内容失败，范围: [" << std::hex << range.startValue << " - " 
-                      << range.endValue << std::dec << "], 偏移: " << range.fileOffset 
-                      << ", 条目数: " << range.entryCount << std::endl;
-            dataFile.clear(); // 清除错误状态
-            success = false;
-            continue;
-        }
-        
-        // 过滤满足条件的条目
-        for (const auto& entry : rangeEntries) {
-            if (entry.value >= minValue && entry.value <= maxValue) {
-                currentSearchResults_.push_back(entry);
-            }
+    fileSize_ = static_cast<size_t>(st.st_size);
+    if (!rangeIndex_.empty()) {
+        const RangeEntry& last = rangeIndex_.back();
+        if (static_cast<size_t>(last.fileOffset + last.byteSize) > fileSize_) {
+            std::cerr << "缓存文件与范围索引不一致: " << filePath << std::endl;
+            return false;
         }
     }
+    if (fileSize_ == 0) {
+        return true;
+    }
     
-    dataFile.close();
-    delete[] buffer;
+    // 映射失败时保留文件描述符，查询改用 pread
+    void* addr = mmap(nullptr, fileSize_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {
+        std::cerr << "映射缓存文件失败，将使用 pread 查询: " << filePath << std::endl;
+        return true;
+    }
     
-    std::cout << "找到 " << currentSearchResults_.size() << " 个符合条件的指针" << std::endl;
+    // 扫描时的查询是随机访问，关闭默认的顺序预读
+    madvise(addr, fileSize_, MADV_RANDOM);
     
-    return success;
+    data_ = static_cast<const uint8_t*>(addr);
+    return true;
 }
 
-std::vector<PointerCacheEntry> FileCache::findPointersInRange(Address minValue, Address maxValue) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    // 清空现有搜索结果
-    currentSearchResults_.clear();
-    
-    // 执行搜索
-    bool success = findPointersInRange_(minValue, maxValue);
-    
-    if (!success) {
-        std::cerr << "查找指针过程中发生错误" << std::endl;
+bool FileCacheLevel::locate(Address minValue, Address maxValue, size_t& first, size_t& last) const {
+    if (minValue > maxValue || count_ == 0) {
+        return false;
     }
     
-    // 返回结果副本
-    return currentSearchResults_;
+    // 块之间按值有序，二分找到第一个 endValue >= minValue 的块和第一个 startValue > maxValue 的块
+    auto startIt = std::lower_bound(rangeIndex_.begin(), rangeIndex_.end(), minValue,
+                                  [](const RangeEntry& entry, Address value) {
+                                      return entry.endValue < value;
+                                  });
+    auto endIt = std::upper_bound(startIt, rangeIndex_.end(), maxValue,
+                                [](Address value, const RangeEntry& entry) {
+                                    return value < entry.startValue;
+                                });
+    first = static_cast<size_t>(startIt - rangeIndex_.begin());
+    last = static_cast<size_t>(endIt - rangeIndex_.begin());
+    return first < last;
 }
 
-PointerCacheEntry* FileCache::readPointerByOffset(int64_t offset) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    // 检查文件路径是否有效
-    std::string filePath = dataFiles_[currentLevel_];
-    if (filePath.empty()) {
-        std::cerr << "无效的缓存文件路径" << std::endl;
-        return nullptr;
-    }
-    
-    // 检查偏移量是否合法
-    if (offset < 0) {
-        std::cerr << "无效的偏移量: " << offset << std::endl;
-        return nullptr;
+const uint8_t* FileCacheLevel::blockData(const RangeEntry& range) const {
+    if (data_) {
+        return data_ + range.fileOffset;
     }
     
-    // 打开文件
-    std::ifstream dataFile(filePath, std::ios::binary | std::ios::in);
-    if (!dataFile) {
-        std::cerr << "无法打开缓存文件: " << filePath << std::endl;
-        return nullptr;
+    // 未映射：pread 读取整个块（缓冲区为线程局部，无共享状态）
+    thread_local std::vector<uint8_t> buffer;
+    buffer.resize(static_cast<size_t>(range.byteSize));
+    ssize_t n = pread(fd_, buffer.data(), buffer.size(), static_cast<off_t>(range.fileOffset));
+    return n == static_cast<ssize_t>(buffer.size()) ? buffer.data() : nullptr;
+}
+
+size_t FileCacheLevel::find(Address minValue, Address maxValue, std::vector<PointerCacheEntry>& results) const {
+    size_t first = 0;
+    size_t last = 0;
+    if ((!data_ && fd_ < 0) || !locate(minValue, maxValue, first, last)) {
+        return 0;
     }
     
-    // 获取文件大小
-    dataFile.seekg(0, std::ios::end);
-    size_t fileSize = dataFile.tellg();
-    dataFile.seekg(0, std::ios::beg);
-    
-    // 检查文件大小
-    if (fileSize == 0) {
-        std::cerr << "缓存文件为空" << std::endl;
-        return nullptr;
+    // 涉及的压缩数据较多时会顺序读取，提示内核预读
+    if (data_ && last - first > 1) {
+        size_t begin = static_cast<size_t>(rangeIndex_[first].fileOffset);
+        size_t end = static_cast<size_t>(rangeIndex_[last - 1].fileOffset + rangeIndex_[last - 1].byteSize);
+        if (end - begin >= WILLNEED_THRESHOLD) {
+            size_t pageMask = static_cast<size_t>(sysconf(_SC_PAGESIZE)) - 1;
+            madvise(const_cast<uint8_t*>(data_) + (begin & ~pageMask), end - (begin & ~pageMask), MADV_WILLNEED);
+        }
     }
     
-    // 确保偏移量不超出文件范围
-    if (offset + sizeof(PointerCacheEntry) > fileSize) {
-        std::cerr << "偏移量超出文件范围: " << offset << " + " << sizeof(PointerCacheEntry) 
-                 << " > " << fileSize << std::endl;
-        return nullptr;
+    size_t before = results.size();
+    for (size_t i = first; i < last; ++i) {
+        const uint8_t* block = blockData(rangeIndex_[i]);
+        if (!block || !decodeBlock(block, rangeIndex_[i], minValue, maxValue, &results)) {
+            std::cerr << "解码缓存块失败: 等级 " << level_ << " 块 " << i << std::endl;
+            break;
+        }
     }
-    
-    // 跳转到指定位置
-    dataFile.seekg(offset);
-    if (dataFile.fail()) {
-        std::cerr << "跳转到文件位置失败: " << offset << std::endl;
-        return nullptr;
+    return results.size() - before;
+}
+
+bool FileCacheLevel::readBlock(size_t index, std::vector<PointerCacheEntry>& results) const {
+    if (index >= rangeIndex_.size() || (!data_ && fd_ < 0)) {
+        return false;
     }
-    
-    // 读取指针数据
-    static PointerCacheEntry entry;
-    dataFile.read(reinterpret_cast<char*>(&entry), sizeof(entry));
-    
-    if (dataFile.fail()) {
-        std::cerr << "读取指针数据失败: 偏移量 " << offset << std::endl;
-        return nullptr;
+    const uint8_t* data = blockData(rangeIndex_[index]);
+    return data && decodeBlock(data, rangeIndex_[index], 0, ~Address(0), &results);
+}
+
+bool FileCacheLevel::readAt(size_t index, PointerCacheEntry& entry) const {
+    if (index >= count_ || (!data_ && fd_ < 0)) {
+        return false;
     }
     
-    return &entry;
+    // 找到包含该下标的块，解码到对应位置
+    size_t block = static_cast<size_t>(std::upper_bound(blockFirst_.begin(), blockFirst_.end(), index) - blockFirst_.begin()) - 1;
+    const uint8_t* data = blockData(rangeIndex_[block]);
+    return data && decodeBlock(data, rangeIndex_[block], 0, ~Address(0), nullptr, index - blockFirst_[block], &entry);
+}
+
+std::shared_ptr<const FileCacheLevel> FileCache::getLevel() const {
+    return std::atomic_load(&level_);
+}
+
+size_t FileCache::findPointersInRange(Address minValue, Address maxValue, std::vector<PointerCacheEntry>& results) const {
+    auto level = getLevel();
+    return level ? level->find(minValue, maxValue, results) : 0;
+}
+
+std::vector<PointerCacheEntry> FileCache::findPointersInRange(Address minValue, Address maxValue) const {
+    std::vector<PointerCacheEntry> results;
+    findPointersInRange(minValue, maxValue, results);
+    return results;
+}
+
+bool FileCache::readPointerByOffset(int64_t offset, PointerCacheEntry& entry) const {
+    auto level = getLevel();
+    return level && offset >= 0 &&
+           level->readAt(static_cast<size_t>(offset) / sizeof(PointerCacheEntry), entry);
 }
 
 bool FileCache::buildRangeIndex() {
     // 清空现有索引
     rangeIndex_.clear();
     
-    // 打开数据文件进行读取
     std::string filePath = dataFiles_[currentLevel_];
-    std::ifstream dataFile(filePath, std::ios::binary | std::ios::in);
-    if (!dataFile) {
-        std::cerr << "无法打开缓存文件: " << filePath << std::endl;
-        return false;
-    }
-    
-    // 设置文件缓冲区
-    char* buffer = new char[FILE_BUFFER_SIZE];
-    dataFile.rdbuf()->pubsetbuf(buffer, FILE_BUFFER_SIZE);
+    std::string indexPath = getIndexFilePath(currentLevel_);
     
     // 获取文件大小
-    dataFile.seekg(0, std::ios::end);
-    size_t fileSize = dataFile.tellg();
-    dataFile.seekg(0, std::ios::beg);
-    
-    // 如果文件为空或小于一个条目的大小，返回成功但不创建索引
-    if (fileSize == 0 || fileSize < sizeof(PointerCacheEntry)) {
-        std::cout << "缓存文件为空或不包含完整条目" << std::endl;
-        delete[] buffer;
-        
-        // 创建一个空索引文件
-        std::string indexPath = getIndexFilePath(currentLevel_);
-        std::ofstream indexFile(indexPath, std::ios::binary | std::ios::out);
-        if (indexFile) {
-            indexFile.close();
-        }
-        
-        // 确保有一个范围索引，即使是空的
-        RangeEntry emptyRange{0, 0, 0, 0};
-        rangeIndex_.push_back(emptyRange);
-        
-        return true;
+    size_t fileSize = 0;
+    try {
+        fileSize = static_cast<size_t>(fs::file_size(filePath));
+    } catch (const std::exception& e) {
+        std::cerr << "无法获取缓存文件大小: " << e.what() << std::endl;
+        return false;
     }
     
     // 确保文件大小是条目大小的整数倍
     if (fileSize % sizeof(PointerCacheEntry) != 0) {
         std::cerr << "文件大小不是条目大小的整数倍: " << fileSize << " % " 
                  << sizeof(PointerCacheEntry) << " = " 
-                 << (fileSize % sizeof(PointerCacheEntry)) << std::endl;
-        
-        // 调整为最接近的整数倍
-        size_t validFileSize = (fileSize / sizeof(PointerCacheEntry)) * sizeof(PointerCacheEntry);
-        std::cerr << "将使用有效部分: " << validFileSize << " 字节" << std::endl;
-        fileSize = validFileSize;
+                 << (fileSize % sizeof(PointerCacheEntry)) << "，将只使用完整条目" << std::endl;
     }
     
-    // 计算条目数量
     size_t entryCount = fileSize / sizeof(PointerCacheEntry);
     if (entryCount == 0) {
-        std::cout << "没有有效的条目" << std::endl;
-        delete[] buffer;
-        
-        // 创建空索引
-        RangeEntry emptyRange{0, 0, 0, 0};
-        rangeIndex_.push_back(emptyRange);
-        
-        std::string indexPath = getIndexFilePath(currentLevel_);
-        std::ofstream indexFile(indexPath, std::ios::binary | std::ios::out);
-        if (indexFile) {
-            indexFile.write(reinterpret_cast<const char*>(&emptyRange), sizeof(emptyRange));
-            indexFile.close();
-        }
-        
-        return true;
-    }
-    
-    // 先读取所有指针并按值排序
-    std::vector<std::pair<Address, int64_t>> valueOffsetPairs;
-    
-    std::cout << "读取指针数据进行排序..." << std::endl;
-
-    // 根据文件大小预分配空间
-    try {
-        valueOffsetPairs.reserve(entryCount);
-    } catch (const std::exception& e) {
-        std::cerr << "无法为值-偏移对分配内存: " << e.what() 
-                 << "，条目数: " << entryCount << std::endl;
-        delete[] buffer;
-        return false;
-    }
-    
-    // 尝试一次性读取所有数据到内存
-    std::vector<PointerCacheEntry> allEntries;
-    try {
-        allEntries.resize(entryCount);
-    } catch (const std::exception& e) {
-        std::cerr << "无法为所有条目分配内存: " << e.what() 
-                 << "，条目数: " << entryCount << std::endl;
-        
-        // 如果一次性分配失败，则改为分块读取
-        delete[] buffer;
-        return buildRangeIndexInChunks(dataFile, fileSize, entryCount);
-    }
-    
-    // 读取所有数据
-    dataFile.read(reinterpret_cast<char*>(allEntries.data()), fileSize);
-    
-    // 检查读取是否成功
-    if (dataFile.fail()) {
-        std::cerr << "读取缓存文件数据失败" << std::endl;
-        
-        // 尝试分块构建
-        dataFile.clear();
-        dataFile.seekg(0, std::ios::beg);
-        
-        delete[] buffer;
-        return buildRangeIndexInChunks(dataFile, fileSize, entryCount);
-    }
-    
-    // 构建偏移对
-    for (size_t i = 0; i < entryCount; i++) {
-        valueOffsetPairs.emplace_back(allEntries[i].value, i * sizeof(PointerCacheEntry));
-        
-        // 每读取100万个，显示进度
-        if (valueOffsetPairs.size() % 1000000 == 0) {
-            std::cout << "已读取 " << (valueOffsetPairs.size() / 1000000) << "M 个指针" << std::endl;
-            
-            // 调用进度回调（如果有）
-            if (progressCallback_) {
-                progressCallback_(static_cast<float>(valueOffsetPairs.size()) / 
-                                 static_cast<float>(entryCount));
-            }
-        }
-    }
-    
-    // 释放allEntries内存，不再需要
-    allEntries.clear();
-    allEntries.shrink_to_fit();
-    
-    if (valueOffsetPairs.empty()) {
-        std::cout << "没有找到有效的指针数据" << std::endl;
+        std::cout << "缓存文件为空或不包含完整条目" << std::endl;
         
         // 创建空索引
-        RangeEntry emptyRange{0, 0, 0, 0};
+        RangeEntry emptyRange{0, 0, 0, 0, 0};
         rangeIndex_.push_back(emptyRange);
         
-        std::string indexPath = getIndexFilePath(currentLevel_);
         std::ofstream indexFile(indexPath, std::ios::binary | std::ios::out);
         if (indexFile) {
             indexFile.write(reinterpret_cast<const char*>(&emptyRange), sizeof(emptyRange));
-            indexFile.close();
         }
-        
-        delete[] buffer;
         return true;
     }
     
-    std::cout << "开始排序 " << valueOffsetPairs.size() << " 个指针..." << std::endl;
+    auto startTime = std::chrono::high_resolution_clock::now();
     
-    // 按值排序
-    try {
-        std::sort(valueOffsetPairs.begin(), valueOffsetPairs.end(), 
-                [](const auto& a, const auto& b) {
-                    return a.first < b.first;
-                });
-    } catch (const std::exception& e) {
-        std::cerr << "排序指针时发生异常: " << e.what() << std::endl;
-        delete[] buffer;
-        return false;
-    }
-    
-    std::cout << "排序完成，创建范围表..." << std::endl;
-    
-    // 创建范围索引文件
-    std::string indexPath = getIndexFilePath(currentLevel_);
-    std::ofstream indexFile(indexPath, std::ios::binary | std::ios::out);
-    if (!indexFile) {
-        std::cerr << "无法创建索引文件: " << indexPath << std::endl;
-        delete[] buffer;
-        return false;
-    }
+    // 第一步：分段读取并行排序，生成有序段文件
+    std::vector<std::string> runs;
+    bool success = generateSortedRuns(filePath, entryCount, runs);
     
-    // 如果值对为空，创建一个空索引
-    if (valueOffsetPairs.empty()) {
-        RangeEntry emptyRange{0, 0, 0, 0};
-        rangeIndex_.push_back(emptyRange);
-        indexFile.write(reinterpret_cast<const char*>(&emptyRange), sizeof(emptyRange));
-        indexFile.close();
-        
-        std::cout << "没有指针数据，创建空索引" << std::endl;
-        delete[] buffer;
-        return true;
-    }
-    
-    // 创建排序后的数据文件
+    // 第二步：多路归并为全局有序文件，同时生成范围索引
     std::string sortedFilePath = filePath + ".sorted";
-    std::ofstream sortedFile(sortedFilePath, std::ios::binary | std::ios::out);
-    if (!sortedFile) {
-        std::cerr << "无法创建排序后的数据文件: " << sortedFilePath << std::endl;
-        delete[] buffer;
-        return false;
+    if (success) {
+        success = mergeSortedRuns(runs, sortedFilePath, entryCount);
     }
     
-    // 设置文件缓冲区
-    char* sortedBuffer = new char[FILE_BUFFER_SIZE];
-    sortedFile.rdbuf()->pubsetbuf(sortedBuffer, FILE_BUFFER_SIZE);
-    
-    // 按排序后的顺序写入数据
-    std::cout << "创建排序后的数据文件..." << std::endl;
-    
-    Address currentRangeStart = valueOffsetPairs[0].first;
-    Address currentRangeEnd = currentRangeStart;
-    int64_t rangeStartOffset = 0;
-    int64_t entryCounter = 0;
-    
-    // 临时缓冲区，用于读取单个条目
-    PointerCacheEntry readEntry;
-    
-    for (size_t i = 0; i < valueOffsetPairs.size(); ++i) {
-        const auto& [value, fileOffset] = valueOffsetPairs[i];
-        
-        // 从原文件读取数据
-        dataFile.seekg(fileOffset);
-        if (dataFile.fail()) {
-            std::cerr << "跳转到文件位置失败: " << fileOffset << std::endl;
-            dataFile.clear();
-            continue;
-        }
-        
-        dataFile.read(reinterpret_cast<char*>(&readEntry), sizeof(readEntry));
-        if (dataFile.fail()) {
-            std::cerr << "读取指针数据失败，偏移: " << fileOffset << std::endl;
-            dataFile.clear();
-            continue;
-        }
-        
-        // 写入排序后的文件
-        sortedFile.write(reinterpret_cast<const char*>(&readEntry), sizeof(readEntry));
-        if (sortedFile.fail()) {
-            std::cerr << "写入排序后的文件失败" << std::endl;
-            continue;
-        }
-        
-        // 更新范围结束值
-        currentRangeEnd = value;
-        entryCounter++;
-        
-        // 检查是否达到范围桶大小或者是最后一条数据
-        bool isLastEntry = (i == valueOffsetPairs.size() - 1);
-        bool newRangeNeeded = ((value - currentRangeStart) >= RANGE_BUCKET_SIZE) || isLastEntry;
-        
-        if (newRangeNeeded) {
-            // 创建范围条目
-            RangeEntry rangeEntry{
-                currentRangeStart,
-                currentRangeEnd,
-                rangeStartOffset,
-                entryCounter
-            };
-            
-            // 添加到内存中的范围索引
-            rangeIndex_.push_back(rangeEntry);
-            
-            // 写入索引文件
-            indexFile.write(reinterpret_cast<const char*>(&rangeEntry), sizeof(rangeEntry));
-            if (indexFile.fail()) {
-                std::cerr << "写入索引文件失败" << std::endl;
-            }
-            
-            // 为下一个范围做准备
-            if (!isLastEntry) {
-                currentRangeStart = value;
-                rangeStartOffset += entryCounter * sizeof(PointerCacheEntry);
-                entryCounter = 0;
-            }
-            
-            // 每创建10个范围，显示一次进度
-            if (rangeIndex_.size() % 10 == 0) {
-                std::cout << "已创建 " << rangeIndex_.size() << " 个范围索引" << std::endl;
-            }
-        }
+    for (const auto& run : runs) {
+        std::error_code ec;
+        fs::remove(run, ec);
     }
     
-    // 关闭文件
-    dataFile.close();
-    indexFile.close();
-    sortedFile.close();
-    
-    // 释放缓冲区
-    delete[] buffer;
-    delete[] sortedBuffer;
-    
-    // 确保至少有一个范围索引
-    if (rangeIndex_.empty()) {
-        RangeEntry rangeEntry{0, 0, 0, 0};
-        
-        if (!valueOffsetPairs.empty()) {
-            rangeEntry.startValue = valueOffsetPairs.front().first;
-            rangeEntry.endValue = valueOffsetPairs.back().first;
-            rangeEntry.fileOffset = 0;
-            rangeEntry.entryCount = static_cast<int64_t>(valueOffsetPairs.size());
-        }
-        
-        rangeIndex_.push_back(rangeEntry);
-        
-        // 重新打开索引文件并写入
-        std::ofstream fixIndexFile(indexPath, std::ios::binary | std::ios::out);
-        if (fixIndexFile) {
-            fixIndexFile.write(reinterpret_cast<const char*>(&rangeEntry), sizeof(rangeEntry));
-            fixIndexFile.close();
-        }
+    if (!success) {
+        std::error_code ec;
+        fs::remove(sortedFilePath, ec);
+        rangeIndex_.clear();
+        return false;
     }
     
     // 用排序后的文件替换原文件
@@ -677,330 +522,203 @@ bool FileCache::buildRangeIndex() {
         return false;
     }
     
-    std::cout << "范围索引构建完成，共 " << rangeIndex_.size() << " 个范围" << std::endl;
-    return true;
-}
-
-bool FileCache::buildRangeIndexInChunks(std::ifstream& dataFile, size_t fileSize, size_t entryCount) {
-    std::cout << "使用分块方式构建范围索引..." << std::endl;
-    
-    // 重置文件位置
-    dataFile.seekg(0, std::ios::beg);
-    if (dataFile.fail()) {
-        std::cerr << "重置文件位置失败" << std::endl;
-        return false;
-    }
-    
-    // 创建排序后的数据文件
-    std::string filePath = dataFiles_[currentLevel_];
-    std::string sortedFilePath = filePath + ".sorted";
-    std::ofstream sortedFile(sortedFilePath, std::ios::binary | std::ios::out);
-    if (!sortedFile) {
-        std::cerr << "无法创建排序后的数据文件: " << sortedFilePath << std::endl;
-        return false;
-    }
-    
-    // 创建索引文件
-    std::string indexPath = getIndexFilePath(currentLevel_);
+    // 写入索引文件
     std::ofstream indexFile(indexPath, std::ios::binary | std::ios::out);
     if (!indexFile) {
         std::cerr << "无法创建索引文件: " << indexPath << std::endl;
         return false;
     }
+    indexFile.write(reinterpret_cast<const char*>(rangeIndex_.data()), rangeIndex_.size() * sizeof(RangeEntry));
+    if (!indexFile) {
+        std::cerr << "写入索引文件失败" << std::endl;
+        return false;
+    }
     
-    // 设置缓冲区
-    char* sortedBuffer = new char[FILE_BUFFER_SIZE];
-    sortedFile.rdbuf()->pubsetbuf(sortedBuffer, FILE_BUFFER_SIZE);
-    
-    // 分块大小，每块最多读取10万个条目
-    constexpr size_t CHUNK_SIZE = 100000;
-    const size_t totalChunks = (entryCount + CHUNK_SIZE - 1) / CHUNK_SIZE;
-    
-    std::cout << "总条目数: " << entryCount << ", 分为 " << totalChunks << " 个块" << std::endl;
-    
-    // 预估每个块需要的内存
-    const size_t chunkMemory = CHUNK_SIZE * sizeof(PointerCacheEntry) + 
-                             CHUNK_SIZE * sizeof(std::pair<Address, int64_t>);
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+    const RangeEntry& lastRange = rangeIndex_.back();
+    size_t compressedSize = static_cast<size_t>(lastRange.fileOffset + lastRange.byteSize);
+    std::cout << "范围索引构建完成，共 " << rangeIndex_.size() << " 个压缩块，" << runs.size() 
+              << " 个有序段，耗时 " << duration << " ms" << std::endl;
+    std::cout << "压缩后 " << std::fixed << std::setprecision(2) << compressedSize / (1024.0 * 1024.0)
+              << " MB（原始 " << entryCount * sizeof(PointerCacheEntry) / (1024.0 * 1024.0) << " MB）" << std::endl;
+    return true;
+}
+
+bool FileCache::generateSortedRuns(const std::string& filePath, size_t entryCount, std::vector<std::string>& runs) {
+    // 同时排序的段数等于线程数，所有段的内存之和不超过排序内存上限
+    size_t parallel = globalThreadPool ? std::max<size_t>(1, globalThreadPool->size()) : 1;
+    size_t runEntries = std::max<size_t>(MIN_RUN_ENTRIES, sortMemoryLimit_ / parallel / sizeof(PointerCacheEntry));
+    size_t runCount = (entryCount + runEntries - 1) / runEntries;
     
-    if (chunkMemory > 2 * 1024 * 1024 * 1024ULL) {
-        std::cerr << "块大小过大，可能导致内存问题: " << 
-                  (chunkMemory / (1024 * 1024)) << "MB" << std::endl;
-        
-        // 调整块大小为更小的值
-        return buildRangeIndexWithSmallChunks(dataFile, fileSize, entryCount);
+    runs.clear();
+    for (size_t i = 0; i < runCount; ++i) {
+        runs.push_back(getRunFilePath(currentLevel_, i));
     }
     
-    // 临时变量存储全局范围信息
-    Address globalMinValue = std::numeric_limits<Address>::max();
-    Address globalMaxValue = 0;
-    std::vector<std::pair<Address, RangeEntry>> sortedRanges;
+    std::cout << "外部排序: " << entryCount << " 个指针，分为 " << runCount << " 个有序段" << std::endl;
     
-    // 处理每个块
-    for (size_t chunkIndex = 0; chunkIndex < totalChunks; ++chunkIndex) {
-        // 计算当前块的大小
-        const size_t startEntry = chunkIndex * CHUNK_SIZE;
-        const size_t chunkEntryCount = std::min(CHUNK_SIZE, entryCount - startEntry);
-        
-        std::cout << "处理块 " << (chunkIndex + 1) << "/" << totalChunks 
-                  << " (条目: " << startEntry << " - " << (startEntry + chunkEntryCount - 1) << ")" << std::endl;
-        
-        // 定位到块的起始位置
-        const int64_t chunkOffset = startEntry * sizeof(PointerCacheEntry);
-        dataFile.seekg(chunkOffset);
-        if (dataFile.fail()) {
-            std::cerr << "跳转到块位置失败: " << chunkOffset << std::endl;
-            dataFile.clear();
-            continue;
-        }
+    auto makeRun = [&, runEntries](size_t runIndex) -> bool {
+        size_t begin = runIndex * runEntries;
+        size_t count = std::min(runEntries, entryCount - begin);
         
-        // 读取块数据
-        std::vector<PointerCacheEntry> chunkEntries(chunkEntryCount);
-        dataFile.read(reinterpret_cast<char*>(chunkEntries.data()), 
-                     chunkEntryCount * sizeof(PointerCacheEntry));
-        
-        if (dataFile.fail()) {
-            std::cerr << "读取块数据失败" << std::endl;
-            dataFile.clear();
-            continue;
-        }
-        
-        // 创建值-偏移对
-        std::vector<std::pair<Address, int64_t>> chunkValueOffsetPairs;
-        chunkValueOffsetPairs.reserve(chunkEntryCount);
-        
-        for (size_t i = 0; i < chunkEntryCount; ++i) {
-            const int64_t entryOffset = chunkOffset + i * sizeof(PointerCacheEntry);
-            chunkValueOffsetPairs.emplace_back(chunkEntries[i].value, entryOffset);
-            
-            // 更新全局范围
-            globalMinValue = std::min(globalMinValue, chunkEntries[i].value);
-            globalMaxValue = std::max(globalMaxValue, chunkEntries[i].value);
+        std::vector<PointerCacheEntry> entries(count);
+        std::ifstream input(filePath, std::ios::binary | std::ios::in);
+        input.seekg(static_cast<std::streamoff>(begin * sizeof(PointerCacheEntry)));
+        input.read(reinterpret_cast<char*>(entries.data()), count * sizeof(PointerCacheEntry));
+        if (!input) {
+            std::cerr << "读取有序段数据失败: 段 " << runIndex << std::endl;
+            return false;
         }
         
-        // 排序当前块
-        try {
-            std::sort(chunkValueOffsetPairs.begin(), chunkValueOffsetPairs.end(),
-                    [](const auto& a, const auto& b) {
-                        return a.first < b.first;
-                    });
-        } catch (const std::exception& e) {
-            std::cerr << "排序块时发生异常: " << e.what() << std::endl;
-            continue;
-        }
+        std::sort(entries.begin(), entries.end(), [](const PointerCacheEntry& a, const PointerCacheEntry& b) {
+            return a.value < b.value || (a.value == b.value && a.address < b.address);
+        });
         
-        // 如果块为空，继续下一个
-        if (chunkValueOffsetPairs.empty()) {
-            continue;
+        std::ofstream output(runs[runIndex], std::ios::binary | std::ios::out | std::ios::trunc);
+        output.write(reinterpret_cast<const char*>(entries.data()), count * sizeof(PointerCacheEntry));
+        if (!output) {
+            std::cerr << "写入有序段失败: " << runs[runIndex] << std::endl;
+            return false;
         }
-        
-        // 创建范围（每个块至少创建一个范围）
-        Address chunkMinValue = chunkValueOffsetPairs.front().first;
-        Address chunkMaxValue = chunkValueOffsetPairs.back().first;
-        
-        // 计算此块在排序后文件中的位置
-        int64_t sortedFileOffset = sortedFile.tellp();
-        
-        // 写入排序后的数据
-        for (const auto& [value, origOffset] : chunkValueOffsetPairs) {
-            // 重新读取原始数据
-            dataFile.seekg(origOffset);
-            if (dataFile.fail()) {
-                std::cerr << "跳转到条目位置失败: " << origOffset << std::endl;
-                dataFile.clear();
-                continue;
-            }
-            
-            PointerCacheEntry entry;
-            dataFile.read(reinterpret_cast<char*>(&entry), sizeof(entry));
-            if (dataFile.fail()) {
-                std::cerr << "读取条目数据失败" << std::endl;
-                dataFile.clear();
-                continue;
+        return true;
+    };
+    
+    bool success = true;
+    if (globalThreadPool && runCount > 1) {
+        // 按批提交，同一时间最多 parallel 个段驻留内存
+        for (size_t first = 0; first < runCount && success; first += parallel) {
+            std::vector<std::future<bool>> futures;
+            for (size_t i = first; i < std::min(runCount, first + parallel); ++i) {
+                futures.push_back(globalThreadPool->submit(makeRun, i));
             }
-            
-            // 写入排序后的文件
-            sortedFile.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
-            if (sortedFile.fail()) {
-                std::cerr << "写入排序后的文件失败" << std::endl;
-                break;
+            for (auto& future : futures) {
+                try {
+                    success = future.get() && success;
+                } catch (const std::exception& e) {
+                    std::cerr << "生成有序段异常: " << e.what() << std::endl;
+                    success = false;
+                }
             }
         }
-        
-        // 创建范围条目
-        RangeEntry rangeEntry{
-            chunkMinValue,
-            chunkMaxValue,
-            sortedFileOffset,
-            static_cast<int64_t>(chunkValueOffsetPairs.size())
-        };
-        
-        // 保存到排序后的范围列表
-        sortedRanges.emplace_back(chunkMinValue, rangeEntry);
-    }
-    
-    // 确保范围按值排序
-    std::sort(sortedRanges.begin(), sortedRanges.end(),
-            [](const auto& a, const auto& b) {
-                return a.first < b.first;
-            });
-    
-    // 写入所有范围到索引文件并保存到内存
-    rangeIndex_.clear();
-    
-    if (sortedRanges.empty()) {
-        // 创建空范围
-        RangeEntry emptyRange{globalMinValue, globalMaxValue, 0, 0};
-        rangeIndex_.push_back(emptyRange);
-        indexFile.write(reinterpret_cast<const char*>(&emptyRange), sizeof(emptyRange));
     } else {
-        for (const auto& [_, rangeEntry] : sortedRanges) {
-            rangeIndex_.push_back(rangeEntry);
-            indexFile.write(reinterpret_cast<const char*>(&rangeEntry), sizeof(rangeEntry));
+        for (size_t i = 0; i < runCount && success; ++i) {
+            success = makeRun(i);
         }
     }
     
-    // 关闭文件
-    sortedFile.close();
-    indexFile.close();
-    
-    // 释放缓冲区
-    delete[] sortedBuffer;
-    
-    // 用排序后的文件替换原文件
-    try {
-        fs::remove(filePath);
-        fs::rename(sortedFilePath, filePath);
-    } catch (const std::exception& e) {
-        std::cerr << "替换文件失败: " << e.what() << std::endl;
-        return false;
-    }
-    
-    std::cout << "分块构建范围索引完成，共 " << rangeIndex_.size() << " 个范围" << std::endl;
-    return true;
+    return success;
 }
 
-bool FileCache::buildRangeIndexWithSmallChunks(std::ifstream& dataFile, size_t fileSize, size_t entryCount) {
-    std::cout << "使用小块方式构建范围索引..." << std::endl;
+bool FileCache::mergeSortedRuns(const std::vector<std::string>& runs, const std::string& outputPath, size_t entryCount) {
+    // 每个有序段一个读取缓冲，总大小为 MERGE_BUFFER_SIZE
+    struct RunReader {
+        std::ifstream file;
+        std::vector<PointerCacheEntry> buffer;
+        size_t pos = 0;
+        size_t count = 0;
+        
+        bool refill() {
+            file.read(reinterpret_cast<char*>(buffer.data()), buffer.size() * sizeof(PointerCacheEntry));
+            count = static_cast<size_t>(file.gcount()) / sizeof(PointerCacheEntry);
+            pos = 0;
+            return count > 0;
+        }
+    };
     
-    // 重置文件位置
-    dataFile.seekg(0, std::ios::beg);
+    size_t readerEntries = std::max<size_t>(1024, MERGE_BUFFER_SIZE / sizeof(PointerCacheEntry) / runs.size());
+    std::vector<RunReader> readers(runs.size());
     
-    // 创建排序后的数据文件
-    std::string filePath = dataFiles_[currentLevel_];
-    std::string sortedFilePath = filePath + ".sorted";
-    std::ofstream sortedFile(sortedFilePath, std::ios::binary | std::ios::out);
-    if (!sortedFile) {
-        std::cerr << "无法创建排序后的数据文件: " << sortedFilePath << std::endl;
-        return false;
+    // 最小堆：(值, 地址, 段下标)
+    using HeapItem = std::tuple<Address, Address, size_t>;
+    std::priority_queue<HeapItem, std::vector<HeapItem>, std::greater<HeapItem>> heap;
+    
+    for (size_t i = 0; i < runs.size(); ++i) {
+        readers[i].file.open(runs[i], std::ios::binary | std::ios::in);
+        if (!readers[i].file) {
+            std::cerr << "无法打开有序段: " << runs[i] << std::endl;
+            return false;
+        }
+        readers[i].buffer.resize(readerEntries);
+        if (readers[i].refill()) {
+            const PointerCacheEntry& head = readers[i].buffer[0];
+            heap.emplace(head.value, head.address, i);
+        }
     }
     
-    // 创建索引文件
-    std::string indexPath = getIndexFilePath(currentLevel_);
-    std::ofstream indexFile(indexPath, std::ios::binary | std::ios::out);
-    if (!indexFile) {
-        std::cerr << "无法创建索引文件: " << indexPath << std::endl;
+    std::ofstream output(outputPath, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!output) {
+        std::cerr << "无法创建排序后的数据文件: " << outputPath << std::endl;
         return false;
     }
     
-    // 使用更小的块大小
-    constexpr size_t SMALL_CHUNK_SIZE = 10000;
-    const size_t totalChunks = (entryCount + SMALL_CHUNK_SIZE - 1) / SMALL_CHUNK_SIZE;
-    
-    std::cout << "总条目数: " << entryCount << ", 分为 " << totalChunks << " 个小块" << std::endl;
-    
-    // 创建最小的范围索引
-    RangeEntry currentRange{
-        std::numeric_limits<Address>::max(),  // 初始最小值
-        0,                                  // 初始最大值
-        0,                                  // 文件偏移（将在处理第一个块时设置）
-        0                                   // 条目计数
+    std::vector<uint8_t> outBuffer;
+    outBuffer.reserve(FILE_BUFFER_SIZE + RANGE_MAX_ENTRIES * MAX_ENCODED_ENTRY);
+    
+    // 归并输出时顺带生成范围索引：值跨度达到 RANGE_BUCKET_SIZE 或条目数达到 RANGE_MAX_ENTRIES 时
+    // 结束一个范围，范围内的条目编码为一个压缩块
+    std::vector<PointerCacheEntry> block;
+    block.reserve(RANGE_MAX_ENTRIES);
+    int64_t fileOffset = 0;
+    size_t written = 0;
+    
+    auto closeBlock = [&]() {
+        RangeEntry range{block.front().value, block.back().value, fileOffset,
+                         static_cast<int64_t>(block.size()), 0};
+        size_t before = outBuffer.size();
+        encodeBlock(block, range.startValue, outBuffer);
+        range.byteSize = static_cast<int64_t>(outBuffer.size() - before);
+        fileOffset += range.byteSize;
+        rangeIndex_.push_back(range);
+        block.clear();
+        
+        if (outBuffer.size() >= FILE_BUFFER_SIZE) {
+            output.write(reinterpret_cast<const char*>(outBuffer.data()), outBuffer.size());
+            outBuffer.clear();
+            
+            if (progressCallback_) {
+                progressCallback_(static_cast<float>(written) / static_cast<float>(entryCount));
+            }
+        }
     };
     
-    bool hasAnyValidData = false;
-    int64_t currentFilePos = 0;
-    
-    // 处理每个块
-    for (size_t chunkIndex = 0; chunkIndex < totalChunks; ++chunkIndex) {
-        // 计算当前块的大小
-        const size_t startEntry = chunkIndex * SMALL_CHUNK_SIZE;
-        const size_t chunkEntryCount = std::min(SMALL_CHUNK_SIZE, entryCount - startEntry);
+    while (!heap.empty()) {
+        size_t runIndex = std::get<2>(heap.top());
+        heap.pop();
         
-        if (chunkIndex % 100 == 0) {
-            std::cout << "处理小块 " << (chunkIndex + 1) << "/" << totalChunks << std::endl;
-        }
+        RunReader& reader = readers[runIndex];
+        const PointerCacheEntry& entry = reader.buffer[reader.pos];
         
-        // 定位到块的起始位置
-        const int64_t chunkOffset = startEntry * sizeof(PointerCacheEntry);
-        dataFile.seekg(chunkOffset);
-        if (dataFile.fail()) {
-            std::cerr << "跳转到小块位置失败: " << chunkOffset << std::endl;
-            dataFile.clear();
-            continue;
+        block.push_back(entry);
+        written++;
+        if (entry.value - block.front().value >= RANGE_BUCKET_SIZE || block.size() >= RANGE_MAX_ENTRIES) {
+            closeBlock();
         }
         
-        // 读取块数据
-        std::vector<PointerCacheEntry> chunkEntries(chunkEntryCount);
-        dataFile.read(reinterpret_cast<char*>(chunkEntries.data()), 
-                     chunkEntryCount * sizeof(PointerCacheEntry));
-        
-        if (dataFile.fail()) {
-            std::cerr << "读取小块数据失败" << std::endl;
-            dataFile.clear();
-            continue;
+        // 推进该段的读取位置
+        reader.pos++;
+        if (reader.pos < reader.count || reader.refill()) {
+            const PointerCacheEntry& next = reader.buffer[reader.pos];
+            heap.emplace(next.value, next.address, runIndex);
         }
-        
-        // 如果这是第一个有效块，设置范围的文件偏移
-        if (!hasAnyValidData && !chunkEntries.empty()) {
-            currentRange.fileOffset = currentFilePos;
-            hasAnyValidData = true;
-        }
-        
-        // 写入数据并更新范围
-        for (const auto& entry : chunkEntries) {
-            // 更新范围值
-            currentRange.startValue = std::min(currentRange.startValue, entry.value);
-            currentRange.endValue = std::max(currentRange.endValue, entry.value);
-            
-            // 写入数据
-            sortedFile.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
-            if (sortedFile.fail()) {
-                std::cerr << "写入排序后的文件失败" << std::endl;
-                break;
-            }
-            
-            // 更新条目计数
-            currentRange.entryCount++;
-        }
-        
-        // 更新当前文件位置
-        currentFilePos += chunkEntryCount * sizeof(PointerCacheEntry);
     }
     
-    // 如果有任何有效数据，写入范围
-    if (hasAnyValidData) {
-        rangeIndex_.push_back(currentRange);
-        indexFile.write(reinterpret_cast<const char*>(&currentRange), sizeof(currentRange));
-    } else {
-        // 创建空范围
-        RangeEntry emptyRange{0, 0, 0, 0};
-        rangeIndex_.push_back(emptyRange);
-        indexFile.write(reinterpret_cast<const char*>(&emptyRange), sizeof(emptyRange));
+    if (!block.empty()) {
+        closeBlock();
     }
     
-    // 关闭文件
-    sortedFile.close();
-    indexFile.close();
+    output.write(reinterpret_cast<const char*>(outBuffer.data()), outBuffer.size());
+    output.close();
+    if (!output) {
+        std::cerr << "写入排序后的文件失败" << std::endl;
+        return false;
+    }
     
-    // 用排序后的文件替换原文件
-    try {
-        fs::remove(filePath);
-        fs::rename(sortedFilePath, filePath);
-    } catch (const std::exception& e) {
-        std::cerr << "替换文件失败: " << e.what() << std::endl;
+    if (written != entryCount) {
+        std::cerr << "归并条目数不一致: " << written << " != " << entryCount << std::endl;
         return false;
     }
     
-    std::cout << "小块构建范围索引完成，共 " << rangeIndex_.size() << " 个范围" << std::endl;
     return true;
 }
 
@@ -1020,6 +738,7 @@ void FileCache::cleanup() {
     }
     
     // 清空内部状态
+    std::atomic_store(&level_, std::shared_ptr<const FileCacheLevel>());
     dataFiles_.clear();
     rangeIndex_.clear();
     currentLevel_ = -1;
@@ -1034,34 +753,16 @@ std::string FileCache::getTempFilePath(int level) const {
     return oss.str();
 }
 
-std::string FileCache::getIndexFilePath(int level) const {
+std::string FileCache::getRunFilePath(int level, size_t runIndex) const {
     std::ostringstream oss;
-    oss << cacheDir_ << "/memchainer_lvl" << level << "_index.bin";
+    oss << cacheDir_ << "/memchainer_lvl" << level << "_run" << runIndex << ".bin";
     return oss.str();
 }
 
-bool FileCache::loadIndex(int level) {
-    // 清空现有索引
-    rangeIndex_.clear();
-    
-    // 读取索引文件
-    std::string indexPath = getIndexFilePath(level);
-    std::ifstream indexFile(indexPath, std::ios::binary | std::ios::in);
-    if (!indexFile) {
-        std::cerr << "无法打开索引文件: " << indexPath << std::endl;
-        return false;
-    }
-    
-    // 读取所有范围条目
-    RangeEntry entry;
-    while (indexFile.read(reinterpret_cast<char*>(&entry), sizeof(entry))) {
-        rangeIndex_.push_back(entry);
-    }
-    
-    indexFile.close();
-    
-    std::cout << "加载范围索引完成，共 " << rangeIndex_.size() << " 个范围" << std::endl;
-    return true;
+std::string FileCache::getIndexFilePath(int level) const {
+    std::ostringstream oss;
+    oss << cacheDir_ << "/memchainer_lvl" << level << "_index.bin";
+    return oss.str();
 }
 
 size_t FileCache::getCurrentLevelPointerCount() const {
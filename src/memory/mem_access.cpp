@@ -1,4 +1,5 @@
 #include "memory/mem_access.h"
+#include "memory/async_reader.h"
 #include <cstring>
 #include <dirent.h>
 #include <fcntl.h>
@@ -7,7 +8,12 @@
 #include <sys/stat.h>
 #include <sys/mman.h>
 #include <cerrno>
+#include <atomic>
+#include <csetjmp>
+#include <csignal>
+#include <mutex>
 #include <algorithm>
+#include <iterator>
 #include <cstdio>
 #include <string>
 #include <fstream>
@@ -51,6 +57,59 @@ std::error_code make_error_code(MemError e) {
     return {static_cast<int>(e), mem_error_category()};
 }
 
+// FailedRangeSet 实现
+void FailedRangeSet::add(Address start, Address end) {
+    if (start >= end) {
+        return;
+    }
+
+    // 与前后相交或相邻的范围合并
+    auto it = ranges_.upper_bound(start);
+    if (it != ranges_.begin()) {
+        auto prev = std::prev(it);
+        if (prev->second >= start) {
+            start = prev->first;
+            end = std::max(end, prev->second);
+            it = ranges_.erase(prev);
+        }
+    }
+    while (it != ranges_.end() && it->first <= end) {
+        end = std::max(end, it->second);
+        it = ranges_.erase(it);
+    }
+    ranges_.emplace(start, end);
+}
+
+bool FailedRangeSet::contains(Address address) const {
+    auto it = ranges_.upper_bound(address);
+    if (it == ranges_.begin()) {
+        return false;
+    }
+    --it;
+    return address < it->second;
+}
+
+bool FailedRangeSet::findFirst(Address start, Address end, Address& failStart, Address& failEnd) const {
+    auto it = ranges_.upper_bound(start);
+    if (it != ranges_.begin() && std::prev(it)->second > start) {
+        --it;
+    }
+    if (it == ranges_.end() || it->first >= end) {
+        return false;
+    }
+    failStart = it->first;
+    failEnd = it->second;
+    return true;
+}
+
+uint64_t FailedRangeSet::totalBytes() const {
+    uint64_t total = 0;
+    for (const auto& range : ranges_) {
+        total += range.second - range.first;
+    }
+    return total;
+}
+
 // MemoryAccess 基类实现
 MemoryAccess::MemoryAccess() 
     : targetPid_(-1), pageFd_(-1), pageFailCount_(0), readFailCount_(0) {
@@ -182,6 +241,144 @@ bool MemoryAccess::read(Address address, void* buffer, MemorySize size, std::err
     return false;
 }
 
+MemorySize MemoryAccess::readAdaptive(Address address, void* buffer, MemorySize size, FailedRangeSet& failed) const {
+    uint8_t* out = static_cast<uint8_t*>(buffer);
+    Address end = address + size;
+    Address cursor = address;
+    MemorySize total = 0;
+
+    // 跳过已知失败的范围，其余部分分段读取
+    while (cursor < end) {
+        Address failStart = 0;
+        Address failEnd = 0;
+        Address segmentEnd = end;
+        if (failed.findFirst(cursor, end, failStart, failEnd)) {
+            if (failStart <= cursor) {
+                Address skipEnd = std::min(failEnd, end);
+                memset(out + (cursor - address), 0, skipEnd - cursor);
+                cursor = skipEnd;
+                continue;
+            }
+            segmentEnd = failStart;
+        }
+        total += readBisect(cursor, out + (cursor - address), segmentEnd - cursor, failed);
+        cursor = segmentEnd;
+    }
+    return total;
+}
+
+MemorySize MemoryAccess::readBisect(Address address, uint8_t* buffer, MemorySize size, FailedRangeSet& failed) const {
+    const Address kPageSize = 4096;
+    std::error_code ec;
+    if (read(address, buffer, size, ec)) {
+        return size;
+    }
+
+    Address pageStart = address & ~(kPageSize - 1);
+    Address pageEnd = (address + size + kPageSize - 1) & ~(kPageSize - 1);
+    if (pageEnd - pageStart <= kPageSize) {
+        memset(buffer, 0, size);
+        failed.add(pageStart, pageEnd);
+        return 0;
+    }
+
+    // 在中点所在的页边界处拆分，两半都至少包含一页的一部分
+    Address middle = (address + size / 2) & ~(kPageSize - 1);
+    if (middle <= address) {
+        middle = pageStart + kPageSize;
+    }
+    MemorySize left = middle - address;
+    return readBisect(address, buffer, left, failed) +
+           readBisect(middle, buffer + left, size - left, failed);
+}
+
+size_t MemoryAccess::readBatch(ReadRequest* requests, size_t count) const {
+    if (targetPid_ <= 0) {
+        for (size_t i = 0; i < count; ++i) {
+            requests[i].success = false;
+        }
+        return 0;
+    }
+    
+    return readMemoryBatch(requests, count);
+}
+
+size_t MemoryAccess::readMemoryBatch(ReadRequest* requests, size_t count) const {
+    size_t successCount = 0;
+    std::error_code ec;
+    
+    for (size_t i = 0; i < count; ++i) {
+        ReadRequest& req = requests[i];
+        req.success = req.address != 0 && req.address <= 0x7FFFFFFFFFFF &&
+                      readMemory(req.address, req.buffer, req.size, ec);
+        if (req.success) {
+            successCount++;
+        }
+    }
+    
+    return successCount;
+}
+
+size_t MemoryAccess::readBatchVectored(ReadRequest* requests, size_t count) const {
+    // 每次系统调用最多提交的iovec数量（IOV_MAX 通常为1024）
+    constexpr size_t kMaxIov = 1024;
+    struct iovec local[kMaxIov];
+    struct iovec remote[kMaxIov];
+    
+    size_t successCount = 0;
+    size_t pos = 0;
+    
+    while (pos < count) {
+        // 组装一批有效请求，无效地址直接标记失败
+        size_t batchIndex[kMaxIov];
+        size_t n = 0;
+        while (pos < count && n < kMaxIov) {
+            ReadRequest& req = requests[pos];
+            req.success = false;
+            if (req.address != 0 && req.address <= 0x7FFFFFFFFFFF && req.size > 0) {
+                local[n].iov_base = req.buffer;
+                local[n].iov_len = req.size;
+                remote[n].iov_base = reinterpret_cast<void*>(req.address);
+                remote[n].iov_len = req.size;
+                batchIndex[n] = pos;
+                n++;
+            }
+            pos++;
+        }
+        
+        size_t done = 0;
+        while (done < n) {
+            ssize_t bytesRead = process_vm_readv(targetPid_, local + done, n - done, remote + done, n - done, 0);
+            
+            // 进程不存在或无权限时，剩余请求都不可能成功
+            if (bytesRead < 0 && (errno == ESRCH || errno == EPERM)) {
+                break;
+            }
+            
+            // process_vm_readv 在第一个失败的远程区域处停止，按字节数确认成功的请求
+            size_t remain = bytesRead > 0 ? static_cast<size_t>(bytesRead) : 0;
+            while (done < n && remain >= local[done].iov_len) {
+                remain -= local[done].iov_len;
+                requests[batchIndex[done]].success = true;
+                successCount++;
+                done++;
+            }
+            
+            if (done < n) {
+                // 跳过失败的请求，从下一个继续
+                memset(local[done].iov_base, 0, local[done].iov_len);
+                done++;
+            }
+        }
+    }
+    
+    return successCount;
+}
+
+std::unique_ptr<AsyncReader> MemoryAccess::createAsyncReader(size_t depth) const {
+    return std::make_unique<SyncReader>(*this, depth);
+}
+
 bool MemoryAccess::isValidAddress(Address address) const {
     // 简单检查地址是否为0或非常大的值
     if (address == 0 || address > 0x7FFFFFFFFFFF) {
@@ -384,6 +581,17 @@ bool AndroidMemoryAccess::isPageMapped(Address address) const {
     return isPagePresent(address);
 }
 
+size_t AndroidMemoryAccess::readMemoryBatch(ReadRequest* requests, size_t count) const {
+    return readBatchVectored(requests, count);
+}
+
+std::unique_ptr<AsyncReader> AndroidMemoryAccess::createAsyncReader(size_t depth) const {
+    if (auto reader = IoUringReader::create(*this, targetPid_, depth)) {
+        return reader;
+    }
+    return MemoryAccess::createAsyncReader(depth);
+}
+
 // LinuxMemoryAccess 实现
 LinuxMemoryAccess::LinuxMemoryAccess() : MemoryAccess(), memFd_(-1) {
 }
@@ -449,4 +657,113 @@ bool LinuxMemoryAccess::isPageMapped(Address address) const {
     return isPagePresent(address);
 }
 
+size_t LinuxMemoryAccess::readMemoryBatch(ReadRequest* requests, size_t count) const {
+    return readBatchVectored(requests, count);
+}
+
+std::unique_ptr<AsyncReader> LinuxMemoryAccess::createAsyncReader(size_t depth) const {
+    if (auto reader = IoUringReader::create(*this, targetPid_, depth)) {
+        return reader;
+    }
+    return MemoryAccess::createAsyncReader(depth);
+}
+
+// LocalMemoryAccess 实现
+namespace {
+
+// 当前线程正在进行的容错复制的跳转点，不在复制中时为空。
+// 复制前已在本线程访问过，信号处理函数中读取不会触发 TLS 分配
+thread_local sigjmp_buf* localFaultJump = nullptr;
+
+struct sigaction previousSegvAction;
+struct sigaction previousBusAction;
+std::once_flag faultHandlerOnce;
+
+void localFaultHandler(int sig, siginfo_t* info, void* context) {
+    sigjmp_buf* jump = localFaultJump;
+    if (jump) {
+        localFaultJump = nullptr;
+        siglongjmp(*jump, 1);
+    }
+
+    // 不是容错复制引起的错误：交给原来的处理方式
+    const struct sigaction& previous = sig == SIGSEGV ? previousSegvAction : previousBusAction;
+    if (previous.sa_flags & SA_SIGINFO) {
+        if (previous.sa_sigaction) {
+            previous.sa_sigaction(sig, info, context);
+            return;
+        }
+    } else if (previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN) {
+        previous.sa_handler(sig);
+        return;
+    }
+    // 恢复默认处理，返回后重新执行出错的指令再次触发信号
+    sigaction(sig, &previous, nullptr);
+}
+
+void installLocalFaultHandler() {
+    struct sigaction action{};
+    action.sa_sigaction = localFaultHandler;
+    sigemptyset(&action.sa_mask);
+    // SA_NODEFER：处理期间不屏蔽该信号，siglongjmp 时不需要恢复信号掩码（sigsetjmp 不保存掩码，避免每次复制一次系统调用）
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_NODEFER;
+    sigaction(SIGSEGV, &action, &previousSegvAction);
+    sigaction(SIGBUS, &action, &previousBusAction);
+}
+
+} // namespace
+
+LocalMemoryAccess::LocalMemoryAccess() : MemoryAccess() {
+    std::call_once(faultHandlerOnce, installLocalFaultHandler);
+    setTargetProcess(getpid());
+}
+
+LocalMemoryAccess::~LocalMemoryAccess() = default;
+
+bool LocalMemoryAccess::safeCopy(void* dst, const void* src, size_t size) {
+    std::call_once(faultHandlerOnce, installLocalFaultHandler);
+
+    sigjmp_buf jump;
+    sigjmp_buf* volatile outer = localFaultJump;
+    if (sigsetjmp(jump, 0) != 0) {
+        localFaultJump = outer;
+        return false;
+    }
+
+    localFaultJump = &jump;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    memcpy(dst, src, size);
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    localFaultJump = outer;
+    return true;
+}
+
+bool LocalMemoryAccess::readMemory(Address address, void* buffer, MemorySize size, std::error_code& ec) const {
+    if (!safeCopy(buffer, reinterpret_cast<const void*>(address), size)) {
+        ec = make_error_code(MemError::ReadError);
+        return false;
+    }
+    return true;
+}
+
+bool LocalMemoryAccess::isPageMapped(Address address) const {
+    uint8_t probe;
+    return safeCopy(&probe, reinterpret_cast<const void*>(address), 1);
+}
+
+size_t LocalMemoryAccess::readMemoryBatch(ReadRequest* requests, size_t count) const {
+    size_t successCount = 0;
+    for (size_t i = 0; i < count; ++i) {
+        ReadRequest& req = requests[i];
+        req.success = req.address != 0 && req.address <= 0x7FFFFFFFFFFF &&
+                      safeCopy(req.buffer, reinterpret_cast<const void*>(req.address), req.size);
+        if (req.success) {
+            successCount++;
+        } else {
+            memset(req.buffer, 0, req.size);
+        }
+    }
+    return successCount;
+}
+
 } // namespace memchainer
@@ -10,22 +10,29 @@
 #include <algorithm>
 #include <cstdio>
 #include <string>
-#include <fstream>
 #include <iostream>
-#include <sstream>
 #include <unordered_map>
 
 namespace memchainer {
 
-// 全局变量实例化
-std::vector<MemoryRegion*> memoryRegionList;//待扫描数据段
-std::vector<MemoryRegion*> staticRegionList;//静态区域段
 
+bool isFind(std::string_view name , std::string_view str){
+    return name.find(str)!= std::string_view::npos ;
+}
+
+namespace {
 
-bool isFind(std::string name , std::string str){
-    return name.find(str)!= std::string::npos ;
+// FNV-1a，用于比较两次加载的区域路径
+uint64_t hashPath(std::string_view path) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char c : path) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ULL;
+    }
+    return hash;
 }
 
+} // namespace
+
 
 MemoryMap::MemoryMap() : regionFilter_(MemoryRegionType::All), currentPid_(-1) {
 }
@@ -35,13 +42,101 @@ MemoryMap::~MemoryMap() {
 }
 
 bool MemoryMap::loadMemoryMap(ProcessId pid) {
+    // 同一进程重新加载时保留旧区域表用于比较
+    bool incremental = pid == currentPid_ && !regions_.empty();
+    uint64_t previousFingerprint = incremental ? getFingerprint() : 0;
+    std::vector<MemoryRegion> previous;
+    if (incremental) {
+        previous.swap(regions_);
+    }
+
     // 清除旧数据
     clear();
     
     currentPid_ = pid;
     
     // 解析进程内存映射
-    return parseProcessMaps(pid);
+    if (!parseProcessMaps(pid)) {
+        lastDiff_ = MapsDiff{};
+        return false;
+    }
+    diffRegions(previous, incremental, previousFingerprint);
+    return true;
+}
+
+void MemoryMap::diffRegions(const std::vector<MemoryRegion>& previous, bool incremental,
+                            uint64_t previousFingerprint) {
+    MapsDiff diff;
+    diff.incremental = incremental;
+    diff.previousFingerprint = previousFingerprint;
+    diff.changes.assign(regions_.size(), RegionChange::Added);
+    diff.previousIds.assign(regions_.size(), INVALID_REGION_ID);
+
+    // 两张表都按起始地址排序，先按起始地址归并匹配；起始地址变化（向下增长的栈）再按结束地址匹配
+    std::vector<uint8_t> matched(previous.size(), 0);
+    std::unordered_map<Address, size_t> previousByEnd;
+    size_t cursor = 0;
+    for (size_t i = 0; i < regions_.size(); ++i) {
+        const MemoryRegion& region = regions_[i];
+        while (cursor < previous.size() && previous[cursor].startAddress < region.startAddress) {
+            ++cursor;
+        }
+        const MemoryRegion* old = nullptr;
+        size_t oldIndex = 0;
+        if (cursor < previous.size() && previous[cursor].startAddress == region.startAddress &&
+            previous[cursor].pathHash == region.pathHash && !matched[cursor]) {
+            old = &previous[cursor];
+            oldIndex = cursor;
+        } else {
+            if (previousByEnd.empty() && !previous.empty()) {
+                for (size_t j = 0; j < previous.size(); ++j) {
+                    previousByEnd.emplace(previous[j].endAddress, j);
+                }
+            }
+            auto it = previousByEnd.find(region.endAddress);
+            if (it != previousByEnd.end() && previous[it->second].pathHash == region.pathHash &&
+                !matched[it->second]) {
+                old = &previous[it->second];
+                oldIndex = it->second;
+            }
+        }
+
+        uint64_t size = region.endAddress - region.startAddress;
+        // 类型由路径和权限决定（parseProcessModule 会按 ELF 修正上次的类型），不参与比较
+        if (!old || old->protection != region.protection) {
+            diff.added++;
+            diff.changedBytes += size;
+            continue;
+        }
+        matched[oldIndex] = 1;
+        diff.previousIds[i] = static_cast<RegionId>(oldIndex);
+        if (old->startAddress == region.startAddress && old->endAddress == region.endAddress) {
+            diff.changes[i] = RegionChange::Unchanged;
+            diff.unchanged++;
+            diff.unchangedBytes += size;
+        } else {
+            diff.changes[i] = RegionChange::Resized;
+            diff.resized++;
+            diff.changedBytes += size;
+        }
+    }
+
+    for (size_t j = 0; j < previous.size(); ++j) {
+        if (!matched[j]) {
+            diff.removed.push_back(previous[j]);
+        }
+    }
+    lastDiff_ = std::move(diff);
+}
+
+void MemoryMap::printMapsDiff() const {
+    if (!lastDiff_.incremental) {
+        printf("内存映射: 首次加载 %zu 个区域\n", regions_.size());
+        return;
+    }
+    printf("内存映射变化: 未变 %zu 个 (%.2f MB)，新增 %zu 个，大小变化 %zu 个 (共 %.2f MB)，移除 %zu 个\n",
+           lastDiff_.unchanged, lastDiff_.unchangedBytes / (1024.0 * 1024.0), lastDiff_.added,
+           lastDiff_.resized, lastDiff_.changedBytes / (1024.0 * 1024.0), lastDiff_.removed.size());
 }
 
 void MemoryMap::printRegionInfo(std::vector<MemoryRegion*> memoryRegions_) {
@@ -72,14 +167,30 @@ int MemoryMap::getRegionFilter() const {
 
 std::vector<MemoryRegion*> MemoryMap::getFilteredRegions()  {
     std::vector<MemoryRegion*> result;
+    filterStats_ = RegionFilterStats{};
 
-    for (auto* region : memoryRegions_) {
+    for (auto& entry : regions_) {
+        MemoryRegion* region = &entry;
        
-        //unknow全部过滤
+        //unknow全部过滤，其余按类型掩码
         if (region->type==Unknown) {
           region->isFilterable=true;
+        }
+        if (!(region->type & regionFilter_)) {
+          filterStats_.typeMask.add(region);
+          continue;
+        }
+        if (smartFilter_) {
+          if (RegionFilterStats::Rule* rule = matchSmartRule(region)) {
+            rule->add(region);
+            continue;
+          }
+        } else if (!nonResident_.empty() && nonResident_.count(region->startAddress)) {
+          // 没有驻留页的区域不扫描
+          filterStats_.nonResident.add(region);
           continue;
         }
+        filterStats_.selected.add(region);
         result.push_back(region);
     
     }
@@ -87,70 +198,340 @@ std::vector<MemoryRegion*> MemoryMap::getFilteredRegions()  {
     return result;
 }
 
+void MemoryMap::applySmartFilter() {
+    smartFilter_ = true;
+}
+
+RegionFilterStats::Rule* MemoryMap::matchSmartRule(const MemoryRegion* region) {
+    // 图形/驱动映射（/dev/*、[anon:dmabuf] 等）类型为 Unknown，已被类型掩码排除，这里不再匹配
+    uint64_t size = region->endAddress - region->startAddress;
+    bool isStatic = (region->type & (Code_app | C_data | C_bss)) != 0 || isStaticRegion(region->id);
+
+    if (region->protection == PROT_NONE) {
+        return &filterStats_.guard;
+    }
+    if (!(region->protection & PROT_READ)) {
+        return &filterStats_.unreadable;
+    }
+    if (!nonResident_.empty() && nonResident_.count(region->startAddress)) {
+        return &filterStats_.nonResident;
+    }
+    if (!isStatic && size < smartFilterOptions_.minRegionSize) {
+        return &filterStats_.tiny;
+    }
+    if (!isStatic && size > smartFilterOptions_.maxRegionSize) {
+        return &filterStats_.oversize;
+    }
+    return nullptr;
+}
+
+void MemoryMap::printFilterStats() const {
+    auto printRule = [](const char* name, const RegionFilterStats::Rule& rule) {
+        if (rule.regions > 0) {
+            printf("  %6zu 个区域 %10.2f MB  %s\n", rule.regions, rule.bytes / (1024.0 * 1024.0), name);
+        }
+    };
+    printf("区域过滤统计:\n");
+    printRule("类型不匹配", filterStats_.typeMask);
+    printRule("保护页", filterStats_.guard);
+    printRule("不可读", filterStats_.unreadable);
+    printRule("无驻留页", filterStats_.nonResident);
+    printRule("过小", filterStats_.tiny);
+    printRule("过大", filterStats_.oversize);
+    printf("  %6zu 个区域 %10.2f MB  扫描\n", filterStats_.selected.regions,
+           filterStats_.selected.bytes / (1024.0 * 1024.0));
+}
+
 MemoryRegion* MemoryMap::addCustomRegion(Address start, Address end, const char* name, bool filterable) {
-    auto* region = new MemoryRegion(start, end, MemoryRegionType::Unknown, name, 0, filterable);
-    memoryRegions_.push_back(region);
-    staticRegionList.push_back(region); // 添加到全局静态列表
-    return region;
+    // 自定义区域加入静态区域列表
+    return addRegion(MemoryRegion(start, end, MemoryRegionType::Unknown, name, 0, filterable), true);
+}
+
+MemoryRegion* MemoryMap::addRegion(const MemoryRegion& region, bool isStatic) {
+    if (regions_.size() >= MAX_REGION_COUNT) {
+        std::cerr << "内存区域超过 " << MAX_REGION_COUNT << " 个，忽略: " << region.name << std::endl;
+        return nullptr;
+    }
+    bool inOrder = regions_.empty() || region.startAddress >= regions_.back().startAddress;
+    const MemoryRegion* oldData = regions_.data();
+    regions_.push_back(region);
+    if (regions_.back().pathHash == 0) {
+        regions_.back().pathHash = hashPath(region.name);
+    }
+    staticFlags_.push_back(isStatic ? 1 : 0);
+
+    if (!inOrder || regions_.data() != oldData) {
+        // 乱序或数组重新分配：整体重建，返回同一起始地址中最后加入的区域
+        Address start = region.startAddress;
+        finalizeRegions();
+        auto it = std::upper_bound(regionStarts_.begin(), regionStarts_.end(), start);
+        return &regions_[(it - regionStarts_.begin()) - 1];
+    }
+
+    // 按地址顺序追加（快照恢复）时增量更新查找表
+    MemoryRegion& added = regions_.back();
+    added.id = static_cast<RegionId>(regions_.size() - 1);
+    regionStarts_.push_back(added.startAddress);
+    regionEnds_.push_back(added.endAddress);
+    nameIndex_.emplace(std::string_view(added.name), added.id);
+    if (isStatic) {
+        staticRegions_.push_back(&added);
+    }
+    return &added;
+}
+
+void MemoryMap::finalizeRegions() {
+    // maps 本身按地址排序，只有手动添加的区域可能乱序
+    staticFlags_.resize(regions_.size(), 0);
+    auto byStart = [](const MemoryRegion& a, const MemoryRegion& b) { return a.startAddress < b.startAddress; };
+    if (!std::is_sorted(regions_.begin(), regions_.end(), byStart)) {
+        std::vector<size_t> order(regions_.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            return regions_[a].startAddress < regions_[b].startAddress;
+        });
+        std::vector<MemoryRegion> sorted;
+        std::vector<uint8_t> flags;
+        sorted.reserve(regions_.size());
+        flags.reserve(regions_.size());
+        for (size_t index : order) {
+            sorted.push_back(regions_[index]);
+            flags.push_back(staticFlags_[index]);
+        }
+        regions_.swap(sorted);
+        staticFlags_.swap(flags);
+    }
+
+    regionStarts_.resize(regions_.size());
+    regionEnds_.resize(regions_.size());
+    nameIndex_.clear();
+    staticRegions_.clear();
+    for (size_t i = 0; i < regions_.size(); ++i) {
+        MemoryRegion& region = regions_[i];
+        region.id = static_cast<RegionId>(i);
+        regionStarts_[i] = region.startAddress;
+        regionEnds_[i] = region.endAddress;
+        // 同名区域取第一个
+        nameIndex_.emplace(std::string_view(region.name), region.id);
+        if (staticFlags_[i]) {
+            staticRegions_.push_back(&region);
+        }
+    }
+}
+
+RegionId MemoryMap::findRegionId(Address address) const {
+    size_t count = regionStarts_.size();
+    if (count == 0 || address < regionStarts_[0]) {
+        return INVALID_REGION_ID;
+    }
+
+    // 无分支二分：base 始终指向起始地址 <= address 的最后候选
+    const Address* base = regionStarts_.data();
+    while (count > 1) {
+        size_t half = count / 2;
+        base = base[half] <= address ? base + half : base;
+        count -= half;
+    }
+    size_t index = static_cast<size_t>(base - regionStarts_.data());
+    return address < regionEnds_[index] ? static_cast<RegionId>(index) : INVALID_REGION_ID;
 }
 
 void MemoryMap::clear() {
     // 清除内存区域
-        // 从全局列表中移除
-        memoryRegionList.clear();
-        staticRegionList.clear();
-        for (auto* region : memoryRegions_) 
-            delete region;
-    memoryRegions_.clear();
+    staticRegions_.clear();
+    regions_.clear();
+    regionStarts_.clear();
+    regionEnds_.clear();
+    staticFlags_.clear();
+    nameIndex_.clear();
+    nonResident_.clear();
+    nonResidentBytes_ = 0;
+    modules_.clear();
+    buildIdIndex_.clear();
+}
+
+MemoryRegion* MemoryMap::findRegionByName(const std::string& name) {
+    auto it = nameIndex_.find(name);
+    return it != nameIndex_.end() ? &regions_[it->second] : nullptr;
+}
+
+Address MemoryMap::resolveModuleBase(const std::string& name) {
+    if (MemoryRegion* region = findRegionByName(name)) {
+        return region->baseAddress();
+    }
+    // 模块改名或换了安装路径时按构建 ID 匹配
+    auto at = name.rfind('@');
+    if (at != std::string::npos) {
+        auto it = buildIdIndex_.find(name.substr(at + 1));
+        if (it != buildIdIndex_.end()) {
+            return modules_[it->second].loadBias;
+        }
+    }
+    return 0;
 }
 
 size_t MemoryMap::getRegionCount() const {
-    return memoryRegions_.size();
+    return regions_.size();
+}
+
+uint64_t MemoryMap::getFingerprint() const {
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto mix = [&hash](const void* data, size_t size) {
+        const auto* p = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ p[i]) * 0x100000001b3ULL;
+        }
+    };
+    for (const auto& entry : regions_) {
+        const MemoryRegion* region = &entry;
+        mix(&region->startAddress, sizeof(region->startAddress));
+        mix(&region->endAddress, sizeof(region->endAddress));
+        mix(&region->type, sizeof(region->type));
+        mix(region->name, strnlen(region->name, sizeof(region->name)));
+    }
+    return hash;
+}
+
+namespace {
+
+// 解析十六进制数，p 停在第一个非十六进制字符
+inline uint64_t parseHex(const char*& p, const char* end) {
+    uint64_t value = 0;
+    for (; p < end; ++p) {
+        char c = *p;
+        unsigned digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            break;
+        }
+        value = (value << 4) | digit;
+    }
+    return value;
+}
+
+inline uint64_t parseDecimal(const char*& p, const char* end) {
+    uint64_t value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+        value = value * 10 + (*p - '0');
+    }
+    return value;
+}
+
+inline const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+    return p;
+}
+
+inline const char* skipField(const char* p, const char* end) {
+    while (p < end && *p != ' ' && *p != '\t') {
+        ++p;
+    }
+    return skipSpaces(p, end);
+}
+
+// maps/smaps 的区域行以小写十六进制地址开头，smaps 的统计行以大写字母开头
+inline bool isMappingLine(const char* p, const char* end) {
+    return p < end && ((*p >= '0' && *p <= '9') || (*p >= 'a' && *p <= 'f'));
+}
+
+} // namespace
+
+ssize_t MemoryMap::readProcFile(const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    // /proc 文件没有大小，缓冲区不够时翻倍
+    if (readBuffer_.size() < 256 * 1024) {
+        readBuffer_.resize(256 * 1024);
+    }
+    size_t used = 0;
+    while (true) {
+        if (used == readBuffer_.size()) {
+            readBuffer_.resize(readBuffer_.size() * 2);
+        }
+        ssize_t n = read(fd, readBuffer_.data() + used, readBuffer_.size() - used);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            close(fd);
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        used += static_cast<size_t>(n);
+    }
+    close(fd);
+    return static_cast<ssize_t>(used);
 }
 
 bool MemoryMap::parseProcessMaps(ProcessId pid) {
     char mapsPath[64];
     snprintf(mapsPath, sizeof(mapsPath), "/proc/%d/maps", pid);
     
-    std::ifstream mapsFile(mapsPath);
-    if (!mapsFile.is_open()) {
+    ssize_t length = readProcFile(mapsPath);
+    if (length < 0) {
         return false;
     }
     
-    // 用于跟踪区域名称计数
-    std::unordered_map<std::string, int> nameCountMap;
+    // 用于跟踪区域名称计数（键指向 readBuffer_，只在本次解析中使用）
+    std::unordered_map<std::string_view, int> nameCountMap;
     
-    std::string line;
-    while (std::getline(mapsFile, line)) {
+    char* cursor = readBuffer_.data();
+    char* bufferEnd = cursor + length;
+    while (cursor < bufferEnd) {
         // 解析每行内存映射信息
         // 格式: address perms offset dev inode pathname
-        
-        std::istringstream iss(line);
-        std::string addressRange, permissions, offset, dev, inode, pathname;
-        
-        iss >> addressRange >> permissions >> offset >> dev >> inode;
-        
-        // 读取路径名（可能包含空格）
-        std::getline(iss, pathname);
-        // 去除前导空格
-        if (!pathname.empty()) {
-            auto pos = pathname.find_first_of("/");
-            if (pos != std::string::npos)
-            {
-                pathname = pathname.substr(pos);
-                //std::cout << pathname  << "pos  " << pos << std::endl;
-            }
-            
+        char* lineEnd = static_cast<char*>(memchr(cursor, '\n', bufferEnd - cursor));
+        if (!lineEnd) {
+            lineEnd = bufferEnd;
         }
+        const char* p = cursor;
+        char* next = lineEnd + (lineEnd < bufferEnd ? 1 : 0);
         
         // 解析地址范围
-        size_t dashPos = addressRange.find('-');
-        if (dashPos == std::string::npos) {
+        Address startAddr = parseHex(p, lineEnd);
+        if (p >= lineEnd || *p != '-') {
+            cursor = next;
             continue;
         }
-        
-        Address startAddr = std::stoull(addressRange.substr(0, dashPos), nullptr, 16);
-        Address endAddr = std::stoull(addressRange.substr(dashPos + 1), nullptr, 16);
+        ++p;
+        Address endAddr = parseHex(p, lineEnd);
+        p = skipSpaces(p, lineEnd);
+
+        const char* permsBegin = p;
+        while (p < lineEnd && *p != ' ' && *p != '\t') {
+            ++p;
+        }
+        std::string_view permissions(permsBegin, p - permsBegin);
+        if (permissions.size() < 4) {
+            cursor = next;
+            continue;
+        }
+
+        // 文件偏移，跳过 dev inode
+        p = skipSpaces(p, lineEnd);
+        uint64_t fileOffset = parseHex(p, lineEnd);
+        p = skipField(skipField(skipSpaces(p, lineEnd), lineEnd), lineEnd);
+
+        // 路径名（可能包含空格）从第一个 / 开始，没有 / 时去除前导空格
+        const char* slash = static_cast<const char*>(memchr(p, '/', lineEnd - p));
+        char* nameBegin = cursor + ((slash ? slash : p) - cursor);
+        *lineEnd = '\0';
+        std::string_view pathname(nameBegin, lineEnd - nameBegin);
         
         // 确定区域类型
         int type = determineRegionType(pathname, permissions);
@@ -162,14 +543,187 @@ bool MemoryMap::parseProcessMaps(ProcessId pid) {
         }
         
         // 创建并添加内存区域
-        auto* region = new MemoryRegion(startAddr, endAddr, type, pathname.c_str(), count);
-        memoryRegions_.push_back(region);
-        //memoryRegionList.push_back(region); // 添加到全局列表
+        if (regions_.size() >= MAX_REGION_COUNT) {
+            std::cerr << "内存区域超过 " << MAX_REGION_COUNT << " 个，忽略其余区域" << std::endl;
+            break;
+        }
+        regions_.emplace_back(startAddr, endAddr, type, nameBegin, count, false,
+                              getPermissionProtFlags(permissions));
+        regions_.back().pathHash = hashPath(pathname);
+        regions_.back().fileOffset = fileOffset;
+        cursor = next;
+    }
+    finalizeRegions();
+
+    nonResident_.clear();
+    nonResidentBytes_ = 0;
+    if (residentFilter_ && !parseProcessSmaps(pid)) {
+        std::cerr << "无法读取 /proc/" << pid << "/smaps，不按驻留页过滤区域" << std::endl;
     }
     
     return true;
 }
 
+bool MemoryMap::parseProcessSmaps(ProcessId pid) {
+    char smapsPath[64];
+    snprintf(smapsPath, sizeof(smapsPath), "/proc/%d/smaps", pid);
+
+    ssize_t length = readProcFile(smapsPath);
+    if (length < 0) {
+        return false;
+    }
+
+    // 每个区域一行地址，之后是 "Rss:   12 kB" 形式的统计行
+    const char* cursor = readBuffer_.data();
+    const char* bufferEnd = cursor + length;
+    bool inRegion = false;
+    Address start = 0;
+    Address end = 0;
+    uint64_t residentKb = 0;
+    auto finish = [&]() {
+        if (inRegion && residentKb == 0) {
+            nonResident_.insert(start);
+            nonResidentBytes_ += end - start;
+        }
+    };
+
+    while (cursor < bufferEnd) {
+        const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', bufferEnd - cursor));
+        if (!lineEnd) {
+            lineEnd = bufferEnd;
+        }
+        const char* p = cursor;
+        cursor = lineEnd + 1;
+
+        if (isMappingLine(p, lineEnd)) {
+            finish();
+            start = parseHex(p, lineEnd);
+            inRegion = p < lineEnd && *p == '-';
+            if (inRegion) {
+                ++p;
+                end = parseHex(p, lineEnd);
+            }
+            residentKb = 0;
+            continue;
+        }
+
+        // 换出到 swap/zram 的页仍有内容，和 Rss 一起计算
+        size_t remaining = static_cast<size_t>(lineEnd - p);
+        size_t keyLength = 0;
+        if (remaining > 4 && memcmp(p, "Rss:", 4) == 0) {
+            keyLength = 4;
+        } else if (remaining > 5 && memcmp(p, "Swap:", 5) == 0) {
+            keyLength = 5;
+        }
+        if (keyLength > 0) {
+            p = skipSpaces(p + keyLength, lineEnd);
+            residentKb += parseDecimal(p, lineEnd);
+        }
+    }
+    finish();
+    return true;
+}
+
+namespace {
+
+// 打开区域映射的文件；路径被截断或在其他挂载空间时使用 /proc/pid/map_files
+int openMappedFile(ProcessId pid, const MemoryRegion& region) {
+    int fd = open(region.name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        char path[96];
+        snprintf(path, sizeof(path), "/proc/%d/map_files/%llx-%llx", pid,
+                 (unsigned long long)region.startAddress, (unsigned long long)region.endAddress);
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+    }
+    return fd;
+}
+
+bool isAnonymousName(const char* name) {
+    return name[0] == '\0' || strcmp(name, "[anon:.bss]") == 0;
+}
+
+} // namespace
+
+void MemoryMap::resolveElfModules(std::vector<ElfRegionInfo>& info) {
+    static constexpr size_t MAX_ELF_CACHE = 4096;
+
+    modules_.clear();
+    buildIdIndex_.clear();
+    info.assign(regions_.size(), ElfRegionInfo{});
+    if (elfCache_.size() > MAX_ELF_CACHE) {
+        elfCache_.clear();
+    }
+
+    for (size_t i = 0; i < regions_.size(); ++i) {
+        const MemoryRegion& first = regions_[i];
+        std::string_view path = first.name;
+        // 应用模块：/data/app 下的 .so，以及不解压直接从 APK 映射的库
+        if (info[i].type != 0 || !isFind(path, "/data/app/") || !(isFind(path, ".so") || isFind(path, ".apk"))) {
+            continue;
+        }
+
+        int fd = openMappedFile(currentPid_, first);
+        if (fd < 0) {
+            continue;
+        }
+        struct stat st;
+        ElfModule module;
+        bool parsed = false;
+        if (fstat(fd, &st) == 0) {
+            char key[64];
+            snprintf(key, sizeof(key), ":%llx:%llx:%llx:%lld", (unsigned long long)first.fileOffset,
+                     (unsigned long long)st.st_ino, (unsigned long long)st.st_size, (long long)st.st_mtime);
+            auto cached = elfCache_.find(first.name + std::string(key));
+            if (cached != elfCache_.end()) {
+                module = cached->second;
+            } else {
+                // 解析失败也缓存（loads 为空），不是 ELF 头的映射下次不再读取
+                if (!module.parse(fd, first.fileOffset)) {
+                    module.loads.clear();
+                }
+                elfCache_.emplace(first.name + std::string(key), module);
+            }
+            parsed = !module.loads.empty();
+        }
+        close(fd);
+        if (!parsed || !module.computeLoadBias(first.startAddress, 0, first.endAddress - first.startAddress)) {
+            continue;
+        }
+
+        module.path = first.name;
+        auto slash = module.path.find_last_of('/');
+        module.name = module.path.substr(slash + 1);
+
+        // 模块范围内同一文件的映射和匿名映射（bss）归入模块，与静态数据范围重叠的是静态区域
+        uint32_t moduleIndex = static_cast<uint32_t>(modules_.size());
+        Address imageEnd = module.loadBias + module.imageEnd;
+        for (size_t j = i; j < regions_.size() && regions_[j].startAddress < imageEnd; ++j) {
+            const MemoryRegion& region = regions_[j];
+            bool anonymous = isAnonymousName(region.name);
+            if (info[j].type != 0 || (region.pathHash != first.pathHash && !anonymous)) {
+                continue;
+            }
+            int type = -1;
+            for (const ElfStaticRange& range : module.staticRanges) {
+                if (module.loadBias + range.start < region.endAddress && module.loadBias + range.end > region.startAddress) {
+                    type = (type == MemoryRegionType::C_data || range.type == MemoryRegionType::C_data)
+                               ? MemoryRegionType::C_data : range.type;
+                }
+            }
+            if (anonymous && type < 0) {
+                continue;
+            }
+            info[j].type = type;
+            info[j].module = moduleIndex;
+        }
+
+        if (!module.buildId.empty()) {
+            buildIdIndex_.emplace(module.buildId, moduleIndex);
+        }
+        modules_.push_back(std::move(module));
+    }
+}
+
 bool MemoryMap::parseProcessModule() {
     
     if (currentPid_ <= 0) {
@@ -177,11 +731,22 @@ bool MemoryMap::parseProcessModule() {
     }
     
     //printRegionInfo();
+    // 先按 maps 中的原始路径解析 ELF，得到各模块的静态数据范围
+    std::vector<ElfRegionInfo> elfInfo;
+    resolveElfModules(elfInfo);
+
     //静态区域 xa cb（bss cd
     auto  static_type = MemoryRegionType::Code_app | MemoryRegionType::C_data ;
 
-       staticRegionList.clear();
-    for (auto* region : memoryRegions_) {
+    auto setName = [](MemoryRegion* region, const std::string& name) {
+        memset(region->name, 0, sizeof(region->name));
+        strncpy(region->name, name.c_str(), sizeof(region->name) - 1);
+    };
+
+    std::fill(staticFlags_.begin(), staticFlags_.end(), 0);
+    for (size_t i = 0; i < regions_.size(); ++i) {
+        MemoryRegion* region = &regions_[i];
+        region->staticBase = 0;
         //处理名字 获取最后一个/后面的部分
         std::string name = region->name;
         auto pos = name.find_last_of("/");
@@ -189,18 +754,39 @@ bool MemoryMap::parseProcessModule() {
         {
            name = name.substr(pos+1);
            name = name + "[" + std::to_string(region->count) + "]";
-           memset(region->name,0,sizeof(region->name));
-           strncpy(region->name,name.c_str(),name.length());
+           setName(region, name);
+        }
+
+        // 已解析 ELF 的模块：只有与 .data/.data.rel.ro/.bss 重叠的区域是静态区域
+        if (elfInfo[i].type != 0) {
+            if (elfInfo[i].type < 0) {
+                continue;
+            }
+            const ElfModule& module = modules_[elfInfo[i].module];
+            staticFlags_[i] = 1;
+            // APK 中的库和未标注的匿名 bss 按路径推断不出类型，以 ELF 为准才能通过类型掩码
+            region->type = elfInfo[i].type;
+            if (buildIdKeys_ && !module.buildId.empty()) {
+                setName(region, module.key());
+                region->staticBase = module.loadBias;
+            } else if (isAnonymousName(region->name)) {
+                bool sameModule = i > 0 && elfInfo[i - 1].type != 0 && elfInfo[i - 1].module == elfInfo[i].module;
+                setName(region, (sameModule ? std::string(regions_[i - 1].name) : module.name) + ":bss");
+            }
+            continue;
         }
-        
-        
      
         // 如果找到模块
         if ((region->type & static_type )) {
-            staticRegionList.push_back(region);
+            staticFlags_[i] = 1;
         }else if (region->type & MemoryRegionType::C_bss)
         {
-            auto pre = std::prev(region);
+            // bss 紧跟在模块最后一个数据段之后（前一个区域属于已解析的模块时以 ELF 为准）
+            if (i == 0 || elfInfo[i - 1].type != 0)
+            {
+                continue;
+            }
+            const MemoryRegion* pre = &regions_[i - 1];
             if ( !(pre->type & static_type))
             {
                 continue;
@@ -217,19 +803,20 @@ bool MemoryMap::parseProcessModule() {
                 prename = prename + ":bss";
             }
             //std::cout << "   " << prename << std::endl;
-            memset(region->name,0,sizeof(region->name));
-            strncpy(region->name,prename.c_str(),prename.length());
+            setName(region, prename);
             //std::cout << "   " << region->name << std::endl;
-            staticRegionList.push_back(region);
+            staticFlags_[i] = 1;
         }
         
     }
-    //printRegionInfo(staticRegionList);
+    // 名称已改变，重建名称索引和静态区域列表
+    finalizeRegions();
+    //printRegionInfo(staticRegions_);
     return true;
 }
 
 //只需分出 a ca cb cd xa o？ 其他全扔unknow用不上
-int MemoryMap::determineRegionType(const std::string& name, const std::string& permissions) {
+int MemoryMap::determineRegionType(std::string_view name, std::string_view permissions) {
   
     // 匿名映射 || isFind(name, "[anon:")
  if ((name.empty()  || name == " ")&&permissions[0]=='r') {
@@ -258,7 +845,7 @@ int MemoryMap::determineRegionType(const std::string& name, const std::string& p
     return MemoryRegionType::Unknown;
 }
 
-int MemoryMap::getPermissionProtFlags(const std::string& permissions) {
+int MemoryMap::getPermissionProtFlags(std::string_view permissions) {
     int prot = PROT_NONE;
     
     if (permissions.length() >= 3) {
@@ -1,104 +1,447 @@
 #include "memory/memory_cache.h"
+#include "common/thread_pool.h"
 #include <algorithm>
-#include <chrono>
 #include <cstring>
 
 namespace memchainer {
 
+namespace {
+
+constexpr size_t kCachePageSize = 4096;
+
+size_t roundUpPowerOfTwo(size_t value) {
+    size_t result = kCachePageSize;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+std::atomic<uint64_t> nextCacheId{1};
+
+// 线程最近访问的缓存的块访问模式
+struct AccessPattern {
+    uint64_t cacheId = 0;
+    Address lastBlock = 0;
+    int64_t stride = 0;          // 字节，上次访问末块到本次首块的距离
+    Address prefetchedUntil = 0; // 已预取到的最远块
+};
+
+thread_local AccessPattern threadPattern;
+
+} // namespace
+
 MemoryCache::MemoryCache(size_t blockSize)
-    : blockSize_(blockSize), maxCacheBlocks_(64),
-      cacheHits_(0), cacheMisses_(0) {
+    : blockSize_(roundUpPowerOfTwo(blockSize)), maxCacheBlocks_(64),
+      cacheId_(nextCacheId.fetch_add(1)), prefetchControl_(std::make_shared<PrefetchControl>()) {
+    pagesPerBlock_ = blockSize_ / kCachePageSize;
+    maskWords_ = (pagesPerBlock_ + 63) / 64;
+    rebuild();
 }
 
 MemoryCache::~MemoryCache() {
-    clear();
+    stopPrefetches();
+}
+
+void MemoryCache::stopPrefetches() {
+    std::unique_lock<std::mutex> lock(prefetchControl_->mutex);
+    prefetchControl_->stopped = true;
+    prefetchControl_->idle.wait(lock, [this] { return prefetchControl_->running == 0; });
 }
 
-bool MemoryCache::readMemory(const std::shared_ptr<MemoryAccess>& memAccess, 
+void MemoryCache::rebuild() {
+    // 排队的预取任务作废，换用新的计数，避免写入重新分配前的槽位
+    if (shards_) {
+        stopPrefetches();
+        prefetchControl_ = std::make_shared<PrefetchControl>();
+    }
+
+    size_t blocks = std::max<size_t>(maxCacheBlocks_, 1);
+
+    // 分片数取2的幂，每个分片至少4个块
+    shardCount_ = 1;
+    while (shardCount_ < MAX_SHARDS && shardCount_ * 2 * 4 <= blocks) {
+        shardCount_ *= 2;
+    }
+
+    shards_.reset(new Shard[shardCount_]);
+    slots_.assign(blocks, Slot{});
+    validPages_.assign(blocks * maskWords_, 0);
+    // 不初始化，未使用的槽位不占用物理内存
+    slab_.reset(new uint8_t[blocks * blockSize_]);
+
+    // 槽位按分片均分
+    for (size_t i = 0; i < blocks; ++i) {
+        shards_[i % shardCount_].freeSlots.push_back(static_cast<uint32_t>(i));
+    }
+    for (size_t i = 0; i < shardCount_; ++i) {
+        shards_[i].index.reserve(shards_[i].freeSlots.size() * 2);
+    }
+}
+
+void MemoryCache::setMaxCacheSize(size_t maxBlocks) {
+    maxCacheBlocks_ = maxBlocks;
+    rebuild();
+    setPrefetchDepth(prefetchDepth_);
+}
+
+void MemoryCache::setPrefetchDepth(size_t depth) {
+    prefetchDepth_ = std::min(depth, maxCacheBlocks_ / 2);
+}
+
+MemoryCache::Shard& MemoryCache::shardFor(Address blockStart) const {
+    return shards_[(blockStart / blockSize_) & (shardCount_ - 1)];
+}
+
+bool MemoryCache::readMemory(const std::shared_ptr<MemoryAccess>& memAccess,
                            Address address, void* buffer, size_t size) {
     // 检查边界情况
     if (!buffer || size == 0) {
         return false;
     }
-    
-    // 如果读取跨越多个块，分块处理
-    if (getBlockStartAddress(address) != getBlockStartAddress(address + size - 1)) {
-        // 第一个块
-        Address firstBlockEnd = getBlockStartAddress(address) + blockSize_;
-        size_t firstPartSize = firstBlockEnd - address;
-        
-        // 读取第一个块
-        if (!readMemory(memAccess, address, buffer, firstPartSize)) {
+
+    observeAccess(memAccess, getBlockStartAddress(address), getBlockStartAddress(address + size - 1));
+
+    // 跨块读取逐块处理
+    uint8_t* out = static_cast<uint8_t*>(buffer);
+    while (size > 0) {
+        Address blockStart = getBlockStartAddress(address);
+        size_t offset = static_cast<size_t>(address - blockStart);
+        size_t length = std::min(size, blockSize_ - offset);
+
+        if (!readBlock(*memAccess, blockStart, offset, out, length)) {
             return false;
         }
-        
-        // 读取剩余部分
-        return readMemory(memAccess, 
-                        firstBlockEnd, 
-                        static_cast<uint8_t*>(buffer) + firstPartSize, 
-                        size - firstPartSize);
-    }
-    
-    // 计算块地址
-    Address blockStart = getBlockStartAddress(address);
-    
-    // 尝试从缓存读取
+        address += length;
+        out += length;
+        size -= length;
+    }
+    return true;
+}
+
+bool MemoryCache::readBlock(const MemoryAccess& memAccess, Address blockStart, size_t offset,
+                            uint8_t* out, size_t length) {
+    Shard& shard = shardFor(blockStart);
+    uint32_t slot = NIL;
     {
-        std::lock_guard<std::mutex> lock(cacheMutex_);
-        
-        auto it = cacheBlocks_.find(blockStart);
-        if (it != cacheBlocks_.end() && it->second.isValid) {
-            // 缓存命中
-            cacheHits_++;
-            
-            // 更新访问时间
-            it->second.lastAccess = std::chrono::steady_clock::now().time_since_epoch().count();
-            
-            // 计算偏移量并复制数据
-            size_t offset = static_cast<size_t>(address - blockStart);
-            if (offset + size <= it->second.data.size()) {
-                memcpy(buffer, it->second.data.data() + offset, size);
+        std::unique_lock<std::mutex> lock(shard.mutex);
+
+        // 其他线程（包括预取）正在加载该块时等待，不重复读取
+        auto it = shard.index.find(blockStart);
+        while (it != shard.index.end() && slots_[it->second].state == SlotState::Loading) {
+            shard.loaded.wait(lock);
+            it = shard.index.find(blockStart);
+        }
+        if (it != shard.index.end()) {
+            const Slot& cached = slots_[it->second];
+            if (cached.state == SlotState::Valid ||
+                (cached.state == SlotState::Partial && rangeValid(it->second, offset, length))) {
+                // 缓存命中，持锁复制，期间槽位不会被淘汰
+                shard.hits++;
+                if (slots_[it->second].prefetched) {
+                    slots_[it->second].prefetched = false;
+                    shard.prefetchUseful++;
+                }
+                unlink(shard, it->second);
+                pushFront(shard, it->second);
+                memcpy(out, slotData(it->second) + offset, length);
                 return true;
             }
+            // 请求的页不可读：直接读取
+            shard.misses++;
+        } else {
+            shard.misses++;
+            slot = allocateSlot(shard);
+            if (slot != NIL) {
+                slots_[slot].blockStart = blockStart;
+                slots_[slot].state = SlotState::Loading;
+                slots_[slot].prefetched = false;
+                shard.index[blockStart] = slot;
+            }
         }
     }
-    
-    // 缓存未命中，读取一个完整块
-    cacheMisses_++;
-    
-    // 创建新缓存块
-    CacheBlock newBlock;
-    newBlock.startAddress = blockStart;
-    newBlock.endAddress = blockStart + blockSize_;
-    newBlock.data.resize(blockSize_);
-    newBlock.lastAccess = std::chrono::steady_clock::now().time_since_epoch().count();
-    
-    // 尝试读取整个块
+
     std::error_code ec;
-    newBlock.isValid = memAccess->read(blockStart, newBlock.data.data(), blockSize_, ec);
-    
-    if (newBlock.isValid) {
-        // 计算偏移量并复制数据
-        size_t offset = static_cast<size_t>(address - blockStart);
-        memcpy(buffer, newBlock.data.data() + offset, size);
-        
-        // 添加到缓存
-        {
-            std::lock_guard<std::mutex> lock(cacheMutex_);
-            
-            // 检查缓存是否已满
-            if (cacheBlocks_.size() >= maxCacheBlocks_) {
-                evictOldestBlock();
+    if (slot == NIL) {
+        return memAccess.read(blockStart + offset, out, length, ec);
+    }
+
+    // 在锁外读入槽位，加载中的槽位只属于本线程
+    bool whole = fillSlot(memAccess, slot, blockStart);
+    bool valid = rangeValid(slot, offset, length);
+    if (valid) {
+        memcpy(out, slotData(slot) + offset, length);
+    }
+
+    publishSlot(slot, whole);
+    return valid;
+}
+
+bool MemoryCache::loadBlock(const MemoryAccess& memAccess, Address blockStart) {
+    Shard& shard = shardFor(blockStart);
+    uint32_t slot = NIL;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(blockStart);
+        if (it != shard.index.end()) {
+            return slots_[it->second].state != SlotState::Partial;
+        }
+        slot = allocateSlot(shard);
+        if (slot == NIL) {
+            return false;
+        }
+        slots_[slot].blockStart = blockStart;
+        slots_[slot].state = SlotState::Loading;
+        slots_[slot].prefetched = false;
+        shard.index[blockStart] = slot;
+    }
+
+    bool whole = fillSlot(memAccess, slot, blockStart);
+    publishSlot(slot, whole);
+    return whole;
+}
+
+void MemoryCache::publishSlot(uint32_t slot, bool whole) {
+    Shard& shard = shardFor(slots_[slot].blockStart);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        slots_[slot].state = whole ? SlotState::Valid : SlotState::Partial;
+        pushFront(shard, slot);
+    }
+    shard.loaded.notify_all();
+}
+
+void MemoryCache::observeAccess(const std::shared_ptr<MemoryAccess>& memAccess,
+                                Address firstBlock, Address lastBlock) {
+    AccessPattern& pattern = threadPattern;
+    if (pattern.cacheId != cacheId_) {
+        pattern = AccessPattern{};
+        pattern.cacheId = cacheId_;
+        pattern.lastBlock = lastBlock;
+        return;
+    }
+    if (firstBlock == pattern.lastBlock && lastBlock == firstBlock) {
+        return;
+    }
+
+    // 跨多个块的读取按首块计算步长，从末块开始预取
+    int64_t stride = static_cast<int64_t>(firstBlock - pattern.lastBlock);
+    Address blockStart = stride < 0 ? firstBlock : lastBlock;
+    pattern.lastBlock = lastBlock;
+    if (stride == 0 || stride != pattern.stride) {
+        pattern.stride = stride;
+        pattern.prefetchedUntil = blockStart;
+        return;
+    }
+
+    size_t depth = prefetchDepth_.load(std::memory_order_relaxed);
+    uint64_t strideBlocks = static_cast<uint64_t>(stride < 0 ? -stride : stride) / blockSize_;
+    if (depth == 0 || strideBlocks > MAX_PREFETCH_STRIDE || !globalThreadPool) {
+        return;
+    }
+
+    // 已预取的块还剩一半以上时不再发起
+    size_t ahead = 0;
+    int64_t distance = static_cast<int64_t>(pattern.prefetchedUntil - blockStart);
+    if (distance != 0 && (distance < 0) == (stride < 0) && distance % stride == 0) {
+        ahead = static_cast<size_t>(distance / stride);
+    }
+    if (ahead > depth / 2) {
+        return;
+    }
+
+    std::vector<Address> blocks;
+    Address next = blockStart;
+    for (size_t i = 1; i <= depth; ++i) {
+        Address candidate = next + static_cast<Address>(stride);
+        // 越过地址空间两端时停止
+        if ((stride > 0) != (candidate > next)) {
+            break;
+        }
+        next = candidate;
+        if (i > ahead) {
+            blocks.push_back(next);
+        }
+    }
+    if (blocks.empty()) {
+        return;
+    }
+
+    std::shared_ptr<PrefetchControl> control = prefetchControl_;
+    {
+        std::lock_guard<std::mutex> lock(control->mutex);
+        if (control->stopped || control->pending + control->running >= MAX_PENDING_PREFETCHES) {
+            return;
+        }
+        control->pending++;
+    }
+    pattern.prefetchedUntil = next;
+
+    std::shared_ptr<MemoryAccess> access = memAccess;
+    try {
+        globalThreadPool->submit([this, control, access, blocks]() {
+            {
+                std::lock_guard<std::mutex> lock(control->mutex);
+                control->pending--;
+                if (control->stopped) {
+                    return;
+                }
+                control->running++;
+            }
+            prefetchBlocks(access, blocks);
+            std::lock_guard<std::mutex> lock(control->mutex);
+            control->running--;
+            control->idle.notify_all();
+        });
+    } catch (const std::exception&) {
+        std::lock_guard<std::mutex> lock(control->mutex);
+        control->pending--;
+    }
+}
+
+void MemoryCache::prefetchBlocks(const std::shared_ptr<MemoryAccess>& memAccess, const std::vector<Address>& blocks) {
+    // 占用槽位，已缓存或正在加载的块跳过
+    std::vector<uint32_t> claimed;
+    claimed.reserve(blocks.size());
+    for (Address blockStart : blocks) {
+        Shard& shard = shardFor(blockStart);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.index.count(blockStart)) {
+            continue;
+        }
+        uint32_t slot = allocateSlot(shard);
+        if (slot == NIL) {
+            continue;
+        }
+        slots_[slot].blockStart = blockStart;
+        slots_[slot].state = SlotState::Loading;
+        slots_[slot].prefetched = true;
+        shard.index[blockStart] = slot;
+        shard.prefetchIssued++;
+        claimed.push_back(slot);
+    }
+    if (claimed.empty()) {
+        return;
+    }
+
+    // 批量提交，读取失败的块逐页确认
+    std::unique_ptr<AsyncReader> reader = memAccess->createAsyncReader(claimed.size());
+    std::vector<ReadCompletion> completions(claimed.size());
+    size_t next = 0;
+    while (next < claimed.size() || (reader && reader->inFlight() > 0)) {
+        while (reader && next < claimed.size() &&
+               reader->submit(slots_[claimed[next]].blockStart, slotData(claimed[next]), blockSize_, next)) {
+            next++;
+        }
+        if (!reader || reader->inFlight() == 0) {
+            // 无法提交：剩余的块同步读取
+            for (; next < claimed.size(); ++next) {
+                uint32_t slot = claimed[next];
+                publishSlot(slot, fillSlot(*memAccess, slot, slots_[slot].blockStart));
             }
-            
-            cacheBlocks_[blockStart] = std::move(newBlock);
+            break;
         }
-        
-        return true;
+
+        size_t count = reader->reap(completions.data(), completions.size());
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t slot = claimed[completions[i].tag];
+            uint64_t* mask = validPages_.data() + static_cast<size_t>(slot) * maskWords_;
+            if (completions[i].success) {
+                std::fill(mask, mask + maskWords_, ~0ULL);
+            } else {
+                fillPartial(*memAccess, slot, completions[i].address);
+            }
+            publishSlot(slot, completions[i].success);
+        }
+    }
+}
+
+bool MemoryCache::fillSlot(const MemoryAccess& memAccess, uint32_t slot, Address blockStart) {
+    uint64_t* mask = validPages_.data() + static_cast<size_t>(slot) * maskWords_;
+    uint8_t* data = slotData(slot);
+
+    // 整块可读时一次读取；块内有不可读的页（常见于区域末尾的块）时二分读取并记录可读页
+    std::error_code ec;
+    bool valid = memAccess.read(blockStart, data, blockSize_, ec);
+    if (valid) {
+        std::fill(mask, mask + maskWords_, ~0ULL);
+    } else {
+        fillPartial(memAccess, slot, blockStart);
+    }
+    return valid;
+}
+
+void MemoryCache::fillPartial(const MemoryAccess& memAccess, uint32_t slot, Address blockStart) {
+    uint64_t* mask = validPages_.data() + static_cast<size_t>(slot) * maskWords_;
+    FailedRangeSet failed;
+    memAccess.readAdaptive(blockStart, slotData(slot), blockSize_, failed);
+    std::fill(mask, mask + maskWords_, 0ULL);
+    for (size_t page = 0; page < pagesPerBlock_; ++page) {
+        if (!failed.contains(blockStart + page * kCachePageSize)) {
+            mask[page / 64] |= 1ULL << (page % 64);
+        }
+    }
+}
+
+bool MemoryCache::rangeValid(uint32_t slot, size_t offset, size_t length) const {
+    const uint64_t* mask = validPages_.data() + static_cast<size_t>(slot) * maskWords_;
+    for (size_t page = offset / kCachePageSize; page <= (offset + length - 1) / kCachePageSize; ++page) {
+        if (!(mask[page / 64] & (1ULL << (page % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t MemoryCache::allocateSlot(Shard& shard) {
+    if (!shard.freeSlots.empty()) {
+        uint32_t slot = shard.freeSlots.back();
+        shard.freeSlots.pop_back();
+        return slot;
+    }
+
+    // 淘汰最久未使用的块；全部在加载中时不缓存
+    uint32_t victim = shard.tail;
+    if (victim == NIL) {
+        return NIL;
+    }
+    unlink(shard, victim);
+    shard.index.erase(slots_[victim].blockStart);
+    slots_[victim].state = SlotState::Free;
+    if (slots_[victim].prefetched) {
+        slots_[victim].prefetched = false;
+        shard.prefetchWasted++;
+    }
+    return victim;
+}
+
+void MemoryCache::unlink(Shard& shard, uint32_t slot) {
+    Slot& node = slots_[slot];
+    if (node.prev != NIL) {
+        slots_[node.prev].next = node.next;
+    } else {
+        shard.head = node.next;
+    }
+    if (node.next != NIL) {
+        slots_[node.next].prev = node.prev;
+    } else {
+        shard.tail = node.prev;
+    }
+    node.prev = NIL;
+    node.next = NIL;
+}
+
+void MemoryCache::pushFront(Shard& shard, uint32_t slot) {
+    Slot& node = slots_[slot];
+    node.prev = NIL;
+    node.next = shard.head;
+    if (shard.head != NIL) {
+        slots_[shard.head].prev = slot;
+    }
+    shard.head = slot;
+    if (shard.tail == NIL) {
+        shard.tail = slot;
     }
-    
-    // 无法读取整个块，尝试直接读取所需数据
-    return memAccess->read(address, buffer, size, ec);
 }
 
 bool MemoryCache::preloadRegion(const std::shared_ptr<MemoryAccess>& memAccess,
@@ -106,89 +449,95 @@ bool MemoryCache::preloadRegion(const std::shared_ptr<MemoryAccess>& memAccess,
     if (startAddress >= endAddress) {
         return false;
     }
-    
+
     // 计算要加载的块数量
     Address firstBlock = getBlockStartAddress(startAddress);
     Address lastBlock = getBlockStartAddress(endAddress - 1);
-    
+
     bool allSuccess = true;
-    
-    // 逐块加载
+
+    // 逐块加载，已缓存的块跳过
     for (Address blockStart = firstBlock; blockStart <= lastBlock; blockStart += blockSize_) {
-        // 检查是否已缓存
-        {
-            std::lock_guard<std::mutex> lock(cacheMutex_);
-            
-            if (cacheBlocks_.find(blockStart) != cacheBlocks_.end()) {
-                continue; // 已缓存，跳过
-            }
-        }
-        
-        // 创建新缓存块
-        CacheBlock newBlock;
-        newBlock.startAddress = blockStart;
-        newBlock.endAddress = blockStart + blockSize_;
-        newBlock.data.resize(blockSize_);
-        newBlock.lastAccess = std::chrono::steady_clock::now().time_since_epoch().count();
-        
-        // 读取整个块
-        std::error_code ec;
-        newBlock.isValid = memAccess->read(blockStart, newBlock.data.data(), blockSize_, ec);
-        
-        if (newBlock.isValid) {
-            // 添加到缓存
-            std::lock_guard<std::mutex> lock(cacheMutex_);
-            
-            // 检查缓存是否已满
-            if (cacheBlocks_.size() >= maxCacheBlocks_) {
-                evictOldestBlock();
-            }
-            
-            cacheBlocks_[blockStart] = std::move(newBlock);
-        } else {
+        if (!loadBlock(*memAccess, blockStart)) {
             allSuccess = false;
         }
     }
-    
+
     return allSuccess;
 }
 
 void MemoryCache::clear() {
-    std::lock_guard<std::mutex> lock(cacheMutex_);
-    cacheBlocks_.clear();
-    cacheHits_ = 0;
-    cacheMisses_ = 0;
+    for (size_t i = 0; i < shardCount_; ++i) {
+        Shard& shard = shards_[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        // 加载中的槽位由加载线程放回链表，这里只回收已在链表上的
+        while (shard.head != NIL) {
+            uint32_t slot = shard.head;
+            unlink(shard, slot);
+            shard.index.erase(slots_[slot].blockStart);
+            slots_[slot].state = SlotState::Free;
+            slots_[slot].prefetched = false;
+            shard.freeSlots.push_back(slot);
+        }
+        shard.hits = 0;
+        shard.misses = 0;
+        shard.prefetchIssued = 0;
+        shard.prefetchUseful = 0;
+        shard.prefetchWasted = 0;
+    }
+}
+
+size_t MemoryCache::sumShards(size_t Shard::*counter) const {
+    size_t total = 0;
+    for (size_t i = 0; i < shardCount_; ++i) {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        total += shards_[i].*counter;
+    }
+    return total;
+}
+
+size_t MemoryCache::getCacheHits() const {
+    return sumShards(&Shard::hits);
+}
+
+size_t MemoryCache::getCacheMisses() const {
+    return sumShards(&Shard::misses);
 }
 
 double MemoryCache::getHitRatio() const {
-    std::lock_guard<std::mutex> lock(cacheMutex_);
-    
-    size_t total = cacheHits_ + cacheMisses_;
+    size_t hits = getCacheHits();
+    size_t total = hits + getCacheMisses();
     if (total == 0) {
         return 0.0;
     }
-    
-    return static_cast<double>(cacheHits_) / total;
+
+    return static_cast<double>(hits) / total;
 }
 
-void MemoryCache::evictOldestBlock() {
-    if (cacheBlocks_.empty()) {
-        return;
-    }
-    
-    // 查找最旧的块
-    auto oldest = cacheBlocks_.begin();
-    for (auto it = std::next(oldest); it != cacheBlocks_.end(); ++it) {
-        if (it->second.lastAccess < oldest->second.lastAccess) {
-            oldest = it;
-        }
+size_t MemoryCache::getPrefetchIssued() const {
+    return sumShards(&Shard::prefetchIssued);
+}
+
+size_t MemoryCache::getPrefetchUseful() const {
+    return sumShards(&Shard::prefetchUseful);
+}
+
+size_t MemoryCache::getPrefetchWasted() const {
+    return sumShards(&Shard::prefetchWasted);
+}
+
+double MemoryCache::getPrefetchAccuracy() const {
+    size_t issued = getPrefetchIssued();
+    if (issued == 0) {
+        return 0.0;
     }
-    
-    cacheBlocks_.erase(oldest);
+
+    return static_cast<double>(getPrefetchUseful()) / issued;
 }
 
 Address MemoryCache::getBlockStartAddress(Address address) const {
-    return (address / blockSize_) * blockSize_;
+    return address & ~static_cast<Address>(blockSize_ - 1);
 }
 
 } // namespace memchainer
@@ -0,0 +1,261 @@
+#include "memory/page_store.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+namespace memchainer {
+
+namespace {
+
+constexpr uint64_t kHashPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kHashPrime2 = 0xC2B2AE3D27D4EB4FULL;
+
+inline uint64_t rotl(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+bool pwriteAll(int fd, const void* buffer, size_t size, uint64_t offset) {
+    const char* p = static_cast<const char*>(buffer);
+    while (size > 0) {
+        ssize_t n = pwrite(fd, p, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+PageStore::PageStore() = default;
+
+PageStore::~PageStore() {
+    close();
+}
+
+bool PageStore::open(const std::string& dir, bool writable) {
+    close();
+    dir_ = dir;
+    writable_ = writable;
+
+    std::string pagesPath = dir_ + "/pages.bin";
+    std::string indexPath = dir_ + "/pages.idx";
+
+    if (writable_) {
+        std::error_code ec;
+        fs::create_directories(dir_, ec);
+        if (ec) {
+            std::cerr << "创建页存储目录失败: " << dir_ << " (" << ec.message() << ")" << std::endl;
+            return false;
+        }
+    }
+
+    // 加载哈希索引
+    std::ifstream indexFile(indexPath, std::ios::binary | std::ios::in);
+    if (indexFile) {
+        indexFile.seekg(0, std::ios::end);
+        size_t count = static_cast<size_t>(indexFile.tellg()) / sizeof(uint64_t);
+        indexFile.seekg(0);
+        hashes_.resize(count);
+        indexFile.read(reinterpret_cast<char*>(hashes_.data()), count * sizeof(uint64_t));
+    }
+
+    pagesFd_ = ::open(pagesPath.c_str(), writable_ ? (O_RDWR | O_CREAT | O_CLOEXEC) : (O_RDONLY | O_CLOEXEC), 0644);
+    if (pagesFd_ < 0) {
+        std::cerr << "无法打开页存储: " << pagesPath << std::endl;
+        hashes_.clear();
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(pagesFd_, &st) != 0) {
+        close();
+        return false;
+    }
+
+    // 写入中断时页文件和索引可能长度不一致，以较短者为准
+    size_t pageCount = std::min(hashes_.size(), static_cast<size_t>(st.st_size) / STORE_PAGE_SIZE);
+    if (pageCount != hashes_.size() || pageCount * STORE_PAGE_SIZE != static_cast<size_t>(st.st_size)) {
+        std::cerr << "页存储不完整，截断到 " << pageCount << " 页: " << dir_ << std::endl;
+        hashes_.resize(pageCount);
+        if (writable_) {
+            if (ftruncate(pagesFd_, static_cast<off_t>(pageCount * STORE_PAGE_SIZE)) != 0 ||
+                truncate(indexPath.c_str(), static_cast<off_t>(pageCount * sizeof(uint64_t))) != 0) {
+                std::cerr << "截断页存储失败: " << strerror(errno) << std::endl;
+            }
+        }
+    }
+    flushedPages_ = pageCount;
+    persistedPages_ = pageCount;
+
+    if (writable_) {
+        index_.reserve(hashes_.size());
+        for (size_t i = 0; i < hashes_.size(); ++i) {
+            index_.emplace(hashes_[i], static_cast<uint32_t>(i + 1));
+        }
+        pending_.reserve(WRITE_BUFFER_PAGES * STORE_PAGE_SIZE);
+        return true;
+    }
+
+    if (pageCount == 0) {
+        return true;
+    }
+    void* addr = mmap(nullptr, pageCount * STORE_PAGE_SIZE, PROT_READ, MAP_SHARED, pagesFd_, 0);
+    if (addr == MAP_FAILED) {
+        std::cerr << "映射页存储失败: " << pagesPath << std::endl;
+        close();
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(addr);
+    mappedSize_ = pageCount * STORE_PAGE_SIZE;
+    return true;
+}
+
+void PageStore::close() {
+    if (writable_ && pagesFd_ >= 0) {
+        flush();
+    }
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), mappedSize_);
+    }
+    if (pagesFd_ >= 0) {
+        ::close(pagesFd_);
+    }
+    data_ = nullptr;
+    mappedSize_ = 0;
+    pagesFd_ = -1;
+    hashes_.clear();
+    index_.clear();
+    pending_.clear();
+    flushedPages_ = 0;
+    persistedPages_ = 0;
+}
+
+uint32_t PageStore::put(const uint8_t* page) {
+    if (isZeroPage(page)) {
+        return ZERO_PAGE;
+    }
+    if (!writable_ || pagesFd_ < 0) {
+        return MISSING_PAGE;
+    }
+
+    uint64_t hash = hashPage(page);
+    auto range = index_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (samePage(it->second, page)) {
+            return it->second;
+        }
+    }
+
+    // 新页：追加到写入缓冲，攒够后一次写出
+    if (hashes_.size() + 1 >= MISSING_PAGE) {
+        return MISSING_PAGE;
+    }
+    pending_.insert(pending_.end(), page, page + STORE_PAGE_SIZE);
+    hashes_.push_back(hash);
+    uint32_t id = static_cast<uint32_t>(hashes_.size());
+    index_.emplace(hash, id);
+
+    if (pending_.size() >= WRITE_BUFFER_PAGES * STORE_PAGE_SIZE && !flush()) {
+        return MISSING_PAGE;
+    }
+    return id;
+}
+
+bool PageStore::flush() {
+    if (!writable_ || pagesFd_ < 0 || pending_.empty()) {
+        return true;
+    }
+
+    // 先写页再写索引，索引不会引用未写入的页
+    size_t count = pending_.size() / STORE_PAGE_SIZE;
+    if (!pwriteAll(pagesFd_, pending_.data(), pending_.size(), flushedPages_ * STORE_PAGE_SIZE)) {
+        std::cerr << "写入页存储失败: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    std::ofstream indexFile(dir_ + "/pages.idx", std::ios::binary | std::ios::out | std::ios::app);
+    indexFile.write(reinterpret_cast<const char*>(hashes_.data() + flushedPages_), count * sizeof(uint64_t));
+    if (!indexFile) {
+        std::cerr << "写入页存储索引失败: " << dir_ << std::endl;
+        return false;
+    }
+
+    flushedPages_ += count;
+    pending_.clear();
+    return true;
+}
+
+const uint8_t* PageStore::get(uint32_t id) const {
+    if (id == ZERO_PAGE || !data_ || static_cast<size_t>(id) * STORE_PAGE_SIZE > mappedSize_) {
+        return nullptr;
+    }
+    return data_ + static_cast<size_t>(id - 1) * STORE_PAGE_SIZE;
+}
+
+bool PageStore::samePage(uint32_t id, const uint8_t* page) const {
+    size_t index = id - 1;
+    if (index >= flushedPages_) {
+        return memcmp(pending_.data() + (index - flushedPages_) * STORE_PAGE_SIZE, page, STORE_PAGE_SIZE) == 0;
+    }
+
+    uint8_t stored[STORE_PAGE_SIZE];
+    if (pread(pagesFd_, stored, STORE_PAGE_SIZE, static_cast<off_t>(index * STORE_PAGE_SIZE)) !=
+        static_cast<ssize_t>(STORE_PAGE_SIZE)) {
+        return false;
+    }
+    return memcmp(stored, page, STORE_PAGE_SIZE) == 0;
+}
+
+bool PageStore::isZeroPage(const uint8_t* page) {
+    // 每 512 字节用8个独立的累加器做或运算，编译器可向量化（arm64 上为 NEON）；
+    // 非零页通常在开头就能判定，按块提前退出
+    constexpr size_t kBlock = 512;
+    for (size_t block = 0; block < STORE_PAGE_SIZE; block += kBlock) {
+        uint64_t acc[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        for (size_t i = 0; i < kBlock; i += sizeof(acc)) {
+            uint64_t words[8];
+            memcpy(words, page + block + i, sizeof(words));
+            for (int lane = 0; lane < 8; ++lane) {
+                acc[lane] |= words[lane];
+            }
+        }
+        if ((acc[0] | acc[1] | acc[2] | acc[3] | acc[4] | acc[5] | acc[6] | acc[7]) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t PageStore::hashPage(const uint8_t* page) {
+    // 4路并行的乘法-旋转哈希，最后合并
+    uint64_t lanes[4] = {kHashPrime1, kHashPrime2, kHashPrime1 ^ kHashPrime2, 0};
+    for (size_t i = 0; i < STORE_PAGE_SIZE; i += sizeof(lanes)) {
+        uint64_t words[4];
+        memcpy(words, page + i, sizeof(words));
+        for (int lane = 0; lane < 4; ++lane) {
+            lanes[lane] = rotl(lanes[lane] + words[lane] * kHashPrime2, 31) * kHashPrime1;
+        }
+    }
+
+    uint64_t hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+    hash ^= hash >> 33;
+    hash *= kHashPrime2;
+    hash ^= hash >> 29;
+    return hash;
+}
+
+} // namespace memchainer
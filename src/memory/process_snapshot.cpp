@@ -0,0 +1,421 @@
+#include "memory/process_snapshot.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+
+namespace memchainer {
+
+namespace {
+
+constexpr char kSnapshotMagic[4] = {'M', 'C', 'S', 'S'};
+constexpr uint16_t kSnapshotVersion = 2;
+constexpr uint64_t kSnapshotPageSize = PageStore::STORE_PAGE_SIZE;
+
+uint64_t pageCount(const SnapshotRegion& region) {
+    return (region.endAddress - region.startAddress + kSnapshotPageSize - 1) / kSnapshotPageSize;
+}
+
+// 相对路径的页存储目录相对于快照文件所在目录
+std::string resolveStoreDir(const std::string& snapshotFile, const std::string& storeDir) {
+    if (!storeDir.empty() && storeDir[0] == '/') {
+        return storeDir;
+    }
+    size_t slash = snapshotFile.find_last_of('/');
+    return slash == std::string::npos ? storeDir : snapshotFile.substr(0, slash + 1) + storeDir;
+}
+
+bool writeAll(int fd, const void* buffer, size_t size) {
+    const char* p = static_cast<const char*>(buffer);
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+// ============================================================================
+// ProcessSnapshot
+// ============================================================================
+
+ProcessSnapshot::ProcessSnapshot() = default;
+
+ProcessSnapshot::~ProcessSnapshot() {
+    close();
+}
+
+bool ProcessSnapshot::capture(const std::string& filename, const MemoryAccess& memAccess,
+                              MemoryMap& memMap, SnapshotStats* stats, const std::string& storeDir) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    std::string storeName = storeDir.empty() ? DEFAULT_STORE_DIR : storeDir;
+    if (storeName.size() >= sizeof(SnapshotHeader::storeDir)) {
+        std::cerr << "页存储路径过长: " << storeName << std::endl;
+        return false;
+    }
+
+    PageStore store;
+    if (!store.open(resolveStoreDir(filename, storeName), true)) {
+        return false;
+    }
+
+    std::vector<MemoryRegion*> filtered = memMap.getFilteredRegions();
+    std::unordered_set<const MemoryRegion*> capturedSet(filtered.begin(), filtered.end());
+
+    // 区域表和文件布局：页编号表紧跟区域表，按区域顺序排列
+    std::vector<SnapshotRegion> regions;
+    for (const auto& entry : memMap.getRegions()) {
+        const MemoryRegion* region = &entry;
+        SnapshotRegion record{};
+        record.startAddress = region->startAddress;
+        record.endAddress = region->endAddress;
+        record.type = region->type;
+        record.count = region->count;
+        record.flags = (capturedSet.count(region) && region->endAddress > region->startAddress ? REGION_CAPTURED : 0) |
+                       (memMap.isStaticRegion(region->id) ? REGION_STATIC : 0);
+        record.baseOffset = region->staticBase ? static_cast<uint32_t>(region->startAddress - region->staticBase) : 0;
+        memcpy(record.name, region->name, sizeof(record.name));
+        regions.push_back(record);
+    }
+
+    SnapshotHeader header{};
+    memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+    header.version = kSnapshotVersion;
+    header.pid = memAccess.getTargetProcessId();
+    header.regionCount = static_cast<uint32_t>(regions.size());
+    header.timestamp = static_cast<uint64_t>(std::time(nullptr));
+    header.mapsFingerprint = memMap.getFingerprint();
+    header.regionOffset = sizeof(SnapshotHeader);
+    strncpy(header.storeDir, storeName.c_str(), sizeof(header.storeDir) - 1);
+
+    uint64_t cursor = header.regionOffset + regions.size() * sizeof(SnapshotRegion);
+    uint64_t pageMapStart = cursor;
+    for (auto& record : regions) {
+        if (record.flags & REGION_CAPTURED) {
+            record.pageMapOffset = cursor;
+            cursor += pageCount(record) * sizeof(uint32_t);
+        }
+    }
+    std::vector<uint32_t> pageMaps((cursor - pageMapStart) / sizeof(uint32_t), PageStore::MISSING_PAGE);
+
+    // 区域数据按大块读取，逐页去重后写入页存储
+    SnapshotStats result;
+    std::vector<uint8_t> buffer(CAPTURE_CHUNK_SIZE);
+    size_t previousPages = store.getPageCount();
+
+    for (const auto& record : regions) {
+        if (!(record.flags & REGION_CAPTURED)) {
+            continue;
+        }
+
+        uint32_t* pageMap = pageMaps.data() + (record.pageMapOffset - pageMapStart) / sizeof(uint32_t);
+        uint64_t regionSize = pageCount(record) * kSnapshotPageSize;
+        FailedRangeSet failed;
+        for (uint64_t offset = 0; offset < regionSize; offset += CAPTURE_CHUNK_SIZE) {
+            size_t chunk = static_cast<size_t>(std::min<uint64_t>(CAPTURE_CHUNK_SIZE, regionSize - offset));
+            Address address = record.startAddress + offset;
+            // 整块读取失败时二分定位不可读的页，这些页标记为 MISSING_PAGE
+            bool chunkOk = memAccess.readAdaptive(address, buffer.data(), chunk, failed) == chunk;
+
+            for (size_t pos = 0; pos < chunk; pos += kSnapshotPageSize) {
+                size_t index = static_cast<size_t>((offset + pos) / kSnapshotPageSize);
+                if (!chunkOk && failed.contains(address + pos)) {
+                    result.failedPages++;
+                    continue;
+                }
+
+                uint32_t id = store.put(buffer.data() + pos);
+                pageMap[index] = id;
+                if (id == PageStore::ZERO_PAGE) {
+                    result.zeroPages++;
+                } else if (id == PageStore::MISSING_PAGE) {
+                    result.failedPages++;
+                }
+            }
+            result.bytes += chunk;
+        }
+        result.regions++;
+    }
+
+    bool success = store.flush();
+    result.newPages = store.getPageCount() - previousPages;
+    size_t totalPages = static_cast<size_t>(result.bytes / kSnapshotPageSize);
+    result.duplicatePages = totalPages - result.failedPages - result.zeroPages - result.newPages;
+
+    header.totalPages = totalPages;
+    header.zeroPages = result.zeroPages;
+    header.newPages = result.newPages;
+
+    int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "无法创建快照文件: " << filename << std::endl;
+        return false;
+    }
+    success = success &&
+              writeAll(fd, &header, sizeof(header)) &&
+              writeAll(fd, regions.data(), regions.size() * sizeof(SnapshotRegion)) &&
+              writeAll(fd, pageMaps.data(), pageMaps.size() * sizeof(uint32_t));
+    if (::close(fd) != 0) {
+        success = false;
+    }
+
+    if (!success) {
+        std::cerr << "写入快照文件失败: " << filename << " (" << strerror(errno) << ")" << std::endl;
+        unlink(filename.c_str());
+        return false;
+    }
+
+    result.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::high_resolution_clock::now() - startTime).count();
+    std::cout << "快照采集完成: " << result.regions << " 个区域，" << (result.bytes / 1024 / 1024)
+              << " MB，耗时 " << result.elapsedMs << " ms" << std::endl;
+    std::cout << "全零页 " << result.zeroPages << "，重复页 " << result.duplicatePages
+              << "，新增页 " << result.newPages << "（" << (result.newPages * kSnapshotPageSize / 1024 / 1024)
+              << " MB），读取失败 " << result.failedPages << " 页" << std::endl;
+    if (stats) {
+        *stats = result;
+    }
+    return true;
+}
+
+bool ProcessSnapshot::open(const std::string& filename) {
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "无法打开快照文件: " << filename << std::endl;
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+        ::close(fd);
+        std::cerr << "快照文件不完整: " << filename << std::endl;
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        std::cerr << "映射快照文件失败: " << filename << std::endl;
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(addr);
+    mappedSize_ = size;
+
+    memcpy(&header_, data_, sizeof(header_));
+    if (memcmp(header_.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 || header_.version != kSnapshotVersion) {
+        std::cerr << "不是快照文件或版本不支持: " << filename << std::endl;
+        close();
+        return false;
+    }
+    header_.storeDir[sizeof(header_.storeDir) - 1] = '\0';
+
+    uint64_t tableEnd = header_.regionOffset + uint64_t(header_.regionCount) * sizeof(SnapshotRegion);
+    if (tableEnd > size) {
+        std::cerr << "快照文件不完整: " << filename << std::endl;
+        close();
+        return false;
+    }
+
+    regions_.resize(header_.regionCount);
+    memcpy(regions_.data(), data_ + header_.regionOffset, regions_.size() * sizeof(SnapshotRegion));
+
+    for (uint32_t i = 0; i < regions_.size(); ++i) {
+        const SnapshotRegion& region = regions_[i];
+        if (!(region.flags & REGION_CAPTURED)) {
+            continue;
+        }
+        if (region.pageMapOffset % sizeof(uint32_t) != 0 ||
+            region.pageMapOffset + pageCount(region) * sizeof(uint32_t) > size) {
+            std::cerr << "快照文件区域越界: " << region.name << std::endl;
+            close();
+            return false;
+        }
+        captured_.push_back(i);
+    }
+    std::sort(captured_.begin(), captured_.end(), [this](uint32_t a, uint32_t b) {
+        return regions_[a].startAddress < regions_[b].startAddress;
+    });
+
+    if (!store_.open(resolveStoreDir(filename, header_.storeDir), false)) {
+        close();
+        return false;
+    }
+
+    // 快照引用的页必须都在页存储中
+    uint64_t storedPages = store_.getPageCount();
+    for (uint32_t index : captured_) {
+        const uint32_t* pageMap = getPageMap(regions_[index]);
+        for (uint64_t page = 0; page < pageCount(regions_[index]); ++page) {
+            if (pageMap[page] != PageStore::MISSING_PAGE && pageMap[page] > storedPages) {
+                std::cerr << "页存储缺少快照引用的页: " << header_.storeDir << std::endl;
+                close();
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void ProcessSnapshot::close() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), mappedSize_);
+    }
+    data_ = nullptr;
+    mappedSize_ = 0;
+    regions_.clear();
+    captured_.clear();
+    header_ = SnapshotHeader{};
+    store_.close();
+}
+
+bool ProcessSnapshot::restoreMemoryMap(MemoryMap& memMap) const {
+    if (!data_) {
+        return false;
+    }
+
+    memMap.clear();
+    for (const auto& record : regions_) {
+        MemoryRegion region(record.startAddress, record.endAddress, record.type, "", record.count);
+        memcpy(region.name, record.name, sizeof(region.name));
+        region.name[sizeof(region.name) - 1] = '\0';
+        if (record.baseOffset) {
+            region.staticBase = record.startAddress - record.baseOffset;
+        }
+        memMap.addRegion(region, (record.flags & REGION_STATIC) != 0);
+    }
+
+    if (memMap.getFingerprint() != header_.mapsFingerprint) {
+        std::cerr << "恢复的内存映射与快照记录的指纹不一致" << std::endl;
+    }
+    return true;
+}
+
+long ProcessSnapshot::findRegion(Address address) const {
+    auto it = std::upper_bound(captured_.begin(), captured_.end(), address,
+                               [this](Address value, uint32_t index) {
+                                   return value < regions_[index].startAddress;
+                               });
+    if (it == captured_.begin()) {
+        return -1;
+    }
+    --it;
+    return address < regions_[*it].endAddress ? static_cast<long>(*it) : -1;
+}
+
+const uint32_t* ProcessSnapshot::getPageMap(const SnapshotRegion& region) const {
+    if (!data_ || !(region.flags & REGION_CAPTURED)) {
+        return nullptr;
+    }
+    return reinterpret_cast<const uint32_t*>(data_ + region.pageMapOffset);
+}
+
+uint32_t ProcessSnapshot::getPageId(Address address) const {
+    long index = findRegion(address);
+    if (index < 0) {
+        return PageStore::MISSING_PAGE;
+    }
+    const SnapshotRegion& region = regions_[index];
+    return getPageMap(region)[(address - region.startAddress) / kSnapshotPageSize];
+}
+
+bool ProcessSnapshot::read(Address address, void* buffer, size_t size) const {
+    long index = findRegion(address);
+    if (index < 0 || size == 0) {
+        return false;
+    }
+
+    const SnapshotRegion& region = regions_[index];
+    if (address + size > region.endAddress) {
+        return false;
+    }
+
+    // 逐页复制，全零页直接填0
+    const uint32_t* pageMap = getPageMap(region);
+    uint8_t* out = static_cast<uint8_t*>(buffer);
+    Address offset = address - region.startAddress;
+    while (size > 0) {
+        size_t page = static_cast<size_t>(offset / kSnapshotPageSize);
+        size_t inPage = static_cast<size_t>(offset % kSnapshotPageSize);
+        size_t length = std::min<size_t>(size, kSnapshotPageSize - inPage);
+
+        uint32_t id = pageMap[page];
+        if (id == PageStore::MISSING_PAGE) {
+            return false;
+        }
+        if (id == PageStore::ZERO_PAGE) {
+            memset(out, 0, length);
+        } else {
+            memcpy(out, store_.get(id) + inPage, length);
+        }
+
+        out += length;
+        offset += length;
+        size -= length;
+    }
+    return true;
+}
+
+bool ProcessSnapshot::isPageCaptured(Address address) const {
+    return getPageId(address) != PageStore::MISSING_PAGE;
+}
+
+bool ProcessSnapshot::isZeroPage(Address address) const {
+    return getPageId(address) == PageStore::ZERO_PAGE;
+}
+
+// ============================================================================
+// SnapshotMemoryAccess
+// ============================================================================
+
+SnapshotMemoryAccess::SnapshotMemoryAccess() = default;
+
+SnapshotMemoryAccess::~SnapshotMemoryAccess() = default;
+
+bool SnapshotMemoryAccess::open(const std::string& filename) {
+    if (!snapshot_.open(filename)) {
+        return false;
+    }
+
+    targetPid_ = snapshot_.getHeader().pid;
+    pageFailCount_ = 0;
+    readFailCount_ = 0;
+    return true;
+}
+
+bool SnapshotMemoryAccess::readMemory(Address address, void* buffer, MemorySize size, std::error_code& ec) const {
+    if (!snapshot_.read(address, buffer, static_cast<size_t>(size))) {
+        ec = make_error_code(MemError::ReadError);
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotMemoryAccess::isPageMapped(Address address) const {
+    return snapshot_.isPageCaptured(address);
+}
+
+bool SnapshotMemoryAccess::isKnownZeroPage(Address address) const {
+    return snapshot_.isZeroPage(address);
+}
+
+} // namespace memchainer
@@ -0,0 +1,422 @@
+#include "memory/snapshot_diff.h"
+#include "common/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <iostream>
+
+namespace fs = std::filesystem;
+namespace memchainer {
+
+namespace {
+
+constexpr size_t kDiffPageSize = PageStore::STORE_PAGE_SIZE;
+constexpr size_t kDiffBlockSize = 64;
+
+// 一个比较任务：旧快照区域与新数据中 [start, end) 的比较
+struct DiffTask {
+    const SnapshotRegion* before;
+    const SnapshotRegion* after; // 与实时进程比较时为空
+    Address start;
+    Address end;
+};
+
+struct TaskResult {
+    std::vector<ChangedRange> ranges;
+    std::vector<ValueDelta> deltas;
+    DiffStats stats;
+};
+
+const uint8_t* zeroPage() {
+    static const uint8_t page[kDiffPageSize] = {};
+    return page;
+}
+
+// 从 offset 开始查找第一个内容不同的64字节块，返回块偏移，没有则返回 size。
+// 每块8个字做异或后归约，编译器可向量化（arm64 上为 NEON）
+size_t findChangedBlock(const uint8_t* oldPage, const uint8_t* newPage, size_t offset, size_t size) {
+    for (; offset + kDiffBlockSize <= size; offset += kDiffBlockSize) {
+        uint64_t a[8];
+        uint64_t b[8];
+        memcpy(a, oldPage + offset, sizeof(a));
+        memcpy(b, newPage + offset, sizeof(b));
+        uint64_t acc = 0;
+        for (int lane = 0; lane < 8; ++lane) {
+            acc |= a[lane] ^ b[lane];
+        }
+        if (acc != 0) {
+            return offset;
+        }
+    }
+    // 区域末尾不足一块的部分
+    if (offset < size && memcmp(oldPage + offset, newPage + offset, size - offset) != 0) {
+        return offset;
+    }
+    return size;
+}
+
+// 比较一页（size 为页内有效长度），变化按数值宽度记录到 result
+void comparePage(Address address, const uint8_t* oldPage, const uint8_t* newPage, size_t size,
+                 size_t valueSize, size_t maxDeltas, TaskResult& result) {
+    result.stats.pagesCompared++;
+    bool changed = false;
+
+    size_t block = findChangedBlock(oldPage, newPage, 0, size);
+    while (block < size) {
+        size_t blockEnd = std::min(block + kDiffBlockSize, size);
+        for (size_t offset = block; offset + valueSize <= blockEnd; offset += valueSize) {
+            if (memcmp(oldPage + offset, newPage + offset, valueSize) == 0) {
+                continue;
+            }
+            changed = true;
+            Address valueAddress = address + offset;
+
+            // 与上一个变化相邻时扩展范围
+            if (!result.ranges.empty() && result.ranges.back().end == valueAddress) {
+                result.ranges.back().end += valueSize;
+            } else {
+                result.ranges.push_back(ChangedRange{valueAddress, valueAddress + valueSize});
+            }
+            result.stats.bytesChanged += valueSize;
+            result.stats.deltaCount++;
+
+            if (result.deltas.size() < maxDeltas) {
+                ValueDelta delta{valueAddress, 0, 0};
+                memcpy(&delta.oldBits, oldPage + offset, valueSize);
+                memcpy(&delta.newBits, newPage + offset, valueSize);
+                result.deltas.push_back(delta);
+            }
+        }
+        block = findChangedBlock(oldPage, newPage, blockEnd, size);
+    }
+
+    if (changed) {
+        result.stats.pagesChanged++;
+    }
+}
+
+// 取旧快照中一页的内容，失败页返回空
+const uint8_t* snapshotPage(const ProcessSnapshot& snapshot, uint32_t id) {
+    if (id == PageStore::MISSING_PAGE) {
+        return nullptr;
+    }
+    return id == PageStore::ZERO_PAGE ? zeroPage() : snapshot.getPage(id);
+}
+
+// 两个快照是否使用同一个页存储（此时页编号相同即内容相同）
+bool sameStore(const ProcessSnapshot& a, const ProcessSnapshot& b) {
+    std::error_code ec;
+    bool same = fs::equivalent(a.getPageStore().getDir(), b.getPageStore().getDir(), ec);
+    return !ec && same;
+}
+
+void diffSnapshotTask(const DiffTask& task, const ProcessSnapshot& before, const ProcessSnapshot& after,
+                      bool shared, size_t valueSize, size_t maxDeltas, TaskResult& result) {
+    const uint32_t* oldMap = before.getPageMap(*task.before);
+    const uint32_t* newMap = after.getPageMap(*task.after);
+    const PageStore& oldStore = before.getPageStore();
+    const PageStore& newStore = after.getPageStore();
+
+    for (Address addr = task.start; addr < task.end; addr += kDiffPageSize) {
+        uint32_t oldId = oldMap[(addr - task.before->startAddress) / kDiffPageSize];
+        uint32_t newId = newMap[(addr - task.after->startAddress) / kDiffPageSize];
+
+        const uint8_t* oldPage = snapshotPage(before, oldId);
+        const uint8_t* newPage = snapshotPage(after, newId);
+        if (!oldPage || !newPage) {
+            result.stats.pagesMissing++;
+            continue;
+        }
+
+        // 全零页编号在任何存储中都相同；同一存储中编号相同即内容相同
+        if (oldId == newId && (shared || oldId == PageStore::ZERO_PAGE)) {
+            result.stats.pagesSkipped++;
+            continue;
+        }
+
+        // 不同存储：哈希相同再确认内容
+        size_t size = std::min<size_t>(kDiffPageSize, task.end - addr);
+        if (!shared && oldId != PageStore::ZERO_PAGE && newId != PageStore::ZERO_PAGE &&
+            oldStore.getHash(oldId) == newStore.getHash(newId) &&
+            memcmp(oldPage, newPage, size) == 0) {
+            result.stats.pagesSkipped++;
+            continue;
+        }
+
+        comparePage(addr, oldPage, newPage, size, valueSize, maxDeltas, result);
+    }
+}
+
+void diffLiveTask(const DiffTask& task, const ProcessSnapshot& before, const MemoryAccess& live,
+                  size_t valueSize, size_t maxDeltas, TaskResult& result) {
+    const uint32_t* oldMap = before.getPageMap(*task.before);
+    std::vector<uint8_t> buffer(SnapshotDiff::LIVE_READ_PAGES * kDiffPageSize);
+    FailedRangeSet failed;
+
+    for (Address chunk = task.start; chunk < task.end; chunk += buffer.size()) {
+        size_t chunkSize = std::min<size_t>(buffer.size(), task.end - chunk);
+
+        // 整块读取失败时二分定位不可读的页，只把这些页记为缺失
+        bool chunkOk = live.readAdaptive(chunk, buffer.data(), chunkSize, failed) == chunkSize;
+
+        for (size_t offset = 0; offset < chunkSize; offset += kDiffPageSize) {
+            Address addr = chunk + offset;
+            size_t size = std::min(kDiffPageSize, chunkSize - offset);
+            uint32_t oldId = oldMap[(addr - task.before->startAddress) / kDiffPageSize];
+            const uint8_t* oldPage = snapshotPage(before, oldId);
+
+            if (!oldPage || (!chunkOk && failed.contains(addr))) {
+                result.stats.pagesMissing++;
+                continue;
+            }
+            comparePage(addr, oldPage, buffer.data() + offset, size, valueSize, maxDeltas, result);
+        }
+    }
+}
+
+// 把区域切成不超过 DIFF_TASK_SIZE 的任务，避免单个大区域拖慢并行
+void addTasks(std::vector<DiffTask>& tasks, const SnapshotRegion* before, const SnapshotRegion* after,
+              Address start, Address end) {
+    for (Address addr = start; addr < end; addr += SnapshotDiff::DIFF_TASK_SIZE) {
+        Address taskEnd = std::min<Address>(end, addr + SnapshotDiff::DIFF_TASK_SIZE);
+        tasks.push_back(DiffTask{before, after, addr, taskEnd});
+    }
+}
+
+std::vector<const SnapshotRegion*> capturedRegions(const ProcessSnapshot& snapshot) {
+    std::vector<const SnapshotRegion*> regions;
+    for (const auto& region : snapshot.getRegions()) {
+        if (region.flags & ProcessSnapshot::REGION_CAPTURED) {
+            regions.push_back(&region);
+        }
+    }
+    std::sort(regions.begin(), regions.end(), [](const SnapshotRegion* a, const SnapshotRegion* b) {
+        return a->startAddress < b->startAddress;
+    });
+    return regions;
+}
+
+// 并行执行所有任务并合并结果
+void runTasks(const std::vector<DiffTask>& tasks, const DiffOptions& options,
+              const std::function<void(const DiffTask&, TaskResult&)>& worker, DiffResult& result) {
+    std::vector<TaskResult> results(tasks.size());
+
+    if (!globalThreadPool) {
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            worker(tasks[i], results[i]);
+        }
+    } else {
+        std::vector<std::future<void>> futures;
+        futures.reserve(tasks.size());
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            futures.push_back(globalThreadPool->submit([&worker, &tasks, &results, i]() {
+                worker(tasks[i], results[i]);
+            }));
+        }
+        for (auto& future : futures) {
+            future.get();
+        }
+    }
+
+    // 任务互不重叠，按起始地址排序后顺序拼接即有序；相邻任务的边界范围需要合并
+    std::vector<size_t> order(tasks.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&tasks](size_t a, size_t b) {
+        return tasks[a].start < tasks[b].start;
+    });
+
+    DiffStats& stats = result.stats;
+    for (size_t index : order) {
+        TaskResult& part = results[index];
+        for (const auto& range : part.ranges) {
+            if (!result.ranges.empty() && result.ranges.back().end == range.start) {
+                result.ranges.back().end = range.end;
+            } else {
+                result.ranges.push_back(range);
+            }
+        }
+
+        size_t room = options.maxDeltas - std::min(options.maxDeltas, result.deltas.size());
+        size_t count = std::min(room, part.deltas.size());
+        result.deltas.insert(result.deltas.end(), part.deltas.begin(), part.deltas.begin() + count);
+
+        stats.pagesSkipped += part.stats.pagesSkipped;
+        stats.pagesCompared += part.stats.pagesCompared;
+        stats.pagesChanged += part.stats.pagesChanged;
+        stats.pagesMissing += part.stats.pagesMissing;
+        stats.bytesChanged += part.stats.bytesChanged;
+        stats.deltaCount += part.stats.deltaCount;
+    }
+}
+
+} // namespace
+
+bool SnapshotDiff::diff(const ProcessSnapshot& before, const ProcessSnapshot& after,
+                        const DiffOptions& options, DiffResult& result) {
+    auto startTime = std::chrono::steady_clock::now();
+    result = DiffResult{};
+
+    auto oldRegions = capturedRegions(before);
+    auto newRegions = capturedRegions(after);
+    if (oldRegions.empty() || newRegions.empty()) {
+        std::cerr << "快照中没有已采集的区域" << std::endl;
+        return false;
+    }
+
+    // 两个有序区域表做归并，比较地址重叠的部分（区域扩展或拆分时仍能比较公共部分）
+    std::vector<DiffTask> tasks;
+    std::vector<bool> oldMatched(oldRegions.size(), false);
+    std::vector<bool> newMatched(newRegions.size(), false);
+    size_t j = 0;
+    for (size_t i = 0; i < oldRegions.size(); ++i) {
+        const SnapshotRegion* oldRegion = oldRegions[i];
+        while (j < newRegions.size() && newRegions[j]->endAddress <= oldRegion->startAddress) {
+            ++j;
+        }
+        for (size_t k = j; k < newRegions.size() && newRegions[k]->startAddress < oldRegion->endAddress; ++k) {
+            Address start = std::max(oldRegion->startAddress, newRegions[k]->startAddress);
+            Address end = std::min(oldRegion->endAddress, newRegions[k]->endAddress);
+            addTasks(tasks, oldRegion, newRegions[k], start, end);
+            oldMatched[i] = true;
+            newMatched[k] = true;
+            result.stats.regions++;
+        }
+    }
+    result.stats.regionsRemoved = std::count(oldMatched.begin(), oldMatched.end(), false);
+    result.stats.regionsAdded = std::count(newMatched.begin(), newMatched.end(), false);
+
+    bool shared = sameStore(before, after);
+    size_t valueSize = SnapshotDiff::valueSize(options.valueType);
+    size_t maxDeltas = options.maxDeltas;
+    runTasks(tasks, options,
+             [&](const DiffTask& task, TaskResult& part) {
+                 diffSnapshotTask(task, before, after, shared, valueSize, maxDeltas, part);
+             },
+             result);
+
+    result.stats.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+    return true;
+}
+
+bool SnapshotDiff::diff(const ProcessSnapshot& before, const MemoryAccess& live,
+                        const DiffOptions& options, DiffResult& result) {
+    auto startTime = std::chrono::steady_clock::now();
+    result = DiffResult{};
+
+    auto oldRegions = capturedRegions(before);
+    if (oldRegions.empty()) {
+        std::cerr << "快照中没有已采集的区域" << std::endl;
+        return false;
+    }
+
+    std::vector<DiffTask> tasks;
+    for (const auto* region : oldRegions) {
+        addTasks(tasks, region, nullptr, region->startAddress, region->endAddress);
+    }
+    result.stats.regions = oldRegions.size();
+
+    size_t valueSize = SnapshotDiff::valueSize(options.valueType);
+    size_t maxDeltas = options.maxDeltas;
+    runTasks(tasks, options,
+             [&](const DiffTask& task, TaskResult& part) {
+                 diffLiveTask(task, before, live, valueSize, maxDeltas, part);
+             },
+             result);
+
+    result.stats.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+    return true;
+}
+
+size_t SnapshotDiff::valueSize(DiffValueType type) {
+    switch (type) {
+        case DiffValueType::Int8:
+            return 1;
+        case DiffValueType::Int16:
+            return 2;
+        case DiffValueType::Int32:
+        case DiffValueType::Float:
+            return 4;
+        case DiffValueType::Int64:
+        case DiffValueType::Double:
+            return 8;
+    }
+    return 4;
+}
+
+bool SnapshotDiff::parseType(const std::string& name, DiffValueType& type) {
+    if (name == "i8") {
+        type = DiffValueType::Int8;
+    } else if (name == "i16") {
+        type = DiffValueType::Int16;
+    } else if (name.empty() || name == "i32") {
+        type = DiffValueType::Int32;
+    } else if (name == "i64") {
+        type = DiffValueType::Int64;
+    } else if (name == "f32" || name == "float") {
+        type = DiffValueType::Float;
+    } else if (name == "f64" || name == "double") {
+        type = DiffValueType::Double;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+int64_t signedValue(DiffValueType type, uint64_t bits) {
+    switch (type) {
+        case DiffValueType::Int8:
+            return static_cast<int8_t>(bits);
+        case DiffValueType::Int16:
+            return static_cast<int16_t>(bits);
+        case DiffValueType::Int32:
+            return static_cast<int32_t>(bits);
+        default:
+            return static_cast<int64_t>(bits);
+    }
+}
+
+double floatValue(DiffValueType type, uint64_t bits) {
+    if (type == DiffValueType::Float) {
+        float value;
+        uint32_t raw = static_cast<uint32_t>(bits);
+        memcpy(&value, &raw, sizeof(value));
+        return value;
+    }
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+} // namespace
+
+std::string SnapshotDiff::formatValue(DiffValueType type, uint64_t bits) {
+    char text[32];
+    if (type == DiffValueType::Float || type == DiffValueType::Double) {
+        snprintf(text, sizeof(text), "%g", floatValue(type, bits));
+    } else {
+        snprintf(text, sizeof(text), "%lld", static_cast<long long>(signedValue(type, bits)));
+    }
+    return text;
+}
+
+double SnapshotDiff::deltaValue(DiffValueType type, const ValueDelta& delta) {
+    if (type == DiffValueType::Float || type == DiffValueType::Double) {
+        return floatValue(type, delta.newBits) - floatValue(type, delta.oldBits);
+    }
+    // 用无符号减法避免 int64 溢出，再按有符号解释
+    return static_cast<double>(static_cast<int64_t>(
+        static_cast<uint64_t>(signedValue(type, delta.newBits)) -
+        static_cast<uint64_t>(signedValue(type, delta.oldBits))));
+}
+
+} // namespace memchainer
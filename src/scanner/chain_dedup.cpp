@@ -0,0 +1,302 @@
+#include "scanner/chain_dedup.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace memchainer {
+
+namespace {
+
+// 内存集合中每个签名的估算开销（节点 + 桶指针）
+constexpr size_t kBytesPerEntry = sizeof(ChainSignature) + 32;
+
+// 合并溢出文件时的读写批次（签名数量）
+constexpr size_t kMergeBatch = 64 * 1024;
+
+inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t fmix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+// 双通道128位哈希
+class SignatureHasher {
+public:
+    void update(uint64_t v) {
+        a_ = rotl64(a_ ^ (v * 0x87c37b91114253d5ULL), 31) * 0x4cf5ad432745937fULL;
+        b_ = rotl64(b_ + v, 27) * 0x9e3779b97f4a7c15ULL + a_;
+        length_++;
+    }
+
+    void updateString(const char* s) {
+        size_t len = s ? strlen(s) : 0;
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+            uint64_t v;
+            memcpy(&v, s + i, sizeof(v));
+            update(v);
+        }
+        uint64_t tail = 0;
+        memcpy(&tail, s + i, len - i);
+        // 长度参与哈希，避免 "ab"+"c" 与 "a"+"bc" 冲突
+        update(tail ^ (static_cast<uint64_t>(len) << 56));
+    }
+
+    ChainSignature finish() const {
+        uint64_t a = fmix64(a_ ^ length_);
+        uint64_t b = fmix64(b_ + a);
+        return ChainSignature{a + b, b};
+    }
+
+private:
+    uint64_t a_ = 0x9368e53c2f6af274ULL;
+    uint64_t b_ = 0x586dcd208f7cd3fdULL;
+    uint64_t length_ = 0;
+};
+
+bool writeAll(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = ::write(fd, p, size);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+ChainDeduplicator::ChainDeduplicator(size_t memoryLimit, const std::string& spillDir) {
+    maxEntriesPerShard_ = std::max<size_t>(1024, memoryLimit / SHARD_COUNT / kBytesPerEntry);
+
+    if (spillDir.empty()) {
+        spillDir_ = fs::temp_directory_path().string() + "/chainer_cache";
+    } else {
+        spillDir_ = spillDir;
+    }
+}
+
+ChainDeduplicator::~ChainDeduplicator() {
+    clear();
+}
+
+ChainSignature ChainDeduplicator::computeSignature(const char* regionName, uint64_t staticOffset,
+                                                   const Offset* offsets, size_t offsetCount) {
+    SignatureHasher hasher;
+    hasher.updateString(regionName);
+    hasher.update(staticOffset);
+    for (size_t i = 0; i < offsetCount; ++i) {
+        hasher.update(static_cast<uint64_t>(static_cast<uint32_t>(offsets[i])));
+    }
+    return hasher.finish();
+}
+
+ChainSignature ChainDeduplicator::computeSignature(const std::list<PointerChainNode>& chain) {
+    if (chain.empty()) {
+        return ChainSignature{0, 0};
+    }
+
+    const PointerChainNode& head = chain.front();
+    const char* regionName = "";
+    uint64_t staticOffset = head.staticOffset.staticOffset;
+    if (head.staticOffset.region) {
+        regionName = head.staticOffset.region->name;
+    }
+
+    std::vector<Offset> offsets;
+    offsets.reserve(chain.size());
+    for (const auto& node : chain) {
+        offsets.push_back(node.offset);
+    }
+    return computeSignature(regionName, staticOffset, offsets.data(), offsets.size());
+}
+
+bool ChainDeduplicator::insert(const ChainSignature& sig) {
+    size_t shardIndex = static_cast<size_t>(sig.high % SHARD_COUNT);
+    Shard& shard = shards_[shardIndex];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    if (shard.signatures.count(sig) != 0 ||
+        (shard.spillCount > 0 && findInSpill(shard, sig))) {
+        duplicateCount_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    shard.signatures.insert(sig);
+    uniqueCount_.fetch_add(1, std::memory_order_relaxed);
+
+    // 超过分片内存上限，溢出到磁盘
+    if (shard.signatures.size() >= maxEntriesPerShard_) {
+        if (!spillShard(shard, shardIndex)) {
+            std::cerr << "指针链去重: 分片 " << shardIndex << " 溢出失败，继续使用内存" << std::endl;
+        }
+    }
+
+    return true;
+}
+
+void ChainDeduplicator::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.signatures.clear();
+        if (shard.spillFd >= 0) {
+            close(shard.spillFd);
+            shard.spillFd = -1;
+        }
+        shard.spillCount = 0;
+        shard.pageFences.clear();
+    }
+    uniqueCount_.store(0, std::memory_order_relaxed);
+    duplicateCount_.store(0, std::memory_order_relaxed);
+    spilledCount_.store(0, std::memory_order_relaxed);
+}
+
+bool ChainDeduplicator::spillShard(Shard& shard, size_t shardIndex) {
+    try {
+        if (!fs::exists(spillDir_)) {
+            fs::create_directories(spillDir_);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "创建去重溢出目录失败: " << e.what() << std::endl;
+        return false;
+    }
+
+    std::string path = getSpillFilePath(shardIndex, spillGeneration_.fetch_add(1));
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        std::cerr << "无法创建去重溢出文件: " << path << std::endl;
+        return false;
+    }
+    // 文件只通过描述符访问，关闭后自动回收
+    unlink(path.c_str());
+
+    std::vector<ChainSignature> memSigs(shard.signatures.begin(), shard.signatures.end());
+    std::sort(memSigs.begin(), memSigs.end());
+
+    // 与已有溢出文件做二路归并
+    std::vector<ChainSignature> oldBatch;
+    std::vector<ChainSignature> outBatch;
+    outBatch.reserve(kMergeBatch);
+    std::vector<ChainSignature> fences;
+
+    size_t oldPos = 0;      // 已读取的旧签名数
+    size_t oldBatchPos = 0; // 当前批次内位置
+    size_t memPos = 0;
+    size_t written = 0;
+
+    auto refillOld = [&]() {
+        if (oldBatchPos < oldBatch.size() || oldPos >= shard.spillCount) {
+            return;
+        }
+        size_t count = std::min(kMergeBatch, shard.spillCount - oldPos);
+        oldBatch.resize(count);
+        ssize_t n = pread(shard.spillFd, oldBatch.data(), count * sizeof(ChainSignature),
+                          static_cast<off_t>(oldPos * sizeof(ChainSignature)));
+        if (n != static_cast<ssize_t>(count * sizeof(ChainSignature))) {
+            oldBatch.clear();
+            oldPos = shard.spillCount;
+        } else {
+            oldPos += count;
+        }
+        oldBatchPos = 0;
+    };
+
+    auto emit = [&](const ChainSignature& sig) -> bool {
+        if (written % SIGS_PER_PAGE == 0) {
+            fences.push_back(sig);
+        }
+        outBatch.push_back(sig);
+        written++;
+        if (outBatch.size() >= kMergeBatch) {
+            if (!writeAll(fd, outBatch.data(), outBatch.size() * sizeof(ChainSignature))) {
+                return false;
+            }
+            outBatch.clear();
+        }
+        return true;
+    };
+
+    bool ok = true;
+    refillOld();
+    while (ok && (oldBatchPos < oldBatch.size() || memPos < memSigs.size())) {
+        bool takeOld = oldBatchPos < oldBatch.size() &&
+                       (memPos >= memSigs.size() || oldBatch[oldBatchPos] < memSigs[memPos]);
+        if (takeOld) {
+            ok = emit(oldBatch[oldBatchPos++]);
+            refillOld();
+        } else {
+            ok = emit(memSigs[memPos++]);
+        }
+    }
+    if (ok && !outBatch.empty()) {
+        ok = writeAll(fd, outBatch.data(), outBatch.size() * sizeof(ChainSignature));
+    }
+
+    if (!ok) {
+        close(fd);
+        return false;
+    }
+
+    if (shard.spillFd >= 0) {
+        close(shard.spillFd);
+    }
+    shard.spillFd = fd;
+    shard.spillCount = written;
+    shard.pageFences = std::move(fences);
+
+    spilledCount_.fetch_add(memSigs.size(), std::memory_order_relaxed);
+
+    std::unordered_set<ChainSignature, ChainSignatureHash> empty;
+    shard.signatures.swap(empty);
+    return true;
+}
+
+bool ChainDeduplicator::findInSpill(const Shard& shard, const ChainSignature& sig) const {
+    if (shard.spillFd < 0 || shard.pageFences.empty()) {
+        return false;
+    }
+
+    // 定位签名所在页
+    auto it = std::upper_bound(shard.pageFences.begin(), shard.pageFences.end(), sig);
+    if (it == shard.pageFences.begin()) {
+        return false;
+    }
+    size_t page = static_cast<size_t>(std::distance(shard.pageFences.begin(), it)) - 1;
+
+    size_t first = page * SIGS_PER_PAGE;
+    size_t count = std::min(SIGS_PER_PAGE, shard.spillCount - first);
+
+    ChainSignature pageSigs[SIGS_PER_PAGE];
+    ssize_t n = pread(shard.spillFd, pageSigs, count * sizeof(ChainSignature),
+                      static_cast<off_t>(first * sizeof(ChainSignature)));
+    if (n != static_cast<ssize_t>(count * sizeof(ChainSignature))) {
+        return false;
+    }
+
+    return std::binary_search(pageSigs, pageSigs + count, sig);
+}
+
+std::string ChainDeduplicator::getSpillFilePath(size_t shardIndex, int generation) const {
+    std::ostringstream oss;
+    oss << spillDir_ << "/memchainer_dedup_" << getpid() << "_" << shardIndex << "_" << generation << ".bin";
+    return oss.str();
+}
+
+} // namespace memchainer
@@ -0,0 +1,280 @@
+#include "scanner/chain_file.h"
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace memchainer {
+
+namespace {
+
+constexpr char kFileMagic[4] = {'M', 'C', 'Z', '1'};
+constexpr uint16_t kFileVersion = 1;
+
+bool preadAll(int fd, void* buffer, size_t size, uint64_t offset) {
+    char* p = static_cast<char*>(buffer);
+    while (size > 0) {
+        ssize_t n = pread(fd, p, size, static_cast<off_t>(offset));
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+// ============================================================================
+// ChainFileWriter
+// ============================================================================
+
+ChainFileWriter::ChainFileWriter(CompressionType type, size_t frameSize)
+    : type_(type), frameSize_(frameSize) {
+    pending_.reserve(frameSize_ + 64 * 1024);
+}
+
+ChainFileWriter::~ChainFileWriter() {
+    if (file_.is_open()) {
+        close();
+    }
+}
+
+bool ChainFileWriter::open(const std::string& filename) {
+    if (!BlockCompressor::isAvailable(type_)) {
+        std::cerr << "压缩算法不可用: " << BlockCompressor::typeName(type_) << std::endl;
+        return false;
+    }
+
+    file_.open(filename, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!file_.is_open()) {
+        return false;
+    }
+
+    ChainFileHeader header{};
+    memcpy(header.magic, kFileMagic, sizeof(header.magic));
+    header.version = kFileVersion;
+    header.codec = static_cast<uint8_t>(type_);
+    header.frameSize = static_cast<uint32_t>(frameSize_);
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    frames_.clear();
+    pending_.clear();
+    rawBytes_ = 0;
+    writtenBytes_ = sizeof(header);
+    return static_cast<bool>(file_);
+}
+
+bool ChainFileWriter::append(const std::string& text) {
+    if (!file_.is_open()) {
+        return false;
+    }
+
+    pending_.append(text);
+    rawBytes_ += text.size();
+
+    if (pending_.size() >= frameSize_) {
+        return flushFrame();
+    }
+    return true;
+}
+
+bool ChainFileWriter::flushFrame() {
+    if (pending_.empty()) {
+        return true;
+    }
+
+    const uint8_t* raw = reinterpret_cast<const uint8_t*>(pending_.data());
+    CompressionType frameCodec = type_;
+    if (!BlockCompressor::compress(type_, raw, pending_.size(), compressed_) ||
+        compressed_.size() >= pending_.size()) {
+        // 压缩失败或无收益时直接保存原始数据
+        frameCodec = CompressionType::None;
+        compressed_.assign(raw, raw + pending_.size());
+    }
+
+    ChainFrameHeader frame{};
+    frame.magic = FRAME_MAGIC;
+    frame.rawSize = static_cast<uint32_t>(pending_.size());
+    frame.compressedSize = static_cast<uint32_t>(compressed_.size());
+    frame.codec = static_cast<uint8_t>(frameCodec);
+
+    frames_.push_back({writtenBytes_, frame.rawSize, frame.compressedSize});
+
+    file_.write(reinterpret_cast<const char*>(&frame), sizeof(frame));
+    file_.write(reinterpret_cast<const char*>(compressed_.data()), compressed_.size());
+    writtenBytes_ += sizeof(frame) + compressed_.size();
+
+    pending_.clear();
+    return static_cast<bool>(file_);
+}
+
+bool ChainFileWriter::close() {
+    if (!file_.is_open()) {
+        return false;
+    }
+
+    bool ok = flushFrame();
+
+    // 帧索引 + 文件尾
+    ChainFileFooter footer{};
+    footer.indexOffset = writtenBytes_;
+    footer.frameCount = static_cast<uint32_t>(frames_.size());
+    footer.magic = INDEX_MAGIC;
+
+    if (!frames_.empty()) {
+        file_.write(reinterpret_cast<const char*>(frames_.data()),
+                    frames_.size() * sizeof(ChainFrameIndexEntry));
+    }
+    file_.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+    writtenBytes_ += frames_.size() * sizeof(ChainFrameIndexEntry) + sizeof(footer);
+
+    ok = ok && static_cast<bool>(file_);
+    file_.close();
+    return ok;
+}
+
+// ============================================================================
+// ChainFileReader
+// ============================================================================
+
+ChainFileReader::ChainFileReader() : fd_(-1) {
+}
+
+ChainFileReader::~ChainFileReader() {
+    close();
+}
+
+bool ChainFileReader::isChainFile(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    char magic[4] = {0};
+    bool result = preadAll(fd, magic, sizeof(magic), 0) && memcmp(magic, kFileMagic, sizeof(magic)) == 0;
+    ::close(fd);
+    return result;
+}
+
+bool ChainFileReader::open(const std::string& filename) {
+    close();
+
+    fd_ = ::open(filename.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        std::cerr << "无法打开结果文件: " << filename << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        close();
+        return false;
+    }
+    uint64_t fileSize = static_cast<uint64_t>(st.st_size);
+
+    ChainFileHeader header{};
+    if (fileSize < sizeof(header) || !preadAll(fd_, &header, sizeof(header), 0) ||
+        memcmp(header.magic, kFileMagic, sizeof(header.magic)) != 0) {
+        std::cerr << "不是有效的压缩结果文件: " << filename << std::endl;
+        close();
+        return false;
+    }
+
+    if (!loadIndexFromFooter(fileSize) && !rebuildIndexByScan(fileSize)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ChainFileReader::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    frames_.clear();
+}
+
+bool ChainFileReader::loadIndexFromFooter(uint64_t fileSize) {
+    if (fileSize < sizeof(ChainFileHeader) + sizeof(ChainFileFooter)) {
+        return false;
+    }
+
+    ChainFileFooter footer{};
+    if (!preadAll(fd_, &footer, sizeof(footer), fileSize - sizeof(footer)) ||
+        footer.magic != ChainFileWriter::INDEX_MAGIC) {
+        return false;
+    }
+
+    uint64_t indexSize = static_cast<uint64_t>(footer.frameCount) * sizeof(ChainFrameIndexEntry);
+    if (footer.indexOffset + indexSize + sizeof(footer) != fileSize) {
+        return false;
+    }
+
+    frames_.resize(footer.frameCount);
+    if (indexSize > 0 && !preadAll(fd_, frames_.data(), indexSize, footer.indexOffset)) {
+        frames_.clear();
+        return false;
+    }
+    return true;
+}
+
+bool ChainFileReader::rebuildIndexByScan(uint64_t fileSize) {
+    std::cerr << "结果文件缺少帧索引，顺序扫描帧头..." << std::endl;
+
+    frames_.clear();
+    uint64_t offset = sizeof(ChainFileHeader);
+    while (offset + sizeof(ChainFrameHeader) <= fileSize) {
+        ChainFrameHeader frame{};
+        if (!preadAll(fd_, &frame, sizeof(frame), offset) || frame.magic != ChainFileWriter::FRAME_MAGIC) {
+            break;
+        }
+        if (offset + sizeof(frame) + frame.compressedSize > fileSize) {
+            break; // 截断的帧
+        }
+        frames_.push_back({offset, frame.rawSize, frame.compressedSize});
+        offset += sizeof(frame) + frame.compressedSize;
+    }
+    return true;
+}
+
+bool ChainFileReader::readFrame(size_t index, std::string& out) const {
+    if (fd_ < 0 || index >= frames_.size()) {
+        return false;
+    }
+
+    const ChainFrameIndexEntry& entry = frames_[index];
+    std::vector<uint8_t> buffer(sizeof(ChainFrameHeader) + entry.compressedSize);
+    if (!preadAll(fd_, buffer.data(), buffer.size(), entry.fileOffset)) {
+        return false;
+    }
+
+    ChainFrameHeader frame;
+    memcpy(&frame, buffer.data(), sizeof(frame));
+    if (frame.magic != ChainFileWriter::FRAME_MAGIC || frame.rawSize != entry.rawSize ||
+        frame.compressedSize != entry.compressedSize) {
+        return false;
+    }
+
+    out.resize(frame.rawSize);
+    return BlockCompressor::decompress(static_cast<CompressionType>(frame.codec),
+                                       buffer.data() + sizeof(frame), frame.compressedSize,
+                                       reinterpret_cast<uint8_t*>(&out[0]), frame.rawSize);
+}
+
+bool ChainFileReader::readAll(std::string& out) const {
+    out.clear();
+    std::string frameData;
+    for (size_t i = 0; i < frames_.size(); ++i) {
+        if (!readFrame(i, frameData)) {
+            return false;
+        }
+        out.append(frameData);
+    }
+    return true;
+}
+
+} // namespace memchainer
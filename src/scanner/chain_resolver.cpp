@@ -0,0 +1,208 @@
+#include "scanner/chain_resolver.h"
+#include <algorithm>
+#include <iostream>
+
+namespace memchainer {
+
+ChainResolver::ChainResolver() = default;
+
+ChainResolver::~ChainResolver() = default;
+
+bool ChainResolver::initialize(const std::shared_ptr<MemoryAccess>& memAccess,
+                               const std::shared_ptr<MemoryMap>& memMap) {
+    if (!memAccess) {
+        return false;
+    }
+
+    memoryAccess_ = memAccess;
+    memoryMap_ = memMap;
+    return true;
+}
+
+bool ChainResolver::compile(const ChainSet& chains) {
+    std::vector<uint32_t> indices(chains.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        indices[i] = static_cast<uint32_t>(i);
+    }
+    return compile(chains, indices);
+}
+
+bool ChainResolver::compile(const ChainSet& chains, const std::vector<uint32_t>& indices) {
+    chains_ = &chains;
+    levels_.clear();
+    chainLeaves_.assign(indices.size(), Leaf{0, 0});
+
+    // 按字典序处理，前缀共享只需与上一条链比较
+    std::vector<uint32_t> order(indices.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return chains.chainLess(indices[a], indices[b]);
+    });
+
+    levels_.resize(chains.getMaxDepth() + 1);
+
+    std::vector<uint32_t> path;     // 上一条链每层的节点下标
+    ChainView prev{0, 0, nullptr, 0};
+    bool hasPrev = false;
+
+    for (uint32_t pos : order) {
+        ChainView view = chains.get(indices[pos]);
+
+        // 与上一条链共享的层数
+        uint32_t shared = 0;
+        if (hasPrev && view.moduleId == prev.moduleId && view.staticOffset == prev.staticOffset) {
+            shared = 1;
+            uint32_t limit = std::min(view.depth, prev.depth);
+            while (shared <= limit && view.offsets[shared - 1] == prev.offsets[shared - 1]) {
+                shared++;
+            }
+        }
+
+        path.resize(view.depth + 1);
+        for (uint32_t level = shared; level <= view.depth; ++level) {
+            Node node{};
+            if (level == 0) {
+                node.parent = view.moduleId;
+                node.staticOffset = view.staticOffset;
+            } else {
+                node.parent = path[level - 1];
+                node.offset = view.offsets[level - 1];
+            }
+            path[level] = static_cast<uint32_t>(levels_[level].size());
+            levels_[level].push_back(node);
+        }
+
+        // 路径上除叶子外的节点都需要读取指针值
+        for (uint32_t level = 0; level < view.depth; ++level) {
+            levels_[level][path[level]].needsRead = true;
+        }
+
+        chainLeaves_[pos] = Leaf{view.depth, path[view.depth]};
+        prev = view;
+        hasPrev = true;
+    }
+
+    // 去掉末尾的空层
+    while (!levels_.empty() && levels_.back().empty()) {
+        levels_.pop_back();
+    }
+
+    refreshModuleBases();
+    return true;
+}
+
+void ChainResolver::refreshModuleBases() {
+    if (!memoryMap_ || !chains_) {
+        return;
+    }
+
+    moduleBases_.assign(chains_->getModuleCount(), 0);
+    for (uint32_t id = 0; id < chains_->getModuleCount(); ++id) {
+        moduleBases_[id] = memoryMap_->resolveModuleBase(chains_->getModuleName(id));
+    }
+}
+
+size_t ChainResolver::getNodeCount() const {
+    size_t count = 0;
+    for (const auto& level : levels_) {
+        count += level.size();
+    }
+    return count;
+}
+
+bool ChainResolver::resolve(std::vector<ResolvedChain>& results) {
+    if (!memoryAccess_ || levels_.empty()) {
+        results.clear();
+        return false;
+    }
+
+    lastReadCount_ = 0;
+    evaluateHeads();
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        lastReadCount_ += readLevel(level);
+        if (level + 1 < levels_.size()) {
+            propagateLevel(level);
+        }
+    }
+
+    collectResults(results);
+    return true;
+}
+
+void ChainResolver::evaluateHeads() {
+    for (auto& node : levels_[0]) {
+        Address base = node.parent < moduleBases_.size() ? moduleBases_[node.parent] : 0;
+        node.address = base + node.staticOffset;
+        node.valid = base != 0;
+        node.readOk = false;
+    }
+}
+
+size_t ChainResolver::readLevel(size_t level, const std::vector<uint8_t>* mask) {
+    std::vector<Node>& nodes = levels_[level];
+
+    pending_.clear();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const Node& node = nodes[i];
+        if (node.needsRead && node.valid && (!mask || (*mask)[i])) {
+            pending_.emplace_back(node.address, static_cast<uint32_t>(i));
+        }
+    }
+    if (pending_.empty()) {
+        return 0;
+    }
+
+    // 不同父节点可能算出相同地址，排序后去重
+    std::sort(pending_.begin(), pending_.end());
+
+    requests_.clear();
+    values_.resize(pending_.size());
+    for (size_t i = 0; i < pending_.size(); ++i) {
+        if (i == 0 || pending_[i].first != pending_[i - 1].first) {
+            requests_.push_back({pending_[i].first, &values_[requests_.size()], sizeof(Address), false});
+        }
+    }
+
+    if (memoryCache_) {
+        for (auto& req : requests_) {
+            req.success = memoryCache_->readMemory(memoryAccess_, req.address, req.buffer, req.size);
+        }
+    } else {
+        memoryAccess_->readBatch(requests_.data(), requests_.size());
+    }
+
+    // 把读取结果分发回节点
+    size_t slot = 0;
+    for (size_t i = 0; i < pending_.size(); ++i) {
+        if (i > 0 && pending_[i].first != pending_[i - 1].first) {
+            slot++;
+        }
+        Node& node = nodes[pending_[i].second];
+        node.readOk = requests_[slot].success;
+        node.value = node.readOk ? stripPointerTag(values_[slot]) : 0;
+    }
+
+    return requests_.size();
+}
+
+void ChainResolver::propagateLevel(size_t level) {
+    const std::vector<Node>& parents = levels_[level];
+    for (auto& node : levels_[level + 1]) {
+        const Node& parent = parents[node.parent];
+        node.valid = parent.valid && parent.readOk;
+        node.address = parent.value + static_cast<Address>(static_cast<int64_t>(node.offset));
+    }
+}
+
+void ChainResolver::collectResults(std::vector<ResolvedChain>& results) const {
+    results.resize(chainLeaves_.size());
+    for (size_t i = 0; i < chainLeaves_.size(); ++i) {
+        const Leaf& leaf = chainLeaves_[i];
+        const Node& node = levels_[leaf.level][leaf.index];
+        results[i] = ResolvedChain{node.address, node.valid};
+    }
+}
+
+} // namespace memchainer
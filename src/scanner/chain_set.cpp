@@ -0,0 +1,343 @@
+#include "scanner/chain_set.h"
+#include "scanner/chain_file.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace memchainer {
+
+namespace {
+
+#pragma pack(push, 1)
+struct ChainSetHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t moduleCount;
+    uint32_t reserved;
+    uint64_t chainCount;
+    uint64_t offsetCount;
+};
+#pragma pack(pop)
+
+// 解析十六进制数，返回解析结束位置
+const char* parseHex(const char* p, const char* end, uint64_t& value) {
+    value = 0;
+    const char* start = p;
+    while (p < end) {
+        char c = *p;
+        uint64_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = static_cast<uint64_t>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            digit = static_cast<uint64_t>(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            digit = static_cast<uint64_t>(c - 'A' + 10);
+        } else {
+            break;
+        }
+        value = (value << 4) | digit;
+        ++p;
+    }
+    return p == start ? nullptr : p;
+}
+
+} // namespace
+
+void ChainSet::clear() {
+    modules_.clear();
+    moduleIndex_.clear();
+    chains_.clear();
+    offsets_.clear();
+    maxDepth_ = 0;
+}
+
+uint32_t ChainSet::internModule(const std::string& name) {
+    auto it = moduleIndex_.find(name);
+    if (it != moduleIndex_.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(modules_.size());
+    modules_.push_back(name);
+    moduleIndex_.emplace(name, id);
+    return id;
+}
+
+void ChainSet::addChain(uint32_t moduleId, uint64_t staticOffset, const Offset* offsets, uint32_t depth) {
+    ChainEntry entry;
+    entry.staticOffset = staticOffset;
+    entry.moduleId = moduleId;
+    entry.offsetBegin = static_cast<uint32_t>(offsets_.size());
+    entry.depth = depth;
+    offsets_.insert(offsets_.end(), offsets, offsets + depth);
+    chains_.push_back(entry);
+    maxDepth_ = std::max(maxDepth_, depth);
+}
+
+void ChainSet::addChain(const std::list<PointerChainNode>& chain) {
+    if (chain.empty() || !chain.front().staticOffset.region) {
+        return;
+    }
+
+    const PointerChainNode& head = chain.front();
+    uint32_t moduleId = internModule(head.staticOffset.region->name);
+
+    std::vector<Offset> offsets;
+    offsets.reserve(chain.size());
+    for (const auto& node : chain) {
+        offsets.push_back(node.offset);
+    }
+    addChain(moduleId, head.staticOffset.staticOffset, offsets.data(), static_cast<uint32_t>(offsets.size()));
+}
+
+void ChainSet::addChain(const ChainSet& other, size_t index) {
+    ChainView view = other.get(index);
+    uint32_t moduleId = internModule(other.getModuleName(view.moduleId));
+    addChain(moduleId, view.staticOffset, view.offsets, view.depth);
+}
+
+ChainView ChainSet::get(size_t index) const {
+    const ChainEntry& entry = chains_[index];
+    return ChainView{entry.moduleId, entry.staticOffset, offsets_.data() + entry.offsetBegin, entry.depth};
+}
+
+bool ChainSet::chainLess(size_t a, size_t b) const {
+    const ChainEntry& ca = chains_[a];
+    const ChainEntry& cb = chains_[b];
+    if (ca.moduleId != cb.moduleId) {
+        return ca.moduleId < cb.moduleId;
+    }
+    if (ca.staticOffset != cb.staticOffset) {
+        return ca.staticOffset < cb.staticOffset;
+    }
+    return std::lexicographical_compare(
+        offsets_.begin() + ca.offsetBegin, offsets_.begin() + ca.offsetBegin + ca.depth,
+        offsets_.begin() + cb.offsetBegin, offsets_.begin() + cb.offsetBegin + cb.depth);
+}
+
+std::vector<uint32_t> ChainSet::sortedOrder() const {
+    std::vector<uint32_t> order(chains_.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return chainLess(a, b);
+    });
+    return order;
+}
+
+bool ChainSet::parseLine(const char* begin, const char* end) {
+    // 去除行尾空白
+    while (end > begin && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) {
+        --end;
+    }
+    if (begin >= end || *begin == '#' || *begin == '-') {
+        return false;
+    }
+
+    // 模块名可能包含 ':'（例如 ":bss"），以最后一个 ":+0x" 为分界
+    const char* sep = nullptr;
+    for (const char* p = end - 4; p >= begin; --p) {
+        if (memcmp(p, ":+0x", 4) == 0) {
+            sep = p;
+            break;
+        }
+    }
+    if (!sep || sep == begin) {
+        return false;
+    }
+
+    uint64_t staticOffset = 0;
+    const char* p = parseHex(sep + 4, end, staticOffset);
+    if (!p) {
+        return false;
+    }
+
+    Offset offsets[256];
+    uint32_t depth = 0;
+    while (p < end) {
+        if (end - p < 4 || memcmp(p, "->0x", 4) != 0 || depth >= 256) {
+            return false;
+        }
+        uint64_t value = 0;
+        p = parseHex(p + 4, end, value);
+        if (!p) {
+            return false;
+        }
+        offsets[depth++] = static_cast<Offset>(static_cast<uint32_t>(value));
+    }
+    if (depth == 0) {
+        return false;
+    }
+
+    uint32_t moduleId = internModule(std::string(begin, sep));
+    addChain(moduleId, staticOffset, offsets, depth);
+    return true;
+}
+
+std::string ChainSet::formatChain(size_t index) const {
+    ChainView view = get(index);
+    std::stringstream ss;
+    ss << std::hex << modules_[view.moduleId] << ":+0x" << view.staticOffset;
+    for (uint32_t i = 0; i < view.depth; ++i) {
+        ss << "->0x" << view.offsets[i];
+    }
+    return ss.str();
+}
+
+bool ChainSet::loadText(const std::string& text) {
+    const char* p = text.data();
+    const char* end = p + text.size();
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        parseLine(p, lineEnd);
+        p = lineEnd + 1;
+    }
+    return true;
+}
+
+bool ChainSet::loadFromFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "无法打开指针链文件: " << filename << std::endl;
+        return false;
+    }
+
+    uint32_t magic = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    file.close();
+
+    if (magic == BINARY_MAGIC) {
+        return loadBinary(filename);
+    }
+
+    std::string text;
+    if (ChainFileReader::isChainFile(filename)) {
+        ChainFileReader reader;
+        if (!reader.open(filename) || !reader.readAll(text)) {
+            std::cerr << "解压指针链文件失败: " << filename << std::endl;
+            return false;
+        }
+    } else {
+        std::ifstream textFile(filename, std::ios::binary);
+        std::stringstream buffer;
+        buffer << textFile.rdbuf();
+        text = buffer.str();
+    }
+
+    return loadText(text);
+}
+
+bool ChainSet::loadBinary(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    ChainSetHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != BINARY_MAGIC || header.version != BINARY_VERSION) {
+        std::cerr << "二进制指针链文件格式错误: " << filename << std::endl;
+        return false;
+    }
+
+    clear();
+
+    for (uint32_t i = 0; i < header.moduleCount; ++i) {
+        uint16_t len = 0;
+        file.read(reinterpret_cast<char*>(&len), sizeof(len));
+        std::string name(len, '\0');
+        file.read(&name[0], len);
+        if (!file) {
+            return false;
+        }
+        internModule(name);
+    }
+
+    chains_.resize(header.chainCount);
+    offsets_.resize(header.offsetCount);
+    file.read(reinterpret_cast<char*>(chains_.data()), chains_.size() * sizeof(ChainEntry));
+    file.read(reinterpret_cast<char*>(offsets_.data()), offsets_.size() * sizeof(Offset));
+    if (!file) {
+        std::cerr << "二进制指针链文件不完整: " << filename << std::endl;
+        clear();
+        return false;
+    }
+
+    for (const auto& entry : chains_) {
+        if (entry.moduleId >= modules_.size() ||
+            static_cast<uint64_t>(entry.offsetBegin) + entry.depth > offsets_.size()) {
+            std::cerr << "二进制指针链文件数据损坏: " << filename << std::endl;
+            clear();
+            return false;
+        }
+        maxDepth_ = std::max(maxDepth_, entry.depth);
+    }
+    return true;
+}
+
+bool ChainSet::saveBinary(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    ChainSetHeader header{};
+    header.magic = BINARY_MAGIC;
+    header.version = BINARY_VERSION;
+    header.moduleCount = static_cast<uint32_t>(modules_.size());
+    header.chainCount = chains_.size();
+    header.offsetCount = offsets_.size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const auto& name : modules_) {
+        uint16_t len = static_cast<uint16_t>(std::min<size_t>(name.size(), 0xffff));
+        file.write(reinterpret_cast<const char*>(&len), sizeof(len));
+        file.write(name.data(), len);
+    }
+
+    file.write(reinterpret_cast<const char*>(chains_.data()), chains_.size() * sizeof(ChainEntry));
+    file.write(reinterpret_cast<const char*>(offsets_.data()), offsets_.size() * sizeof(Offset));
+    return static_cast<bool>(file);
+}
+
+bool ChainSet::saveText(const std::string& filename, CompressionType compression) const {
+    std::string header = "# 格式: [模块+偏移] -> [偏移1] -> [偏移2] -> ... -> 目标地址\n"
+                         "----------------------------------------\n";
+
+    if (compression != CompressionType::None) {
+        ChainFileWriter writer(compression);
+        if (!writer.open(filename) || !writer.append(header)) {
+            return false;
+        }
+        std::string batch;
+        for (size_t i = 0; i < chains_.size(); ++i) {
+            batch += formatChain(i);
+            batch += '\n';
+            if (batch.size() >= ChainFileWriter::DEFAULT_FRAME_SIZE) {
+                writer.append(batch);
+                batch.clear();
+            }
+        }
+        writer.append(batch);
+        return writer.close();
+    }
+
+    std::ofstream file(filename, std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << header;
+    for (size_t i = 0; i < chains_.size(); ++i) {
+        file << formatChain(i) << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+} // namespace memchainer
@@ -0,0 +1,225 @@
+#include "scanner/chain_watcher.h"
+#include <chrono>
+#include <iostream>
+
+namespace memchainer {
+
+ChainWatcher::ChainWatcher() = default;
+
+ChainWatcher::~ChainWatcher() {
+    stop();
+}
+
+bool ChainWatcher::watch(const ChainSet& chains, const std::vector<uint32_t>& indices,
+                         const WatchOptions& options) {
+    if (running_) {
+        std::cerr << "监视器运行中，无法修改监视的指针链" << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    options_ = options;
+    watched_ = indices;
+    if (!compile(chains, indices)) {
+        return false;
+    }
+
+    lastAddress_.assign(levels_.size(), std::vector<Address>());
+    lastValid_.assign(levels_.size(), std::vector<uint8_t>());
+    readMask_.assign(levels_.size(), std::vector<uint8_t>());
+    leafMask_.assign(levels_.size(), std::vector<uint8_t>());
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        lastAddress_[level].assign(levels_[level].size(), 0);
+        lastValid_[level].assign(levels_[level].size(), 0);
+        readMask_[level].assign(levels_[level].size(), 1);
+        leafMask_[level].assign(levels_[level].size(), 0);
+    }
+
+    // 监视值时叶子节点也需要读取，且每轮都读取
+    if (options_.watchValues) {
+        for (const auto& leaf : chainLeaves_) {
+            levels_[leaf.level][leaf.index].needsRead = true;
+            leafMask_[leaf.level][leaf.index] = 1;
+        }
+    }
+
+    states_.assign(watched_.size(), ChainState{0, 0, false});
+    stability_.assign(watched_.size(), ChainStability());
+    stats_ = WatchStats();
+    return true;
+}
+
+void ChainWatcher::setCallback(ChangeCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callback_ = std::move(callback);
+}
+
+size_t ChainWatcher::tick() {
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::vector<ChainChangeEvent> events;
+    ChangeCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (levels_.empty() || !memoryAccess_) {
+            return 0;
+        }
+
+        bool fullRefresh = stats_.ticks == 0 ||
+                           (options_.fullRefreshInterval > 0 && stats_.ticks % options_.fullRefreshInterval == 0);
+
+        stats_.totalReads += evaluateIncremental(fullRefresh);
+        if (fullRefresh) {
+            stats_.fullRefreshes++;
+        }
+
+        detectChanges(events);
+        stats_.ticks++;
+        stats_.totalEvents += events.size();
+        stats_.lastTickMicros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - startTime).count());
+
+        callback = callback_;
+    }
+
+    // 回调在锁外执行，回调中可以查询统计信息
+    if (callback && !events.empty()) {
+        callback(events);
+    }
+    return events.size();
+}
+
+size_t ChainWatcher::evaluateIncremental(bool fullRefresh) {
+    size_t reads = 0;
+
+    // 链头每轮都读取
+    evaluateHeads();
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        bool readAll = fullRefresh || level == 0;
+        reads += readLevel(level, readAll ? nullptr : &readMask_[level]);
+
+        if (level + 1 >= levels_.size()) {
+            break;
+        }
+
+        // 父节点值不变时子节点地址不变，只有地址变化的节点需要重新读取
+        propagateLevel(level);
+
+        std::vector<Node>& children = levels_[level + 1];
+        std::vector<Address>& lastAddress = lastAddress_[level + 1];
+        std::vector<uint8_t>& lastValid = lastValid_[level + 1];
+        std::vector<uint8_t>& mask = readMask_[level + 1];
+        const std::vector<uint8_t>& leaves = leafMask_[level + 1];
+        for (size_t i = 0; i < children.size(); ++i) {
+            const Node& node = children[i];
+            bool changed = node.address != lastAddress[i] || node.valid != static_cast<bool>(lastValid[i]);
+            // 上一轮读取失败的节点也重试
+            mask[i] = changed || leaves[i] || (node.valid && !node.readOk);
+            lastAddress[i] = node.address;
+            lastValid[i] = node.valid;
+        }
+    }
+
+    return reads;
+}
+
+void ChainWatcher::detectChanges(std::vector<ChainChangeEvent>& events) {
+    bool baseline = stats_.ticks == 0;
+
+    for (size_t i = 0; i < chainLeaves_.size(); ++i) {
+        const Leaf& leaf = chainLeaves_[i];
+        const Node& node = levels_[leaf.level][leaf.index];
+
+        Address value = 0;
+        if (options_.watchValues && node.valid && node.readOk) {
+            value = node.value;
+        }
+
+        ChainState& state = states_[i];
+        ChainStability& stability = stability_[i];
+        if (!node.valid) {
+            stability.invalidTicks++;
+        }
+
+        bool changed = node.address != state.address || value != state.value || node.valid != state.valid;
+        if (changed && !baseline) {
+            events.push_back(ChainChangeEvent{watched_[i], stats_.ticks, state.address, node.address,
+                                              state.value, value, state.valid, node.valid});
+            stability.changeCount++;
+            stability.stableTicks = 0;
+            stability.lastChangeTick = stats_.ticks;
+        } else {
+            stability.stableTicks++;
+        }
+
+        state.address = node.address;
+        state.value = value;
+        state.valid = node.valid;
+    }
+}
+
+bool ChainWatcher::start(double hz) {
+    if (hz <= 0 || running_) {
+        return false;
+    }
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    running_ = true;
+    thread_ = std::thread(&ChainWatcher::run, this, hz);
+    return true;
+}
+
+void ChainWatcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex_);
+        running_ = false;
+    }
+    stopCond_.notify_all();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void ChainWatcher::run(double hz) {
+    auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / hz));
+    auto next = std::chrono::steady_clock::now();
+
+    while (running_) {
+        tick();
+
+        // 单轮耗时超过周期时不追赶，直接从当前时间重新计时
+        next += interval;
+        auto now = std::chrono::steady_clock::now();
+        if (next < now) {
+            next = now;
+        }
+
+        std::unique_lock<std::mutex> lock(stopMutex_);
+        stopCond_.wait_until(lock, next, [this]() { return !running_; });
+    }
+}
+
+WatchStats ChainWatcher::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+std::vector<ChainStability> ChainWatcher::getStability() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stability_;
+}
+
+std::vector<ResolvedChain> ChainWatcher::getResults() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<ResolvedChain> results;
+    collectResults(results);
+    return results;
+}
+
+} // namespace memchainer
@@ -54,6 +54,19 @@ bool PointerFormatter::formatToTextFile(const std::vector<std::list<PointerChain
 }
 
 bool PointerFormatter::initOutputFile(const std::string& filename) {
+    if (compression_ != CompressionType::None) {
+        writer_ = std::make_unique<ChainFileWriter>(compression_);
+        if (!writer_->open(filename)) {
+            writer_.reset();
+            return false;
+        }
+
+        std::stringstream header;
+        header << "# 格式: [模块+偏移] -> [偏移1] -> [偏移2] -> ... -> 目标地址" << std::endl;
+        printSeparator(header);
+        return writer_->append(header.str());
+    }
+
     std::ofstream file(filename, std::ios::trunc);  // 清空文件
     if (!file.is_open()) {
         return false;
@@ -71,6 +84,10 @@ bool PointerFormatter::appendChainToFile(const std::list<PointerChainNode>& chai
         return false;
     }
     
+    if (writer_) {
+        return writer_->append(formatChainToSimple(chain) + '\n');
+    }
+    
     std::ofstream file(filename, std::ios::app);  // 追加模式
     if (!file.is_open()) {
         return false;
@@ -86,11 +103,6 @@ bool PointerFormatter::appendChainsToFile(const std::vector<std::list<PointerCha
         return false;
     }
     
-    std::ofstream file(filename, std::ios::app);  // 追加模式
-    if (!file.is_open()) {
-        return false;
-    }
-    
     // 批量写入，减少IO操作次数
     // 使用字符串缓冲区进一步优化
     std::stringstream buffer;
@@ -100,12 +112,40 @@ bool PointerFormatter::appendChainsToFile(const std::vector<std::list<PointerCha
         }
     }
     
+    // 压缩模式：交给分帧写入器
+    if (writer_) {
+        return writer_->append(buffer.str());
+    }
+    
+    std::ofstream file(filename, std::ios::app);  // 追加模式
+    if (!file.is_open()) {
+        return false;
+    }
+    
     // 一次性写入所有内容
     file << buffer.str();
     
     return true;
 }
 
+bool PointerFormatter::closeOutputFile() {
+    if (!writer_) {
+        return true;
+    }
+    
+    bool ok = writer_->close();
+    uint64_t rawBytes = writer_->getRawBytes();
+    uint64_t writtenBytes = writer_->getWrittenBytes();
+    if (writtenBytes > 0) {
+        std::cout << "压缩输出(" << BlockCompressor::typeName(compression_) << "): 原始 "
+                  << rawBytes / 1024 << " KB, 写入 " << writtenBytes / 1024 << " KB, 压缩比 "
+                  << std::fixed << std::setprecision(2)
+                  << static_cast<double>(rawBytes) / writtenBytes << std::defaultfloat << std::endl;
+    }
+    writer_.reset();
+    return ok;
+}
+
 std::string PointerFormatter::formatChain(const std::list<PointerChainNode>& chains) {
     if (chains.empty()) {
         return "空指针链";
@@ -136,9 +176,9 @@ std::string PointerFormatter::formatStaticNode(const PointerChainNode& node) {
            << " value: 0x" << std::setw(16) << std::setfill('0') << node.value
            << " offset: 0x" << std::setw(8) << std::setfill('0') << node.offset;
         
-        if (showStaticOffset_ && node.staticOffset->region) {
-            ss << " staticOffset: 0x" << std::setw(8) << std::setfill('0') << node.staticOffset->staticOffset
-               << " region: " << node.staticOffset->region->name;
+        if (showStaticOffset_ && node.staticOffset.region) {
+            ss << " staticOffset: 0x" << std::setw(8) << std::setfill('0') << node.staticOffset.staticOffset
+               << " region: " << node.staticOffset.region->name;
         }
         
         if (format_ == "both") {
@@ -149,9 +189,9 @@ std::string PointerFormatter::formatStaticNode(const PointerChainNode& node) {
            << " value: " << node.value
            << " offset: " << node.offset;
         
-        if (showStaticOffset_ && node.staticOffset->region) {
-            ss << " staticOffset: " << node.staticOffset->staticOffset
-               << " region: " << node.staticOffset->region->name;
+        if (showStaticOffset_ && node.staticOffset.region) {
+            ss << " staticOffset: " << node.staticOffset.staticOffset
+               << " region: " << node.staticOffset.region->name;
         }
     }
     
@@ -168,9 +208,10 @@ std::string PointerFormatter::formatChainToSimple(const std::list<PointerChainNo
     ss << std::hex;
     auto it = chains.begin();
     // 格式化静态头节点
-    ss << it->staticOffset->region->name << ":";
-    ss << "+0x" <<  it->staticOffset->staticOffset;
-    //ss << "->0x" << it->offset;
+    ss << it->staticOffset.region->name << ":";
+    ss << "+0x" <<  it->staticOffset.staticOffset;
+    // 静态节点自身的偏移也要输出，否则不同的链会格式化成相同文本
+    ss << "->0x" << it->offset;
     ++it;
     
 
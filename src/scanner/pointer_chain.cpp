@@ -54,7 +54,7 @@ void PointerChain::buildPointerChain( std::vector<std::vector<PointerRange>>& di
         }
         for (const auto& range : dirs[level]) {
             for (const auto& dir : range.results) {
-                if (dir.Data->staticOffset_->staticOffset != 0) {
+                if (dir.Data->staticOffset_.staticOffset != 0) {
                     // 找到静态指针
                     staticPointers.push_back(dir);
                 }
@@ -106,8 +106,8 @@ void PointerChain::printChain() {
         std::cout << std::hex << "static head: " << chain.front().address 
         << " value: " << chain.front().value 
         << " offset:0x" << chain.front().offset 
-        << " staticOffset:0x" << chain.front().staticOffset->staticOffset
-        << " region: " << chain.front().staticOffset->region->name << std::endl;
+        << " staticOffset:0x" << chain.front().staticOffset.staticOffset
+        << " region: " << chain.front().staticOffset.region->name << std::endl;
         //弹出静态头
         chain.pop_front();
 
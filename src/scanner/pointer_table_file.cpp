@@ -0,0 +1,213 @@
+#include "scanner/pointer_table_file.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace memchainer {
+
+namespace {
+
+constexpr char kTableMagic[4] = {'M', 'C', 'P', 'T'};
+constexpr uint16_t kTableVersion = 1;
+constexpr uint64_t kTableAlign = 4096;
+constexpr size_t kWriteBufferEntries = 64 * 1024;
+
+} // namespace
+
+// ============================================================================
+// PointerTableWriter
+// ============================================================================
+
+PointerTableWriter::PointerTableWriter() = default;
+
+PointerTableWriter::~PointerTableWriter() {
+    if (file_.is_open()) {
+        close();
+    }
+}
+
+bool PointerTableWriter::open(const std::string& filename, ProcessId pid, uint64_t fingerprint,
+                              const std::vector<MemoryRegion*>& scanRegions,
+                              const std::vector<MemoryRegion*>& staticRegions) {
+    file_.open(filename, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!file_.is_open()) {
+        std::cerr << "无法创建指针表文件: " << filename << std::endl;
+        return false;
+    }
+
+    // 区域表：扫描区域和静态区域合并，同一区域只记录一次
+    std::vector<PointerTableRegion> regions;
+    regionIndex_.clear();
+    auto addRegion = [&](const MemoryRegion* region, uint8_t flag) {
+        auto it = regionIndex_.find(region);
+        if (it != regionIndex_.end()) {
+            regions[it->second - 1].flags |= flag;
+            return;
+        }
+        PointerTableRegion record{};
+        record.startAddress = region->startAddress;
+        record.endAddress = region->endAddress;
+        record.type = region->type;
+        record.count = region->count;
+        record.flags = flag;
+        memcpy(record.name, region->name, sizeof(record.name));
+        regions.push_back(record);
+        regionIndex_[region] = static_cast<uint32_t>(regions.size());
+    };
+    for (const auto* region : scanRegions) {
+        addRegion(region, REGION_SCANNED);
+    }
+    for (const auto* region : staticRegions) {
+        addRegion(region, REGION_STATIC);
+    }
+
+    memcpy(header_.magic, kTableMagic, sizeof(header_.magic));
+    header_.version = kTableVersion;
+    header_.pid = pid;
+    header_.regionCount = static_cast<uint32_t>(regions.size());
+    header_.timestamp = static_cast<uint64_t>(std::time(nullptr));
+    header_.mapsFingerprint = fingerprint;
+    header_.pointerCount = 0;
+    header_.regionOffset = sizeof(PointerTableHeader);
+    uint64_t tableEnd = header_.regionOffset + regions.size() * sizeof(PointerTableRegion);
+    header_.pointerOffset = (tableEnd + kTableAlign - 1) / kTableAlign * kTableAlign;
+
+    file_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    file_.write(reinterpret_cast<const char*>(regions.data()), regions.size() * sizeof(PointerTableRegion));
+    std::vector<char> padding(header_.pointerOffset - tableEnd, 0);
+    file_.write(padding.data(), padding.size());
+
+    buffer_.clear();
+    buffer_.reserve(kWriteBufferEntries);
+    lastValue_ = 0;
+    return static_cast<bool>(file_);
+}
+
+bool PointerTableWriter::add(Address address, Address value, const MemoryRegion* staticRegion) {
+    if (!file_.is_open()) {
+        return false;
+    }
+    if (value < lastValue_) {
+        std::cerr << "指针表必须按值顺序写入" << std::endl;
+        return false;
+    }
+    lastValue_ = value;
+
+    uint32_t region = 0;
+    if (staticRegion) {
+        auto it = regionIndex_.find(staticRegion);
+        region = it != regionIndex_.end() ? it->second : 0;
+    }
+    buffer_.push_back(PointerTableEntry{address, value, region, 0});
+    header_.pointerCount++;
+
+    return buffer_.size() < kWriteBufferEntries || flush();
+}
+
+bool PointerTableWriter::flush() {
+    file_.write(reinterpret_cast<const char*>(buffer_.data()), buffer_.size() * sizeof(PointerTableEntry));
+    buffer_.clear();
+    return static_cast<bool>(file_);
+}
+
+bool PointerTableWriter::close() {
+    if (!file_.is_open()) {
+        return false;
+    }
+
+    // 写出剩余指针后回填指针数量
+    bool success = flush();
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    file_.close();
+    return success && !file_.fail();
+}
+
+// ============================================================================
+// PointerTableFile
+// ============================================================================
+
+PointerTableFile::PointerTableFile() = default;
+
+PointerTableFile::~PointerTableFile() {
+    close();
+}
+
+bool PointerTableFile::open(const std::string& filename) {
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "无法打开指针表文件: " << filename << std::endl;
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(PointerTableHeader)) {
+        ::close(fd);
+        std::cerr << "指针表文件不完整: " << filename << std::endl;
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        std::cerr << "映射指针表文件失败: " << filename << std::endl;
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(addr);
+    mappedSize_ = size;
+
+    memcpy(&header_, data_, sizeof(header_));
+    if (memcmp(header_.magic, kTableMagic, sizeof(kTableMagic)) != 0 || header_.version != kTableVersion) {
+        std::cerr << "不是指针表文件或版本不支持: " << filename << std::endl;
+        close();
+        return false;
+    }
+
+    uint64_t regionEnd = header_.regionOffset + uint64_t(header_.regionCount) * sizeof(PointerTableRegion);
+    uint64_t pointerEnd = header_.pointerOffset + header_.pointerCount * sizeof(PointerTableEntry);
+    if (regionEnd > size || pointerEnd > size || header_.pointerOffset % kTableAlign != 0) {
+        std::cerr << "指针表文件不完整: " << filename << std::endl;
+        close();
+        return false;
+    }
+
+    regions_.resize(header_.regionCount);
+    memcpy(regions_.data(), data_ + header_.regionOffset, regions_.size() * sizeof(PointerTableRegion));
+    entries_ = reinterpret_cast<const PointerTableEntry*>(data_ + header_.pointerOffset);
+
+    // 搜索时的查询是随机访问
+    madvise(const_cast<uint8_t*>(data_), mappedSize_, MADV_RANDOM);
+    return true;
+}
+
+void PointerTableFile::close() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), mappedSize_);
+    }
+    data_ = nullptr;
+    mappedSize_ = 0;
+    entries_ = nullptr;
+    regions_.clear();
+    header_ = PointerTableHeader{};
+}
+
+std::pair<const PointerTableEntry*, const PointerTableEntry*>
+PointerTableFile::findRange(Address minValue, Address maxValue) const {
+    const PointerTableEntry* first = std::lower_bound(
+        begin(), end(), minValue,
+        [](const PointerTableEntry& entry, Address value) { return entry.value < value; });
+    const PointerTableEntry* last = std::upper_bound(
+        first, end(), maxValue,
+        [](Address value, const PointerTableEntry& entry) { return value < entry.value; });
+    return {first, last};
+}
+
+} // namespace memchainer
@@ -0,0 +1,153 @@
+#include "scanner/rescanner.h"
+#include "common/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <iostream>
+
+namespace memchainer {
+
+PointerRescanner::PointerRescanner() = default;
+
+PointerRescanner::~PointerRescanner() = default;
+
+bool PointerRescanner::initialize(const std::shared_ptr<MemoryAccess>& memAccess,
+                                  const std::shared_ptr<MemoryMap>& memMap) {
+    if (!memAccess || !memMap) {
+        return false;
+    }
+
+    memoryAccess_ = memAccess;
+    memoryMap_ = memMap;
+    return true;
+}
+
+std::vector<Address> PointerRescanner::resolveModuleBases(const ChainSet& chains) {
+    std::vector<Address> bases(chains.getModuleCount(), 0);
+
+    for (uint32_t id = 0; id < chains.getModuleCount(); ++id) {
+        bases[id] = memoryMap_->resolveModuleBase(chains.getModuleName(id));
+        if (!bases[id]) {
+            std::cerr << "新进程中找不到模块: " << chains.getModuleName(id) << std::endl;
+        }
+    }
+
+    return bases;
+}
+
+size_t PointerRescanner::rescan(const ChainSet& input, Address targetAddress, ChainSet& output,
+                                const RescanOptions& options) {
+    stats_ = RescanStats();
+    stats_.inputChains = input.size();
+    output.clear();
+
+    if (!memoryAccess_ || !memoryMap_ || input.empty()) {
+        return 0;
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    std::vector<Address> moduleBases = resolveModuleBases(input);
+    stats_.unresolvedModules = static_cast<size_t>(std::count(moduleBases.begin(), moduleBases.end(), 0));
+
+    // 排序后共享前缀的链相邻
+    std::vector<uint32_t> order = input.sortedOrder();
+    std::vector<uint8_t> survive(input.size(), 0);
+
+    size_t chunkSize = std::max<size_t>(1, options.chunkSize);
+    size_t chunkCount = (order.size() + chunkSize - 1) / chunkSize;
+
+    printf("开始重扫描 %zu 条指针链，目标地址: 0x%lx，分为 %zu 个任务\n",
+           input.size(), (unsigned long)targetAddress, chunkCount);
+
+    if (globalThreadPool && chunkCount > 1) {
+        std::vector<std::future<std::pair<size_t, size_t>>> futures;
+        futures.reserve(chunkCount);
+
+        for (size_t c = 0; c < chunkCount; ++c) {
+            size_t begin = c * chunkSize;
+            size_t end = std::min(order.size(), begin + chunkSize);
+            futures.push_back(globalThreadPool->submit(
+                [&, begin, end]() -> std::pair<size_t, size_t> {
+                    size_t issued = 0;
+                    size_t shared = 0;
+                    // 不同任务写入 survive 的不同下标，无需加锁
+                    evaluateRange(input, order, begin, end, moduleBases, targetAddress,
+                                  survive, issued, shared);
+                    return {issued, shared};
+                }));
+        }
+
+        for (auto& future : futures) {
+            try {
+                auto counts = future.get();
+                stats_.readsIssued += counts.first;
+                stats_.readsShared += counts.second;
+            } catch (const std::exception& e) {
+                std::cerr << "重扫描任务异常: " << e.what() << std::endl;
+            }
+        }
+    } else {
+        evaluateRange(input, order, 0, order.size(), moduleBases, targetAddress,
+                      survive, stats_.readsIssued, stats_.readsShared);
+    }
+
+    // 按输入顺序输出保留的链
+    for (size_t i = 0; i < input.size(); ++i) {
+        if (survive[i]) {
+            output.addChain(input, i);
+        }
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    stats_.survivingChains = output.size();
+    stats_.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+
+    printf("========== 重扫描完成 ==========\n");
+    printf("输入指针链: %zu 条\n", stats_.inputChains);
+    printf("保留指针链: %zu 条\n", stats_.survivingChains);
+    printf("未找到模块: %zu 个\n", stats_.unresolvedModules);
+    printf("读取次数: %zu (共享前缀节省 %zu)\n", stats_.readsIssued, stats_.readsShared);
+    printf("耗时: %lld ms\n", (long long)stats_.elapsedMs);
+
+    return stats_.survivingChains;
+}
+
+void PointerRescanner::evaluateRange(const ChainSet& chains, const std::vector<uint32_t>& order,
+                                     size_t begin, size_t end, const std::vector<Address>& moduleBases,
+                                     Address targetAddress, std::vector<uint8_t>& survive,
+                                     size_t& readsIssued, size_t& readsShared) const {
+    if (begin >= end) {
+        return;
+    }
+
+    std::vector<uint32_t> indices(order.begin() + begin, order.begin() + end);
+
+    ChainResolver resolver;
+    resolver.initialize(memoryAccess_);
+    resolver.compile(chains, indices);
+    resolver.setModuleBases(moduleBases);
+
+    std::vector<ResolvedChain> results;
+    if (!resolver.resolve(results)) {
+        return;
+    }
+
+    // 逐条解析时需要的读取次数，用于统计前缀共享节省的读取
+    size_t naiveReads = 0;
+    for (size_t k = 0; k < indices.size(); ++k) {
+        ChainView view = chains.get(indices[k]);
+        if (moduleBases[view.moduleId] != 0) {
+            naiveReads += view.depth;
+        }
+        if (results[k].valid && results[k].address == targetAddress) {
+            survive[indices[k]] = 1;
+        }
+    }
+
+    readsIssued += resolver.getLastReadCount();
+    readsShared += naiveReads > resolver.getLastReadCount() ? naiveReads - resolver.getLastReadCount() : 0;
+}
+
+} // namespace memchainer
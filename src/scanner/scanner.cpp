@@ -5,6 +5,7 @@
 #include <future>
 #include <iostream>
 #include <cstring>
+#include <ctime>
 #include <sys/user.h>
 #include <functional>
 #include <mutex>
@@ -13,16 +14,27 @@
 #include "common/thread_pool.h"
 #include "scanner/scanner.h"
 #include "scanner/formatter.h"
+#include "scanner/chain_dedup.h"
 
 #include <sys/types.h>
 #include <sys/sysconf.h>
 
 namespace memchainer {
 
+namespace {
+
+// 非静态指针共用的静态偏移
+
+// 内存表中每个指针的大致占用（对象 + 指针数组元素 + 分配器开销）
+constexpr size_t POINTER_ENTRY_BYTES = sizeof(PointerAllData) + sizeof(PointerAllData*) + 16;
+
+// 收集指针时单次读取的块大小和每个任务同时在途的块数
+constexpr size_t SCAN_CHUNK_SIZE = 1024 * 1024;
+constexpr size_t SCAN_PIPELINE_DEPTH = 4;
+
+} // namespace
+
 PointerScanner::PointerScanner() {
-    // 创建文件缓存
-    //fileCache_ = std::make_shared<FileCache>();
-    //fileCache_->initialize();
 }
 
 PointerScanner::~PointerScanner() {
@@ -31,6 +43,10 @@ PointerScanner::~PointerScanner() {
         delete ptr;
     }
     pointerCache_.clear();
+
+    if (fileCache_) {
+        fileCache_->cleanup();
+    }
 }
 
 bool PointerScanner::initialize(const std::shared_ptr<MemoryAccess>& memAccess, 
@@ -45,8 +61,49 @@ bool PointerScanner::initialize(const std::shared_ptr<MemoryAccess>& memAccess,
 }
 
 uint32_t PointerScanner::findPointers() {
+  return findPointers(ScanOptions());
+}
+
+void PointerScanner::resetPointerTable() {
   // 清理旧指针
+  for (auto* ptr : pointerCache_) {
+    delete ptr;
+  }
   pointerCache_.clear();
+  level0Pointers_.clear();
+
+  cacheLevel_.reset();
+  if (fileCache_) {
+    fileCache_->cleanup();
+    fileCache_.reset();
+  }
+  useFileCache_ = false;
+  pointerTable_.reset();
+}
+
+uint32_t PointerScanner::findPointers(const ScanOptions& options) {
+  resetPointerTable();
+  memoryBudget_ = options.memoryBudget;
+  cacheDir_ = options.cacheDir;
+
+  // 内存映射变化后，之前记录的读取失败范围不再可信；
+  // 如果是在记录时的映射基础上增量重新加载的，只保留未变化区域的记录
+  uint64_t fingerprint = memoryMap_->getFingerprint();
+  if (fingerprint != failedRangesFingerprint_) {
+    const MapsDiff& diff = memoryMap_->getLastDiff();
+    if (diff.incremental && diff.previousFingerprint == failedRangesFingerprint_) {
+      for (auto it = failedRanges_.begin(); it != failedRanges_.end();) {
+        RegionId id = memoryMap_->findRegionId(it->first);
+        bool keep = id != INVALID_REGION_ID && id < diff.changes.size() &&
+                    diff.changes[id] == RegionChange::Unchanged &&
+                    memoryMap_->getRegion(id)->startAddress == it->first;
+        it = keep ? std::next(it) : failedRanges_.erase(it);
+      }
+    } else {
+      failedRanges_.clear();
+    }
+    failedRangesFingerprint_ = fingerprint;
+  }
 
   // 获取过滤的内存区域
   auto regions = memoryMap_->getFilteredRegions();
@@ -65,6 +122,10 @@ uint32_t PointerScanner::findPointers() {
     // 回退到单线程扫描
     for (const auto *region : regions) {
       scanRegionForPointers(region->startAddress, region->endAddress);
+
+      if (useFileCache_ || (memoryBudget_ > 0 && pointerCache_.size() * POINTER_ENTRY_BYTES > memoryBudget_)) {
+        spillToFileCache();
+      }
     }
   } else {
     // 使用线程池并行扫描
@@ -80,44 +141,135 @@ uint32_t PointerScanner::findPointers() {
         [this, region]() -> std::vector<PointerAllData*> {
           // 使用局部缓存收集该区域的指针，减少锁竞争
           std::vector<PointerAllData*> localCache;
+
+          // 切换到磁盘缓存后，本任务直接通过自己的写入端写盘，不再在内存中收集
+          std::unique_ptr<CacheProducer> producer;
           
-          std::vector<uint8_t> buffer(PAGE_SIZE);
-          std::error_code ec;
-          
+          // 扫描一段已读取的内存，已知全零的页不可能包含指针
+          auto scanBuffer = [&](Address base, const uint8_t* data, size_t size) {
+            for (size_t pageOffset = 0; pageOffset < size; pageOffset += PAGE_SIZE) {
+              size_t pageSize = std::min<size_t>(PAGE_SIZE, size - pageOffset);
+              if (memoryAccess_->isKnownZeroPage(base + pageOffset)) {
+                continue;
+              }
+
+              if (!producer && useFileCache_.load(std::memory_order_acquire)) {
+                producer = std::make_unique<CacheProducer>(fileCache_.get());
+                for (auto* ptr : localCache) {
+                  producer->add(ptr->address, ptr->value, ptr->staticOffset_.region ? 1 : 0);
+                  delete ptr;
+                }
+                localCache.clear();
+                localCache.shrink_to_fit();
+              }
+
+              // 扫描可能的指针 (64位系统)
+              for (size_t i = pageOffset; i + sizeof(Address) <= pageOffset + pageSize; i += sizeof(Address)) {
+                // 读取潜在的指针值
+                Address value;
+                memcpy(&value, data + i, sizeof(value));
+
+                if (!const_cast<PointerScanner*>(this)->isValidAddress(value)) {
+                  continue;
+                }
+
+                Address pointerAddr = base + i;
+                if (producer) {
+                  producer->add(pointerAddr, value, staticRegionAt(pointerAddr) ? 1 : 0);
+                  continue;
+                }
+
+                auto* pointerAllData = new PointerAllData(
+                  pointerAddr, 
+                  value,
+                  calculateStaticOffset(pointerAddr)
+                );
+                localCache.push_back(pointerAllData);
+              }
+            }
+          };
+
+          // 本区域已知的读取失败范围，任务结束后写回
+          FailedRangeSet failed;
+          {
+            std::lock_guard<std::mutex> lock(failedRangesMutex_);
+            auto it = failedRanges_.find(region->startAddress);
+            if (it != failedRanges_.end()) {
+              failed = it->second;
+            }
+          }
+
+          // 块内有不可读的页时二分读取，不可读的页填0，不会产生指针
+          auto scanAdaptive = [&](Address base, uint8_t* data, size_t size) {
+            memoryAccess_->readAdaptive(base, data, size, failed);
+            scanBuffer(base, data, size);
+          };
+
           Address startAddr = region->startAddress;
           Address endAddr = region->endAddress;
+          std::error_code ec;
 
-          for (Address addr = startAddr; addr < endAddr; addr += PAGE_SIZE) {
-            size_t readSize = std::min<size_t>(PAGE_SIZE, endAddr - addr);
-            
-            // 读取内存块
-            if (!memoryAccess_->read(addr, buffer.data(), readSize, ec)) {
-              continue;  // 如果读取失败，跳过此块
+          if (endAddr - startAddr <= SCAN_CHUNK_SIZE) {
+            // 小区域一次读完，没有可重叠的读取
+            std::vector<uint8_t> buffer(endAddr - startAddr);
+            if (failed.empty() && memoryAccess_->read(startAddr, buffer.data(), buffer.size(), ec)) {
+              scanBuffer(startAddr, buffer.data(), buffer.size());
+            } else {
+              scanAdaptive(startAddr, buffer.data(), buffer.size());
             }
-            
-            // 扫描可能的指针 (64位系统)
-            for (size_t i = 0; i < readSize; i += sizeof(Address)) {
-              if (i + sizeof(Address) > readSize) {
-                break;
+          } else {
+            // 大区域按块读取：队列中保持多个块在途，处理已完成的块时后续块的读取仍在进行
+            auto reader = memoryAccess_->createAsyncReader(SCAN_PIPELINE_DEPTH);
+            std::vector<std::vector<uint8_t>> buffers(SCAN_PIPELINE_DEPTH, std::vector<uint8_t>(SCAN_CHUNK_SIZE));
+            std::vector<size_t> freeBuffers;
+            for (size_t i = 0; i < buffers.size(); ++i) {
+              freeBuffers.push_back(i);
+            }
+            ReadCompletion completions[SCAN_PIPELINE_DEPTH];
+
+            Address next = startAddr;
+            while (next < endAddr || reader->inFlight() > 0) {
+              while (next < endAddr && !freeBuffers.empty()) {
+                size_t index = freeBuffers.back();
+                size_t chunkSize = std::min<size_t>(SCAN_CHUNK_SIZE, endAddr - next);
+                Address failStart, failEnd;
+                if (failed.findFirst(next, next + chunkSize, failStart, failEnd)) {
+                  // 含已知失败范围的块直接跳过这些页读取
+                  scanAdaptive(next, buffers[index].data(), chunkSize);
+                } else if (!reader->submit(next, buffers[index].data(), chunkSize, index)) {
+                  break;
+                } else {
+                  freeBuffers.pop_back();
+                }
+                next += chunkSize;
               }
-              
-              // 读取潜在的指针值
-              Address value = *reinterpret_cast<Address*>(buffer.data() + i);
 
-              if (!const_cast<PointerScanner*>(this)->isValidAddress(value)) {
+              if (reader->inFlight() == 0) {
+                // 没有在途读取却仍有剩余：读取队列不再接受提交，剩余的块同步读取
+                for (; next < endAddr; next += SCAN_CHUNK_SIZE) {
+                  scanAdaptive(next, buffers[0].data(), std::min<size_t>(SCAN_CHUNK_SIZE, endAddr - next));
+                }
                 continue;
               }
-              
-              Address pointerAddr = addr + i;
-              auto* pointerAllData = new PointerAllData(
-                pointerAddr, 
-                value,
-                calculateStaticOffset(pointerAddr)
-              );
-              localCache.push_back(pointerAllData);
+
+              size_t count = reader->reap(completions, SCAN_PIPELINE_DEPTH);
+              for (size_t i = 0; i < count; ++i) {
+                const ReadCompletion& done = completions[i];
+                if (done.success) {
+                  scanBuffer(done.address, static_cast<const uint8_t*>(done.buffer), done.size);
+                } else {
+                  scanAdaptive(done.address, static_cast<uint8_t*>(done.buffer), done.size);
+                }
+                freeBuffers.push_back(static_cast<size_t>(done.tag));
+              }
             }
           }
-          
+
+          if (!failed.empty()) {
+            std::lock_guard<std::mutex> lock(failedRangesMutex_);
+            failedRanges_[region->startAddress] = std::move(failed);
+          }
+
           return localCache;
         }
       );
@@ -140,6 +292,11 @@ uint32_t PointerScanner::findPointers() {
           pointerCache_.insert(pointerCache_.end(), 
                               localCache.begin(), 
                               localCache.end());
+
+          // 超出内存预算后，已收集和后续收集的指针都写入磁盘缓存
+          if (useFileCache_ || (memoryBudget_ > 0 && pointerCache_.size() * POINTER_ENTRY_BYTES > memoryBudget_)) {
+            spillToFileCache();
+          }
         }
         
         completedRegions++;
@@ -160,95 +317,209 @@ uint32_t PointerScanner::findPointers() {
   std::cout << "扫描完成，耗时: " << scanDuration << " ms\n";
   std::cout << "开始排序指针...\n";
 
-  // 排序指针，便于后续二分查找
-  std::sort(pointerCache_.begin(), pointerCache_.end(),
-            [](PointerAllData *a, PointerAllData *b) {
-              return a->value < b->value;
-            });
+  size_t pointerCount = 0;
+  if (useFileCache_) {
+    // 磁盘缓存在结束写入时按值排序并建立范围索引
+    if (!fileCache_->endWriteCache()) {
+      std::cerr << "磁盘缓存排序失败\n";
+      return 0;
+    }
+    pointerCount = fileCache_->getCurrentLevelPointerCount();
+    cacheLevel_ = fileCache_->getLevel();
+  } else {
+    // 排序指针，便于后续二分查找
+    std::sort(pointerCache_.begin(), pointerCache_.end(),
+              [](PointerAllData *a, PointerAllData *b) {
+                return a->value < b->value;
+              });
+    pointerCount = pointerCache_.size();
+  }
   
   auto endTime = std::chrono::high_resolution_clock::now();
   auto totalDuration = std::chrono::duration_cast<std::chrono::milliseconds>(
     endTime - startTime).count();
 
   std::cout << "========== 扫描统计 ==========\n"
-            << "指针数量: " << pointerCache_.size() << "\n"
+            << "指针数量: " << pointerCount << "\n"
             << "内存使用: " << (pointerCache_.size() * sizeof(PointerAllData) / 1024 / 1024) << " MB\n"
+            << "磁盘缓存: " << (useFileCache_ ? "是" : "否") << "\n"
             << "扫描耗时: " << scanDuration << " ms\n"
             << "排序耗时: " << (totalDuration - scanDuration) << " ms\n"
             << "总耗时: " << totalDuration << " ms\n"
             << "==============================" << std::endl;
   
-  return static_cast<uint32_t>(pointerCache_.size());
+  return static_cast<uint32_t>(pointerCount);
 }
 
-void PointerScanner::scanRegionForPointers(Address startAddress, Address endAddress) {
+bool PointerScanner::savePointerTable(const std::string& path) {
+  if (pointerTable_) {
+    std::cerr << "指针表来自快照，无需重复保存\n";
+    return false;
+  }
+  if (useFileCache_ ? !cacheLevel_ : pointerCache_.empty()) {
+    std::cerr << "没有可保存的指针表，请先调用 findPointers\n";
+    return false;
+  }
 
+  auto startTime = std::chrono::high_resolution_clock::now();
 
-    std::vector<uint8_t> buffer(PAGE_SIZE);
-    std::error_code ec;
+  PointerTableWriter writer;
+  if (!writer.open(path, memoryAccess_->getTargetProcessId(), memoryMap_->getFingerprint(),
+                   memoryMap_->getFilteredRegions(), memoryMap_->getStaticRegions())) {
+    return false;
+  }
 
-    for (Address addr = startAddress; addr < endAddress; addr += PAGE_SIZE) {
-        size_t readSize = std::min<size_t>(PAGE_SIZE, endAddress - addr);
-        
-        // 读取内存块  todo 批量读取 process_vm_readv支持读取多页
-        if (!memoryAccess_->read(addr, buffer.data(), readSize, ec)) {
-            continue;  // 如果读取失败，跳过此块
-        }
-        
-        // 扫描可能的指针 (64位系统)
-        for (size_t i = 0; i < readSize; i += sizeof(Address)) {
-            if (i + sizeof(Address) > readSize) {
-                break;
-            }
-            
-            // 读取潜在的指针值
-            Address value = *reinterpret_cast<Address*>(buffer.data() + i);
+  bool success = true;
+  if (useFileCache_) {
+    // 磁盘缓存按块顺序解码即为按值有序
+    std::vector<PointerCacheEntry> entries;
+    for (size_t i = 0; i < cacheLevel_->blockCount() && success; ++i) {
+      entries.clear();
+      success = cacheLevel_->readBlock(i, entries);
+      for (const auto& entry : entries) {
+        const MemoryRegion* region = entry.offset ? staticRegionAt(entry.address) : nullptr;
+        success = success && writer.add(entry.address, entry.value, region);
+      }
+    }
+  } else {
+    for (const auto* ptr : pointerCache_) {
+      if (!writer.add(ptr->address, ptr->value, ptr->staticOffset_.region)) {
+        success = false;
+        break;
+      }
+    }
+  }
+
+  success = writer.close() && success;
+  if (!success) {
+    std::cerr << "保存指针表失败: " << path << "\n";
+    return false;
+  }
+
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::high_resolution_clock::now() - startTime).count();
+  std::cout << "指针表已保存到 " << path << "，共 " << writer.getPointerCount()
+            << " 个指针，耗时 " << duration << " ms\n";
+  return true;
+}
+
+bool PointerScanner::loadPointerTable(const std::string& path, bool allowStale) {
+  auto table = std::make_shared<PointerTableFile>();
+  if (!table->open(path)) {
+    return false;
+  }
+
+  const PointerTableHeader& header = table->getHeader();
+  long long age = static_cast<long long>(std::time(nullptr)) - static_cast<long long>(header.timestamp);
+  std::cout << "指针表快照: " << table->size() << " 个指针，PID " << header.pid
+            << "，保存于 " << age << " 秒前\n";
+
+  // PID 或内存映射变化说明快照已过期：指针值和静态区域都可能不同
+  bool stale = false;
+  if (header.pid != memoryAccess_->getTargetProcessId()) {
+    std::cerr << "快照 PID " << header.pid << " 与当前进程 " << memoryAccess_->getTargetProcessId() << " 不同\n";
+    stale = true;
+  }
+  if (header.mapsFingerprint != memoryMap_->getFingerprint()) {
+    size_t missing = 0;
+    for (const auto& region : table->getRegions()) {
+      if (!(region.flags & PointerTableWriter::REGION_STATIC)) {
+        continue;
+      }
+      RegionId id = memoryMap_->findRegionId(region.startAddress);
+      const MemoryRegion* live = memoryMap_->getRegion(id);
+      bool found = memoryMap_->isStaticRegion(id) && live->startAddress == region.startAddress &&
+                   live->endAddress == region.endAddress &&
+                   strncmp(live->name, region.name, sizeof(region.name)) == 0;
+      missing += found ? 0 : 1;
+    }
+    std::cerr << "快照之后内存映射已变化（" << missing << " 个静态区域不再存在）\n";
+    stale = true;
+  }
+  if (stale && !allowStale) {
+    std::cerr << "快照已过期，拒绝加载: " << path << "\n";
+    return false;
+  }
+
+  resetPointerTable();
+  pointerTable_ = table;
+  return true;
+}
+
+void PointerScanner::spillToFileCache() {
+  if (!useFileCache_) {
+    fileCache_ = std::make_shared<FileCache>();
+    if (!fileCache_->initialize(cacheDir_) || !fileCache_->beginWriteCache(0)) {
+      std::cerr << "无法创建磁盘缓存，继续使用内存指针表\n";
+      fileCache_.reset();
+      memoryBudget_ = 0;
+      return;
+    }
+    // 外部排序同样受内存预算限制
+    fileCache_->setSortMemoryLimit(memoryBudget_);
+    useFileCache_.store(true, std::memory_order_release);
+    std::cout << "指针表超出内存预算 " << (memoryBudget_ / 1024 / 1024)
+              << " MB，改为写入磁盘缓存\n";
+  }
+
+  // offset 字段记录是否为静态指针，查询时只为静态指针重新计算静态偏移
+  for (auto* ptr : pointerCache_) {
+    fileCache_->addPointerToCache(ptr->address, ptr->value, ptr->staticOffset_.region ? 1 : 0);
+    delete ptr;
+  }
+  pointerCache_.clear();
+  pointerCache_.shrink_to_fit();
+}
+
+void PointerScanner::scanRegionForPointers(Address startAddress, Address endAddress) {
+    std::vector<uint8_t> buffer(std::min<size_t>(SCAN_CHUNK_SIZE, endAddress - startAddress));
+    FailedRangeSet& failed = failedRanges_[startAddress];
 
-            if (!isValidAddress(value))
-            {
+    // 按块自适应读取，块内不可读的页填0
+    for (Address chunk = startAddress; chunk < endAddress; chunk += SCAN_CHUNK_SIZE) {
+        size_t chunkSize = std::min<size_t>(SCAN_CHUNK_SIZE, endAddress - chunk);
+        memoryAccess_->readAdaptive(chunk, buffer.data(), chunkSize, failed);
+
+        for (size_t pageOffset = 0; pageOffset < chunkSize; pageOffset += PAGE_SIZE) {
+            Address addr = chunk + pageOffset;
+            size_t readSize = std::min<size_t>(PAGE_SIZE, chunkSize - pageOffset);
+
+            if (memoryAccess_->isKnownZeroPage(addr)) {
                 continue;
             }
-            
-            {
+
+            // 扫描可能的指针 (64位系统)
+            for (size_t i = 0; i + sizeof(Address) <= readSize; i += sizeof(Address)) {
+                // 读取潜在的指针值
+                Address value;
+                memcpy(&value, buffer.data() + pageOffset + i, sizeof(value));
+
+                if (!isValidAddress(value))
+                {
+                    continue;
+                }
+
                 Address pointerAddr = addr + i;
                 auto* pointerallData = new PointerAllData(
                                                 pointerAddr, 
                                             value,
                                             calculateStaticOffset(pointerAddr));
                 pointerCache_.push_back(pointerallData);
-                   
-                    //TODO 保存到临时文件
-                    //扫描潜在指针完成 指针数量: 19711086 内存使用: 451 MB
-                    //试了一个大型游戏 ，扫一遍也就占用几百mb ，直接内存
-                    //后续构建树节点 内存炸了 将节点保存到文件
-                
             }
-        }//for readSize
-    }//for startAddress
-
+        }
+    }
 }
 
 // 判断地址是否在静态区域内
-StaticOffset* PointerScanner::calculateStaticOffset(Address addr) {
-  static  StaticOffset nullStaticOffset = StaticOffset(0, nullptr);
-    // 遍历所有静态区域
-    for ( auto* region : staticRegionList) {
-        // 检查地址是否落在这个区域内
-        if (addr >= region->startAddress && addr < region->endAddress) {
-            return new StaticOffset(addr - region->startAddress, region);
-        }
-    }
-     
-    //二分查找
-    // auto it = std::lower_bound(staticRegionList.begin(), staticRegionList.end(), addr,
-    //                           [](const MemoryRegion* region, Address addr) {
-    //                               return region->startAddress < addr;
-    //                           });
-    // if(it != staticRegionList.end())
-    // {
-    //     return StaticOffset(addr - (*it)->startAddress, *it);
-    // }
-    return &nullStaticOffset;
+const MemoryRegion* PointerScanner::staticRegionAt(Address addr) const {
+    RegionId id = memoryMap_->findRegionId(addr);
+    return memoryMap_->isStaticRegion(id) ? memoryMap_->getRegion(id) : nullptr;
+}
+
+StaticOffset PointerScanner::calculateStaticOffset(Address addr) const {
+    // 在区域表中二分查找，再按编号判断是否为静态区域；结果按值保存在指针数据中，不加锁
+    const MemoryRegion* region = staticRegionAt(addr);
+    return region ? StaticOffset(addr - region->baseAddress(), region) : StaticOffset();
 }
 
 
@@ -260,21 +531,21 @@ void PointerScanner::Search1Pointers(
   uint64_t endAddr = BaseAddr;
   printf("第0层查找范围: %lx - %lx\n", (unsigned long)startAddr, (unsigned long)endAddr);
   
-  // 使用哈希索引查找（O(1) 查找性能）
-  auto foundPointers = findPointersInRange(startAddr, endAddr);
+  // 第0层节点在整个扫描期间引用 level0Pointers_ 中的数据
+  level0Pointers_ = findPointersInRange(startAddr, endAddr);
 
   PointerRange ranges;
   
-  if (!foundPointers.empty()) {
+  if (!level0Pointers_.empty()) {
     std::vector<PointerDir> regionResults;
-    regionResults.reserve(foundPointers.size());
+    regionResults.reserve(level0Pointers_.size());
     
     // 处理找到的所有指针
-    for (auto* pointerData : foundPointers) {
+    for (auto& pointerData : level0Pointers_) {
       // 为每个指针创建PointerDir并初始化新字段
-      Offset offset = static_cast<Offset>(BaseAddr - pointerData->value);
+      Offset offset = static_cast<Offset>(BaseAddr - pointerData.value);
       
-      PointerDir dir(pointerData, offset);
+      PointerDir dir(&pointerData, offset);
       // 第一层的父节点置为空，链在目标地址结束
       dir.child = nullptr;
       regionResults.push_back(std::move(dir));
@@ -312,6 +583,7 @@ int PointerScanner::scanPointerChain(Address &targetAddress,
   PointerFormatter formatter;  // 统一构造一次，避免重复创建
   
   if (enableStreamOutput) {
+    formatter.setCompression(options.outputCompression);
     if (!formatter.initOutputFile(outputFile)) {
       printf("警告: 无法初始化输出文件 %s，将在扫描结束后统一输出\n", outputFile.c_str());
       enableStreamOutput = false;
@@ -341,6 +613,12 @@ int PointerScanner::scanPointerChain(Address &targetAddress,
   std::atomic<size_t> totalChainsFound{0};
   std::atomic<size_t> totalNodesProcessed{0};
   std::atomic<size_t> processedLevel0Branches{0};
+
+  // 指针链去重（签名相同的链只输出一次）
+  std::unique_ptr<ChainDeduplicator> deduplicator;
+  if (options.dedupChains) {
+    deduplicator = std::make_unique<ChainDeduplicator>(options.dedupMemoryLimit);
+  }
   
   // 批量写入缓冲区
   std::vector<std::list<PointerChainNode>> writeBuffer;
@@ -385,12 +663,27 @@ int PointerScanner::scanPointerChain(Address &targetAddress,
         }
 
         // 如果当前节点是静态指针，立即构建完整指针链
-        if (currentNode->Data->staticOffset_->staticOffset > 0) {
+        if (currentNode->Data->staticOffset_.staticOffset > 0) {
           // 先检查是否已达到限制，避免构建不必要的链
           if (options.limitResults && resultLimitReached.load(std::memory_order_relaxed)) {
             return;
           }
           
+          // 去重：相同 (区域, 静态偏移, 偏移序列) 的链只保留第一条
+          if (deduplicator) {
+            thread_local std::vector<Offset> sigOffsets;
+            sigOffsets.clear();
+            for (PointerDir *node = currentNode; node != nullptr; node = node->child) {
+              sigOffsets.push_back(node->offset);
+            }
+            const StaticOffset& so = currentNode->Data->staticOffset_;
+            ChainSignature sig = ChainDeduplicator::computeSignature(
+                so.region ? so.region->name : "", so.staticOffset, sigOffsets.data(), sigOffsets.size());
+            if (!deduplicator->insert(sig)) {
+              return; // 重复链，不进入写出缓冲区
+            }
+          }
+
           // 构建完整指针链（从静态地址到目标地址）
           std::list<PointerChainNode> chain;
 
@@ -435,7 +728,7 @@ int PointerScanner::scanPointerChain(Address &targetAddress,
         Address startAddr = baseAddr - options.maxOffset;
         Address endAddr = baseAddr;
 
-        // 使用二分查找可能的父指针
+        // 查找可能的父指针（结果为值拷贝，下层递归期间保持有效）
         auto parentPointers = findPointersInRange(startAddr, endAddr);
 
         if (parentPointers.empty()) {
@@ -446,17 +739,17 @@ int PointerScanner::scanPointerChain(Address &targetAddress,
         totalNodesProcessed.fetch_add(parentPointers.size(), std::memory_order_relaxed);
 
         // 遍历所有可能的父指针，递归搜索
-        for (auto* parentPointer : parentPointers) {
+        for (auto& parentPointer : parentPointers) {
           // 检查是否需要提前终止
           if (options.limitResults && resultLimitReached.load(std::memory_order_relaxed)) {
             break;
           }
 
           // 计算偏移量
-          Offset offset = static_cast<Offset>(baseAddr - parentPointer->value);
+          Offset offset = static_cast<Offset>(baseAddr - parentPointer.value);
 
           // 创建临时节点（不分配堆内存，使用栈内存）
-          PointerDir tempNode(parentPointer, offset);
+          PointerDir tempNode(&parentPointer, offset);
           tempNode.child = currentNode;
 
           // 递归搜索下一层
@@ -554,6 +847,9 @@ int PointerScanner::scanPointerChain(Address &targetAddress,
       printf("正在写入剩余的 %zu 条指针链...\n", writeBuffer.size());
       flushWriteBuffer();
     }
+    if (!formatter.closeOutputFile()) {
+      printf("警告: 关闭输出文件失败\n");
+    }
   }
 
   // 获取最终统计值
@@ -563,6 +859,12 @@ int PointerScanner::scanPointerChain(Address &targetAddress,
   printf("========== 指针链扫描完成 ==========\n");
   printf("找到有效指针链: %zu 条\n", finalChainCount);
   printf("处理节点总数: %zu\n", finalNodeCount);
+  if (deduplicator) {
+    printf("重复指针链(已丢弃): %zu 条\n", deduplicator->getDuplicateCount());
+    if (deduplicator->getSpilledCount() > 0) {
+      printf("去重签名溢出到磁盘: %zu 个\n", deduplicator->getSpilledCount());
+    }
+  }
   printf("扫描耗时: %lld ms\n", duration);
 
   if (enableStreamOutput) {
@@ -576,8 +878,41 @@ int PointerScanner::scanPointerChain(Address &targetAddress,
 }
 
 // 使用二分查找在排序的 pointerCache_ 中查找指向指定地址范围的所有指针
-std::vector<PointerAllData*> PointerScanner::findPointersInRange(Address startAddr, Address endAddr) const {
-    std::vector<PointerAllData*> result;
+std::vector<PointerAllData> PointerScanner::findPointersInRange(Address startAddr, Address endAddr) {
+    std::vector<PointerAllData> result;
+
+    // 指针表来自快照时，直接在映射的有序表中二分查找
+    if (pointerTable_) {
+        auto range = pointerTable_->findRange(startAddr, endAddr);
+        result.reserve(static_cast<size_t>(range.second - range.first));
+        for (auto it = range.first; it != range.second; ++it) {
+            result.emplace_back(it->address, it->value,
+                                it->staticRegion ? calculateStaticOffset(it->address) : StaticOffset());
+        }
+        return result;
+    }
+
+    // 指针表在磁盘缓存中时，通过范围索引查询
+    if (useFileCache_) {
+        if (!cacheLevel_) {
+            return result;
+        }
+
+        auto appendEntry = [&](const PointerCacheEntry& entry) {
+            result.emplace_back(entry.address, entry.value,
+                                entry.offset ? calculateStaticOffset(entry.address) : StaticOffset());
+        };
+
+        // 只读等级可被所有搜索线程并发查询，只解码与范围相交的压缩块
+        thread_local std::vector<PointerCacheEntry> entries;
+        entries.clear();
+        cacheLevel_->find(startAddr, endAddr, entries);
+        result.reserve(entries.size());
+        for (const auto& entry : entries) {
+            appendEntry(entry);
+        }
+        return result;
+    }
     
     // 二分查找范围的起始位置
     auto startIt = std::lower_bound(pointerCache_.begin(), pointerCache_.end(), startAddr,
@@ -594,7 +929,7 @@ std::vector<PointerAllData*> PointerScanner::findPointersInRange(Address startAd
     // 收集范围内的所有指针
     if (startIt != pointerCache_.end() && startIt <= endIt && (*startIt)->value <= endAddr) {
         for (auto it = startIt; it != pointerCache_.end() && it <= endIt && (*it)->value <= endAddr; ++it) {
-            result.push_back(*it);
+            result.push_back(**it);
         }
     }
     